@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    CompressorBatch.cpp
+    Created: 17 Oct 2026 10:14:52am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "CompressorBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CompressorBatch::prepare(double sampleRate, int newNumInstances) {
+    prepareChannels(sampleRate, 2*std::max(0, newNumInstances), 2);
+}
+
+void CompressorBatch::prepareChannels(double sampleRate, int newNumChannels, int channelsPerInstance) {
+    newNumChannels = std::max(0, newNumChannels);
+    channelsPerInstance = std::max(1, channelsPerInstance);
+    const int newNumInstances = (newNumChannels + channelsPerInstance - 1)/channelsPerInstance;
+    layOut(sampleRate, newNumInstances, [newNumChannels, channelsPerInstance] (int i) {
+        return std::min(channelsPerInstance, newNumChannels - i*channelsPerInstance);
+    });
+}
+
+void CompressorBatch::prepareInstances(double sampleRate, int newNumInstances, const int* instanceChannels) {
+    layOut(sampleRate, std::max(0, newNumInstances), [instanceChannels] (int i) {
+        return std::max(1, instanceChannels[i]);
+    });
+}
+
+// numInstances instances, instance i on channelsOf(i) channels following
+// the previous instance's
+template <typename ChannelsOf>
+void CompressorBatch::layOut(double sampleRate, int newNumInstances, ChannelsOf channelsOf) {
+    fs = sampleRate;
+    rampLength = std::max(1, (int) (rampTime*fs));
+
+    numInstances = newNumInstances;
+    numGroups = (numInstances + lanes - 1)/lanes;
+    if (numGroups > (int) groups.size()) {
+        const int oldGroups = (int) groups.size();
+        groups.resize(numGroups);
+        for (int g = oldGroups; g < numGroups; g++) {
+            for (int k = 0; k < lanes; k++)
+                for (int p = 0; p < numBatchParameters; p++)
+                    groups[g].parameters[k][p] = CompressorEngine::getParameterDefault((CompressorEngine::Parameter) p);
+        }
+    }
+
+    numChannels = 0;
+    for (int g = 0; g < numGroups; g++) {
+        Group& group = groups[g];
+        CompressorKernel::BatchCoeffs& c = group.coeffs;
+        c.numLanes = std::min(lanes, numInstances - g*lanes);
+        group.firstChannel = numChannels;
+        for (int k = 0; k < c.numLanes; k++) {
+            c.laneChannels[k] = channelsOf(g*lanes + k);
+            numChannels += c.laneChannels[k];
+        }
+        group.numChannels = numChannels - group.firstChannel;
+        calcAlgorithmParams(group, true);
+    }
+    if (numChannels > (int) segment.size()) {
+        segment.resize(numChannels);
+        segmentDouble.resize(numChannels);
+    }
+}
+
+void CompressorBatch::reset() {
+    for (int g = 0; g < numGroups; g++) {
+        groups[g].state = CompressorKernel::BatchState();
+        calcAlgorithmParams(groups[g], true);
+    }
+}
+
+void CompressorBatch::setParameter(int instance, CompressorEngine::Parameter param, float value) {
+    if (instance < 0 || instance >= numInstances || !isBatchParameter(param))
+        return;
+    value = std::min(std::max(value, CompressorEngine::getParameterMin(param)),
+                     CompressorEngine::getParameterMax(param));
+    Group& group = groups[instance/lanes];
+    const int k = instance%lanes;
+    if (value != group.parameters[k][param]) {
+        group.parameters[k][param] = value;
+        group.parametersChanged[k] = true;
+        group.anyChanged = true;
+    }
+}
+
+float CompressorBatch::getParameter(int instance, CompressorEngine::Parameter param) const {
+    if (instance < 0 || instance >= numInstances || !isBatchParameter(param))
+        return CompressorEngine::getParameterDefault(param);
+    return groups[instance/lanes].parameters[instance%lanes][param];
+}
+
+float CompressorBatch::getRmsEnvelopeDb(int instance) const {
+    if (instance < 0 || instance >= numInstances)
+        return -200;
+    return groups[instance/lanes].state.rmsEnvelopeDb[instance%lanes];
+}
+
+float CompressorBatch::getGainOutLinear(int instance) const {
+    if (instance < 0 || instance >= numInstances)
+        return 1;
+    return groups[instance/lanes].state.gainOutLinear[instance%lanes];
+}
+
+float CompressorBatch::getMinGainLinear(int instance) const {
+    if (instance < 0 || instance >= numInstances)
+        return 1;
+    return groups[instance/lanes].state.minGainLinear[instance%lanes];
+}
+
+float CompressorBatch::getMaxGainLinear(int instance) const {
+    if (instance < 0 || instance >= numInstances)
+        return 1;
+    return groups[instance/lanes].state.maxGainLinear[instance%lanes];
+}
+
+//==============================================================================
+void CompressorBatch::calcAlgorithmParams(Group& group, bool jumpToTargets) {
+    CompressorKernel::BatchCoeffs& c = group.coeffs;
+    c.envB0 = 1 - exp(-1/(envTau*fs));
+
+    // only the lanes that changed start a ramp, the others carry on
+    for (int k = 0; k < lanes; k++) {
+        if (!jumpToTargets && !group.parametersChanged[k])
+            continue;
+        const float* p = group.parameters[k];
+        c.attackCoeff[k] = 1.0 - exp(-1.0/(p[CompressorEngine::attack]*fs/1000.0));
+        c.releaseCoeff[k] = 1.0 - exp(-1.0/(p[CompressorEngine::release]*fs/1000.0));
+
+        group.rampTarget[preGainValue][k] = pow(10,p[CompressorEngine::preGain]/20.0);
+        group.rampTarget[postGainValue][k] = pow(10,p[CompressorEngine::postGain]/20.0);
+        group.rampTarget[thresholdValue][k] = p[CompressorEngine::threshold];
+        group.rampTarget[ratioValue][k] = p[CompressorEngine::ratio];
+
+        // every ramp starts again from where it is now
+        const float* current[numRampedValues] = { c.preGainLinear, c.postGainLinear, c.thresholdDb, c.ratio };
+        for (int v = 0; v < numRampedValues; v++)
+            group.rampStart[v][k] = jumpToTargets ? group.rampTarget[v][k] : current[v][k];
+        group.rampSamplesLeft[k] = jumpToTargets ? 0 : rampLength;
+        group.parametersChanged[k] = false;
+    }
+    group.anyChanged = false;
+    updateRamps(group);
+}
+
+void CompressorBatch::updateRamps(Group& group) {
+    CompressorKernel::BatchCoeffs& c = group.coeffs;
+    float* values[numRampedValues] = { c.preGainLinear, c.postGainLinear, c.thresholdDb, c.ratio };
+    float* steps[numRampedValues] = { c.preGainStep, c.postGainStep, c.thresholdStep, c.ratioStep };
+    for (int k = 0; k < lanes; k++) {
+        const int samplesLeft = group.rampSamplesLeft[k];
+        const int position = rampLength - samplesLeft;
+        for (int v = 0; v < numRampedValues; v++) {
+            const float start = group.rampStart[v][k];
+            const float target = group.rampTarget[v][k];
+            steps[v][k] = samplesLeft > 0 ? (target - start)/rampLength : 0;
+            values[v][k] = samplesLeft > 0 ? start + position*steps[v][k] : target;
+        }
+    }
+}
+
+void CompressorBatch::process(float* const* channels, int numSamples) {
+    process(nullptr, 0, channels, numSamples);
+}
+
+void CompressorBatch::process(const float* const* keyChannels, int numKeyChannels,
+                              float* const* channels, int numSamples) {
+    processSamples(keyChannels, numKeyChannels, channels, numSamples);
+}
+
+void CompressorBatch::process(double* const* channels, int numSamples) {
+    process(nullptr, 0, channels, numSamples);
+}
+
+void CompressorBatch::process(const double* const* keyChannels, int numKeyChannels,
+                              double* const* channels, int numSamples) {
+    processSamples(keyChannels, numKeyChannels, channels, numSamples);
+}
+
+template <typename Sample>
+void CompressorBatch::processSamples(const Sample* const* keyChannels, int numKeyChannels,
+                                     Sample* const* channels, int numSamples) {
+    numKeyChannels = std::min(numKeyChannels, 2);
+    const Sample* keySegment[2] = {};
+    Sample** channelSegment = segmentFor(channels);
+    for (int g = 0; g < numGroups; g++) {
+        Group& group = groups[g];
+        Sample* const* groupChannels = channels + group.firstChannel;
+        if (group.anyChanged)
+            calcAlgorithmParams(group, false);
+        for (int k = 0; k < lanes; k++)
+            group.state.minGainLinear[k] = group.state.maxGainLinear[k] = (float) group.state.gainOutLinear[k];
+
+        // up to the end of the block or of the next ramp to finish
+        for (int done = 0; done < numSamples;) {
+            int n = numSamples - done;
+            for (int k = 0; k < lanes; k++)
+                if (group.rampSamplesLeft[k] > 0)
+                    n = std::min(n, group.rampSamplesLeft[k]);
+
+            for (int ch = 0; ch < group.numChannels; ch++)
+                channelSegment[ch] = groupChannels[ch] + done;
+            for (int ch = 0; ch < numKeyChannels; ch++)
+                keySegment[ch] = keyChannels[ch] + done;
+            CompressorKernel::processBatch(keySegment, numKeyChannels, channelSegment, n,
+                                           group.coeffs, group.state);
+            done += n;
+
+            bool ramping = false;
+            for (int k = 0; k < lanes; k++) {
+                if (group.rampSamplesLeft[k] > 0) {
+                    group.rampSamplesLeft[k] -= n;
+                    ramping = true;
+                }
+            }
+            if (ramping)
+                updateRamps(group);
+        }
+    }
+}
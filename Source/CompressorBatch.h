@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    CompressorBatch.h
+    Created: 17 Oct 2026 10:14:52am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "CompressorEngine.h"
+#include "CompressorKernel.h"
+
+#include <vector>
+
+//==============================================================================
+/**
+ Many independent stereo compressors run together, e.g. one per channel
+ strip of a mixer, or one per voice. Instances are packed
+ CompressorKernel::batchLanes to a group with their coefficients and
+ state side by side, and each group is processed by one pass of
+ CompressorKernel::processBatch, an instance per vector lane.
+
+ An instance can also take another number of channels (prepareChannels,
+ prepareInstances), with its detector linked across them: the channels of
+ a surround or ambisonic bed compressed one by one, in pairs or all
+ linked as one.
+
+ Each instance has its own threshold, ratio, attack, release, pre and
+ post gain, and is the single band CompressorEngine with those settings:
+ the same detector, gain computer and 20 ms parameter glides. Lookahead,
+ the true peak detector, multiband and the key filter are not available
+ here; the gain computer is always worked out rather than looked up, so
+ an instance matches the engine to the GainTable's accuracy (see
+ CompressorKernel.h) and matches CompressorKernel::processStereo bit for
+ bit.
+
+ Only the prepares allocate, and only for more instances or channels than
+ any prepare before, so going back to a layout that was used already can
+ be done on the audio thread. Like CompressorEngine, set parameters and
+ process from the same thread.
+*/
+class CompressorBatch
+{
+public:
+    CompressorBatch() = default;
+
+    // numInstances stereo compressors, their settings kept from before
+    // where they already existed
+    void prepare(double sampleRate, int numInstances);
+
+    // numChannels channels in consecutive groups of channelsPerInstance,
+    // a compressor per group (the last one takes the channels left over),
+    // settings kept as above. E.g. 1 per channel, 2 in pairs, numChannels
+    // all linked
+    void prepareChannels(double sampleRate, int numChannels, int channelsPerInstance);
+
+    // numInstances compressors, each on the next instanceChannels[i]
+    // channels, e.g. a bed's left/right pairs and lone channels mixed
+    void prepareInstances(double sampleRate, int numInstances, const int* instanceChannels);
+
+    // clears the detector and gain memory and ends any glide: settings
+    // changed since the last process() take effect at once
+    void reset();
+
+    int getNumInstances() const { return numInstances; }
+    int getNumChannels() const { return numChannels; }
+
+    // threshold .. postGain, the others don't apply to a batch
+    static bool isBatchParameter(CompressorEngine::Parameter param) { return param <= CompressorEngine::postGain; }
+
+    // clamped like CompressorEngine::setParameter, taking effect (with a
+    // ramp) at the start of the next process() call. Other parameters and
+    // instances out of range are ignored
+    void setParameter(int instance, CompressorEngine::Parameter param, float value);
+    float getParameter(int instance, CompressorEngine::Parameter param) const;
+
+    // processes every instance in place, each on its channels in order:
+    // stereo instances on channels[2k] (left) and channels[2k + 1] (right)
+    void process(float* const* channels, int numSamples);
+
+    // same, but every instance's detector listens to numKeyChannels (1 or
+    // 2) key channels instead, e.g. a plugin's sidechain
+    void process(const float* const* keyChannels, int numKeyChannels, float* const* channels, int numSamples);
+
+    // double precision audio, the detectors hear a float copy and the gains
+    // are applied in double, as in CompressorEngine
+    void process(double* const* channels, int numSamples);
+    void process(const double* const* keyChannels, int numKeyChannels, double* const* channels, int numSamples);
+
+    float getRmsEnvelopeDb(int instance) const;
+    float getGainOutLinear(int instance) const;
+
+    // the most and least gain reduction over the last process() call
+    float getMinGainLinear(int instance) const;
+    float getMaxGainLinear(int instance) const;
+
+private:
+    static constexpr int lanes = CompressorKernel::batchLanes;
+    static constexpr int numBatchParameters = CompressorEngine::postGain + 1;
+
+    // what glides after a change, as in CompressorEngine
+    enum RampedValue { preGainValue, postGainValue, thresholdValue, ratioValue, numRampedValues };
+
+    // a group of instances, one per lane of CompressorKernel::processBatch
+    struct Group {
+        CompressorKernel::BatchCoeffs coeffs;
+        CompressorKernel::BatchState state;
+        float parameters[lanes][numBatchParameters];
+        bool parametersChanged[lanes] = {};
+        bool anyChanged = false;
+
+        // per lane glide from start to target, its values and steps
+        // written into coeffs as it goes (see updateRamps)
+        float rampStart[numRampedValues][lanes] = {};
+        float rampTarget[numRampedValues][lanes] = {};
+        int rampSamplesLeft[lanes] = {};
+
+        // where its lanes' channels are among the ones process() is given
+        int firstChannel = 0;
+        int numChannels = 0;
+    };
+
+    // groups in use, the vector keeps the ones a smaller layout left idle
+    std::vector<Group> groups;
+    int numGroups = 0;
+    int numInstances = 0;
+    int numChannels = 0;
+    std::vector<float*> segment; // the channels from where a ramp ends
+    std::vector<double*> segmentDouble;
+    float** segmentFor(float* const*) { return segment.data(); }
+    double** segmentFor(double* const*) { return segmentDouble.data(); }
+
+    float fs = 44100;       // sampling rate
+    float envTau = 0.01;    // integration time in sec for RMS env follower
+    float rampTime = 0.02;  // glide time in sec after a parameter change
+    int rampLength = 1;
+
+    template <typename ChannelsOf>
+    void layOut(double sampleRate, int numInstances, ChannelsOf channelsOf);
+    void calcAlgorithmParams(Group& group, bool jumpToTargets);
+    void updateRamps(Group& group);
+    template <typename Sample>
+    void processSamples(const Sample* const* keyChannels, int numKeyChannels, Sample* const* channels, int numSamples);
+};
@@ -0,0 +1,852 @@
+/*
+  ==============================================================================
+
+    CompressorEngine.cpp
+    Created: 16 Oct 2026 2:05:11pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "CompressorEngine.h"
+#include "defines.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+    struct ParameterInfo {
+        const char* id; // the plugin's parameter ID
+        float min;
+        float max;
+        float def;
+    };
+
+    const ParameterInfo parameterInfos[CompressorEngine::numParameters] = {
+        { "threshold",      THRESH_MIN,   THRESH_MAX,     THRESH_DEFAULT },
+        { "ratio",          RATIO_MIN,    RATIO_MAX,      RATIO_DEFAULT },
+        { "attack",         ATTACK_MIN,   ATTACK_MAX,     ATTACK_DEFAULT },
+        { "release",        RELEASE_MIN,  RELEASE_MAX,    RELEASE_DEFAULT },
+        { "preGain",        GAIN_MIN,     GAIN_MAX,       GAIN_DEFAULT },
+        { "postGain",       GAIN_MIN,     GAIN_MAX,       GAIN_DEFAULT },
+        { "lookahead",      LOOKAHEAD_MIN, LOOKAHEAD_MAX, LOOKAHEAD_DEFAULT },
+        { "truePeak",       TRUE_PEAK_MIN, TRUE_PEAK_MAX, TRUE_PEAK_DEFAULT },
+        { "numBands",       BANDS_MIN,    BANDS_MAX,      BANDS_DEFAULT },
+        { "crossover1",     CROSSOVER_MIN, CROSSOVER_MAX, CROSSOVER1_DEFAULT },
+        { "crossover2",     CROSSOVER_MIN, CROSSOVER_MAX, CROSSOVER2_DEFAULT },
+        { "crossover3",     CROSSOVER_MIN, CROSSOVER_MAX, CROSSOVER3_DEFAULT },
+        { "crossover4",     CROSSOVER_MIN, CROSSOVER_MAX, CROSSOVER4_DEFAULT },
+        { "band2Threshold", THRESH_MIN,   THRESH_MAX,     THRESH_DEFAULT },   // band 2
+        { "band2Ratio",     RATIO_MIN,    RATIO_MAX,      RATIO_DEFAULT },
+        { "band2Attack",    ATTACK_MIN,   ATTACK_MAX,     ATTACK_DEFAULT },
+        { "band2Release",   RELEASE_MIN,  RELEASE_MAX,    RELEASE_DEFAULT },
+        { "band3Threshold", THRESH_MIN,   THRESH_MAX,     THRESH_DEFAULT },   // band 3
+        { "band3Ratio",     RATIO_MIN,    RATIO_MAX,      RATIO_DEFAULT },
+        { "band3Attack",    ATTACK_MIN,   ATTACK_MAX,     ATTACK_DEFAULT },
+        { "band3Release",   RELEASE_MIN,  RELEASE_MAX,    RELEASE_DEFAULT },
+        { "band4Threshold", THRESH_MIN,   THRESH_MAX,     THRESH_DEFAULT },   // band 4
+        { "band4Ratio",     RATIO_MIN,    RATIO_MAX,      RATIO_DEFAULT },
+        { "band4Attack",    ATTACK_MIN,   ATTACK_MAX,     ATTACK_DEFAULT },
+        { "band4Release",   RELEASE_MIN,  RELEASE_MAX,    RELEASE_DEFAULT },
+        { "band5Threshold", THRESH_MIN,   THRESH_MAX,     THRESH_DEFAULT },   // band 5
+        { "band5Ratio",     RATIO_MIN,    RATIO_MAX,      RATIO_DEFAULT },
+        { "band5Attack",    ATTACK_MIN,   ATTACK_MAX,     ATTACK_DEFAULT },
+        { "band5Release",   RELEASE_MIN,  RELEASE_MAX,    RELEASE_DEFAULT },
+        { "keyFilter",      KEY_FILTER_MIN, KEY_FILTER_MAX, KEY_FILTER_DEFAULT },
+        { "keyLowCut",      KEY_CUT_MIN,  KEY_CUT_MAX,    KEY_LOW_CUT_DEFAULT },
+        { "keyHighCut",     KEY_CUT_MIN,  KEY_CUT_MAX,    KEY_HIGH_CUT_DEFAULT },
+        { "channelLink",    LINK_MIN,     LINK_MAX,       LINK_DEFAULT },
+        { "ecoInterval",    ECO_MIN,      ECO_MAX,        ECO_DEFAULT }
+    };
+
+    // the detector always listens to float: float keys are read where they
+    // are, double ones are converted into buffer
+    const float* toFloatKey(const float* key, float*, int) {
+        return key;
+    }
+
+    const float* toFloatKey(const double* key, float* buffer, int numSamples) {
+        std::copy(key, key + numSamples, buffer);
+        return buffer;
+    }
+
+    // transposed direct form II biquad, a0 normalised to 1
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    // RBJ cookbook low/high/all pass, by default at Q = 1/sqrt(2): two
+    // Butterworth low or high passes in a row make a 4th order
+    // Linkwitz-Riley, and the all pass has the same phase as their sum
+    enum class FilterType { lowPass, highPass, allPass };
+
+    Biquad designBiquad(FilterType type, double frequency, double sampleRate,
+                        double q = 0.70710678118654752) {
+        const double w0 = 2*3.14159265358979323846*frequency/sampleRate;
+        const double cosW0 = std::cos(w0);
+        const double alpha = std::sin(w0)/(2*q);
+        const double a0 = 1 + alpha;
+        double b0, b1, b2;
+        switch (type) {
+            case FilterType::lowPass:
+                b0 = b2 = (1 - cosW0)/2;
+                b1 = 1 - cosW0;
+                break;
+            case FilterType::highPass:
+                b0 = b2 = (1 + cosW0)/2;
+                b1 = -(1 + cosW0);
+                break;
+            default:
+                b0 = 1 - alpha;
+                b1 = -2*cosW0;
+                b2 = 1 + alpha;
+                break;
+        }
+        return { b0/a0, b1/a0, b2/a0, -2*cosW0/a0, (1 - alpha)/a0 };
+    }
+
+    const Biquad bypass { 1, 0, 0, 0, 0 };
+
+    // one crossover section of a band, in the audio's precision
+    template <typename Sample>
+    void setBandStage(CompressorKernel::BandCoeffs<Sample>& c, int stage, int band, const Biquad& q) {
+        c.b0[stage][band] = (Sample) q.b0;
+        c.b1[stage][band] = (Sample) q.b1;
+        c.b2[stage][band] = (Sample) q.b2;
+        c.a1[stage][band] = (Sample) q.a1;
+        c.a2[stage][band] = (Sample) q.a2;
+    }
+
+    // carries the bands over when the host switches precision
+    template <typename From, typename To>
+    void copyBandState(const CompressorKernel::BandState<From>& from, CompressorKernel::BandState<To>& to) {
+        using namespace CompressorKernel;
+        std::copy(from.envOut, from.envOut + bandLanes, to.envOut);
+        std::copy(from.gainOutLinear, from.gainOutLinear + bandLanes, to.gainOutLinear);
+        std::copy(from.minGainLinear, from.minGainLinear + bandLanes, to.minGainLinear);
+        std::copy(from.maxGainLinear, from.maxGainLinear + bandLanes, to.maxGainLinear);
+        const int numZ = 2*maxCrossoverStages*bandLanes;
+        std::copy(&from.z1[0][0][0], &from.z1[0][0][0] + numZ, &to.z1[0][0][0]);
+        std::copy(&from.z2[0][0][0], &from.z2[0][0][0] + numZ, &to.z2[0][0][0]);
+        std::copy(&from.keyZ1[0][0][0], &from.keyZ1[0][0][0] + numZ, &to.keyZ1[0][0][0]);
+        std::copy(&from.keyZ2[0][0][0], &from.keyZ2[0][0][0] + numZ, &to.keyZ2[0][0][0]);
+    }
+
+    // section Qs of a 4th order Butterworth
+    const double butterworthQs[2] = { 0.54119610014619698, 1.3065629648763766 };
+}
+
+CompressorEngine::CompressorEngine() {
+    for (int i = 0; i < numParameters; i++)
+        parameters[i] = parameterInfos[i].def;
+    calcAlgorithmParams(true);
+}
+
+void CompressorEngine::prepare(double sampleRate, int maxBlockSize) {
+    (void) maxBlockSize; // the kernel works in fixed size chunks on the stack
+    fs = sampleRate;
+
+    // room for the longest lookahead plus one chunk written ahead of it
+    maxDelaySamples = (int) std::ceil(LOOKAHEAD_MAX*fs/1000.0) + CompressorKernel::getOversamplingLatency(4);
+    int delayLength = 1;
+    while (delayLength < maxDelaySamples + delayChunk)
+        delayLength *= 2;
+    delayLeft.assign(delayLength, 0.0);
+    delayRight.assign(delayLength, 0.0);
+    delayMask = delayLength - 1;
+
+    calcAlgorithmParams(true);
+    parametersChanged = false;
+    std::fill(pathSamples, pathSamples + CompressorKernel::numPaths, 0);
+}
+
+void CompressorEngine::reset() {
+    state = CompressorKernel::State();
+    bandState = CompressorKernel::BandState<float>();
+    bandStateDouble = CompressorKernel::BandState<double>();
+    bandsEnvelopeDb = -200;
+    bandsGainLinear = 1;
+    keyFilterState = CompressorKernel::KeyFilterState();
+    clearDelayLine();
+}
+
+void CompressorEngine::clearDelayLine() {
+    std::fill(delayLeft.begin(), delayLeft.end(), 0.0);
+    std::fill(delayRight.begin(), delayRight.end(), 0.0);
+    delayWrite = 0;
+}
+
+void CompressorEngine::setParameter(Parameter param, float value) {
+    const ParameterInfo& range = parameterInfos[param];
+    value = std::min(std::max(value, range.min), range.max);
+    if (value != parameters[param]) {
+        parameters[param] = value;
+        parametersChanged = true;
+    }
+}
+
+void CompressorEngine::setParameter(Parameter param, float value, int sampleOffset) {
+    if (sampleOffset < 0 || numPendingChanges == maxPendingChanges) {
+        setParameter(param, value);
+        return;
+    }
+
+    const ParameterInfo& range = parameterInfos[param];
+    value = std::min(std::max(value, range.min), range.max);
+
+    // after the changes at the same or an earlier offset
+    int i = numPendingChanges;
+    while (i > 0 && pendingChanges[i - 1].offset > sampleOffset) {
+        pendingChanges[i] = pendingChanges[i - 1];
+        i--;
+    }
+    pendingChanges[i] = { sampleOffset, param, value };
+    numPendingChanges++;
+}
+
+float CompressorEngine::getParameter(Parameter param) const {
+    return parameters[param];
+}
+
+bool CompressorEngine::isInSameState(const CompressorEngine& other) const {
+    auto same = [](const auto& a, const auto& b) { return std::memcmp(&a, &b, sizeof(a)) == 0; };
+    auto sameRamp = [this, &same](const Ramp& a, const Ramp& b) {
+        // where a finished ramp started no longer matters
+        return same(a.current, b.current) && same(a.target, b.target) && same(a.step, b.step)
+               && same(a.setting, b.setting) && a.samplesLeft == b.samplesLeft
+               && (a.samplesLeft == 0 || (a.length == b.length && same(a.start, b.start)));
+    };
+
+    // settings and ramps
+    if (!same(parameters, other.parameters) || parametersChanged != other.parametersChanged
+        || fs != other.fs || gainRampShape != other.gainRampShape || keyChannels != other.keyChannels)
+        return false;
+    if (numPendingChanges != other.numPendingChanges)
+        return false;
+    for (int i = 0; i < numPendingChanges; i++) {
+        const ParameterChange& a = pendingChanges[i];
+        const ParameterChange& b = other.pendingChanges[i];
+        if (a.offset != b.offset || a.param != b.param || !same(a.value, b.value))
+            return false;
+    }
+    const Ramp* ramps[] = { &preGainRamp, &postGainRamp, &thresholdRamp, &ratioRamp };
+    const Ramp* otherRamps[] = { &other.preGainRamp, &other.postGainRamp, &other.thresholdRamp, &other.ratioRamp };
+    for (int i = 0; i < 4; i++) {
+        if (!sameRamp(*ramps[i], *otherRamps[i]))
+            return false;
+    }
+    for (int b = 0; b < CompressorKernel::maxBands; b++) {
+        if (!sameRamp(bandThresholdRamps[b], other.bandThresholdRamps[b])
+            || !sameRamp(bandRatioRamps[b], other.bandRatioRamps[b]))
+            return false;
+    }
+    if (frontGainTableReady != other.frontGainTableReady || buildingGainTable != other.buildingGainTable
+        || gainTableBuilt != other.gainTableBuilt || gainTableSamplesLeft != other.gainTableSamplesLeft
+        || !same(gainTables[frontGainTable].ratio, other.gainTables[other.frontGainTable].ratio))
+        return false;
+
+    // detector, gain and filter memory (not the meters)
+    if (!same(state.envOut, other.state.envOut) || !same(state.gainOutLinear, other.state.gainOutLinear)
+        || state.controlInterval != other.state.controlInterval || state.controlPosition != other.state.controlPosition
+        || !same(state.controlSum, other.state.controlSum) || !same(state.controlGain, other.state.controlGain)
+        || !same(state.gainStep, other.state.gainStep)
+        || !same(state.upsampleHistory1, other.state.upsampleHistory1)
+        || !same(state.upsampleHistory2, other.state.upsampleHistory2))
+        return false;
+    auto sameBands = [&same](const auto& a, const auto& b) {
+        return same(a.envOut, b.envOut) && same(a.gainOutLinear, b.gainOutLinear)
+               && same(a.z1, b.z1) && same(a.z2, b.z2) && same(a.keyZ1, b.keyZ1) && same(a.keyZ2, b.keyZ2);
+    };
+    if (activeBands > 1 && (bandsInDouble != other.bandsInDouble || !sameBands(bandState, other.bandState)
+                            || !sameBands(bandStateDouble, other.bandStateDouble)))
+        return false;
+    if (!same(keyFilterState, other.keyFilterState))
+        return false;
+
+    // the delay line's last maxDelaySamples inputs, wherever each one's
+    // write position is
+    if (delaySamples != other.delaySamples || delayFadeSamplesLeft != other.delayFadeSamplesLeft
+        || fadeFromDelaySamples != other.fadeFromDelaySamples || delayMask != other.delayMask)
+        return false;
+    if (delayActive()) {
+        for (int i = 1; i <= maxDelaySamples; i++) {
+            const int read = (delayWrite - i) & delayMask;
+            const int otherRead = (other.delayWrite - i) & delayMask;
+            if (!same(delayLeft[read], other.delayLeft[otherRead]) || !same(delayRight[read], other.delayRight[otherRead]))
+                return false;
+        }
+    }
+    return true;
+}
+
+CompressorEngine::Parameter CompressorEngine::getBandParameter(int band, Parameter bandOneParameter) {
+    if (band == 0)
+        return bandOneParameter;
+    return (Parameter) (band2Threshold + 4*(band - 1) + (bandOneParameter - threshold));
+}
+
+float CompressorEngine::getParameterMin(Parameter param) {
+    return parameterInfos[param].min;
+}
+
+float CompressorEngine::getParameterMax(Parameter param) {
+    return parameterInfos[param].max;
+}
+
+float CompressorEngine::getParameterDefault(Parameter param) {
+    return parameterInfos[param].def;
+}
+
+const char* CompressorEngine::getParameterId(Parameter param) {
+    return parameterInfos[param].id;
+}
+
+void CompressorEngine::calcAlgorithmParams(bool jumpToTargets) {
+    coeffs.envB0 = 1 - exp(-1/(envTau*fs));
+    bandCoeffs.envB0 = bandCoeffsDouble.envB0 = coeffs.envB0;
+    for (int b = 0; b < CompressorKernel::maxBands; b++)
+        calcBandDynamics(b);
+
+    // a ramp starts again from where it is when its setting has changed
+    const int rampLength = jumpToTargets ? 0 : (int) (rampTime*fs);
+    auto rampTo = [this, rampLength] (Ramp& r, float setting, bool gain) {
+        if (rampLength == 0 || setting != r.setting)
+            startRamp(r, setting, setting, rampLength, gain);
+    };
+    rampTo(thresholdRamp, parameters[threshold], false);
+    rampTo(ratioRamp, parameters[ratio], false);
+    rampTo(preGainRamp, pow(10,parameters[preGain]/20.0), true);
+    rampTo(postGainRamp, pow(10,parameters[postGain]/20.0), true);
+
+    // multiband, the crossover memory doesn't carry over to another layout
+    const int newActiveBands = (int) std::lround(parameters[numBands]);
+    if (newActiveBands != activeBands) {
+        bandState = CompressorKernel::BandState<float>();
+        bandStateDouble = CompressorKernel::BandState<double>();
+    }
+    activeBands = newActiveBands;
+    for (int b = 0; b < CompressorKernel::maxBands; b++) {
+        rampTo(bandThresholdRamps[b], parameters[getBandParameter(b, threshold)], false);
+        rampTo(bandRatioRamps[b], parameters[getBandParameter(b, ratio)], false);
+    }
+    calcCrossovers();
+    calcKeyFilter();
+    startGainTable(jumpToTargets);
+
+    // the audio also waits for the oversampled detector's interpolators
+    coeffs.oversampling = activeBands == 1 ? 1 << (int) std::lround(parameters[truePeak]) : 1;
+    selectBlockLoops();
+    const int newDelaySamples = std::min((int) std::lround(parameters[lookahead]*fs/1000.0)
+                                         + CompressorKernel::getOversamplingLatency(coeffs.oversampling),
+                                         maxDelaySamples);
+    if (jumpToTargets) {
+        delaySamples = newDelaySamples;
+        delayFadeSamplesLeft = 0;
+        clearDelayLine();
+    } else if (newDelaySamples != delaySamples) {
+        if (!delayActive())
+            clearDelayLine(); // not written while the lookahead was off
+        fadeFromDelaySamples = delaySamples;
+        delaySamples = newDelaySamples;
+        delayFadeLength = delayFadeSamplesLeft = std::max(1, (int) (rampTime*fs));
+    }
+}
+
+void CompressorEngine::applyTimedChange(int index) {
+    const ParameterChange& change = pendingChanges[index];
+    parameters[change.param] = change.value;
+
+    // the next change queued for the same parameter, if any, is where a
+    // glide heads for. One at the same offset replaces this one
+    const ParameterChange* next = nullptr;
+    for (int i = index + 1; i < numPendingChanges && next == nullptr; i++) {
+        if (pendingChanges[i].param == change.param)
+            next = &pendingChanges[i];
+    }
+    if (next != nullptr && next->offset == change.offset)
+        return;
+    const int length = next != nullptr ? next->offset - change.offset : (int) (rampTime*fs);
+    const float nextValue = next != nullptr ? next->value : change.value;
+    auto glide = [this, length] (Ramp& r, float setting, float target, bool gain) {
+        startRamp(r, setting, target, length, gain);
+    };
+
+    // only what depends on the parameter is worked out again
+    const Parameter param = change.param;
+    if (param == threshold) {
+        glide(thresholdRamp, change.value, nextValue, false);
+        glide(bandThresholdRamps[0], change.value, nextValue, false);
+    } else if (param == ratio) {
+        glide(ratioRamp, change.value, nextValue, false);
+        glide(bandRatioRamps[0], change.value, nextValue, false);
+        startGainTable(false);
+    } else if (param == preGain) {
+        glide(preGainRamp, pow(10,change.value/20.0), pow(10,nextValue/20.0), true);
+    } else if (param == postGain) {
+        glide(postGainRamp, pow(10,change.value/20.0), pow(10,nextValue/20.0), true);
+    } else if (param == attack || param == release) {
+        calcBandDynamics(0);
+    } else if (param >= band2Threshold && param <= band5Release) {
+        const int band = (param - band2Threshold)/4 + 1;
+        if (param == getBandParameter(band, threshold))
+            glide(bandThresholdRamps[band], change.value, nextValue, false);
+        else if (param == getBandParameter(band, ratio))
+            glide(bandRatioRamps[band], change.value, nextValue, false);
+        else
+            calcBandDynamics(band);
+    } else if (param >= crossover1 && param <= crossover4) {
+        calcCrossovers();
+    } else if (param == keyFilter || param == keyLowCut || param == keyHighCut) {
+        calcKeyFilter();
+    } else if (param == ecoInterval) {
+        calcControlRate();
+    } else if (param != channelLink) {
+        // the band layout or the latency, everything is worked out again
+        parametersChanged = true;
+    }
+}
+
+// attack and release of a band, band 0's also being the single band's
+void CompressorEngine::calcBandDynamics(int band) {
+    const double attackCoeff = 1.0 - exp(-1.0/(parameters[getBandParameter(band, attack)]*fs/1000.0));
+    const double releaseCoeff = 1.0 - exp(-1.0/(parameters[getBandParameter(band, release)]*fs/1000.0));
+    bandCoeffs.attackCoeff[band] = bandCoeffsDouble.attackCoeff[band] = attackCoeff;
+    bandCoeffs.releaseCoeff[band] = bandCoeffsDouble.releaseCoeff[band] = releaseCoeff;
+    if (band == 0) {
+        coeffs.attackCoeff = attackCoeff;
+        coeffs.releaseCoeff = releaseCoeff;
+        calcControlRate();
+    }
+}
+
+void CompressorEngine::calcControlRate() {
+    const int controlInterval = (int) std::lround(parameters[ecoInterval]);
+    CompressorKernel::prepareControlRate(controlRate, controlInterval, coeffs);
+    coeffs.controlRate = controlInterval > 1 ? &controlRate : nullptr;
+}
+
+// from where the ramp is now, a length of 0 jumps to the target
+void CompressorEngine::startRamp(Ramp& r, float setting, float target, int length, bool gain) {
+    r.setting = setting;
+    r.start = r.current;
+    r.target = target;
+    r.length = std::max(1, length);
+    r.samplesLeft = r.current == target ? 0 : length;
+    updateRamp(r, gain);
+}
+
+void CompressorEngine::updateRamp(Ramp& r, bool gain) {
+    const int position = r.length - r.samplesLeft;
+    if (r.samplesLeft <= 0) {
+        r.step = 0;
+        r.current = r.target;
+        return;
+    }
+    if (!gain || gainRampShape == RampShape::linear) {
+        r.step = (r.target - r.start)/r.length;
+        r.current = r.start + position*r.step;
+        return;
+    }
+
+    // exponential gains: straight between the knots, which are on the curve
+    const int knot = position - position % rampKnot;
+    const int nextKnot = std::min(knot + rampKnot, r.length);
+    auto at = [&r] (int p) {
+        return p >= r.length ? r.target : r.start*std::pow(r.target/r.start, (float) p/r.length);
+    };
+    const float knotValue = at(knot);
+    r.step = (at(nextKnot) - knotValue)/(nextKnot - knot);
+    r.current = knotValue + (position - knot)*r.step;
+}
+
+template <typename Function>
+void CompressorEngine::forEachRamp(Function f) {
+    f(preGainRamp, true);
+    f(postGainRamp, true);
+    f(thresholdRamp, false);
+    f(ratioRamp, false);
+    for (int b = 0; b < CompressorKernel::maxBands; b++) {
+        f(bandThresholdRamps[b], false);
+        f(bandRatioRamps[b], false);
+    }
+}
+
+void CompressorEngine::selectBlockLoops() {
+    blockLoops = &CompressorKernel::getBlockLoops(coeffs.oversampling, keyChannels);
+}
+
+void CompressorEngine::calcCrossovers() {
+    using namespace CompressorKernel;
+
+    // crossover frequencies, kept rising and below Nyquist
+    double frequencies[maxBands - 1];
+    for (int k = 0; k < activeBands - 1; k++) {
+        frequencies[k] = std::min((double) parameters[crossover1 + k], 0.45*fs);
+        if (k > 0)
+            frequencies[k] = std::max(frequencies[k], frequencies[k - 1]);
+    }
+
+    // band b: high pass of the crossovers below it, low pass of its upper
+    // crossover, all pass of the ones above to keep the bands in phase
+    bandCoeffs.numBands = bandCoeffsDouble.numBands = activeBands;
+    bandCoeffs.numStages = bandCoeffsDouble.numStages = 2*(activeBands - 1);
+    for (int b = 0; b < bandLanes; b++) {
+        for (int k = 0; k < maxBands - 1; k++) {
+            Biquad first { 0, 0, 0, 0, 0 }; // unused lanes/stages output silence
+            Biquad second = first;
+            if (b < activeBands && k < activeBands - 1) {
+                if (k < b) {
+                    first = second = designBiquad(FilterType::highPass, frequencies[k], fs);
+                } else if (k == b) {
+                    first = second = designBiquad(FilterType::lowPass, frequencies[k], fs);
+                } else {
+                    first = designBiquad(FilterType::allPass, frequencies[k], fs);
+                    second = bypass;
+                }
+            }
+            for (int st = 0; st < 2; st++) {
+                setBandStage(bandCoeffs, 2*k + st, b, st == 0 ? first : second);
+                setBandStage(bandCoeffsDouble, 2*k + st, b, st == 0 ? first : second);
+            }
+        }
+
+        // harmless gain computer values for the unused lanes
+        if (b >= activeBands) {
+            bandCoeffs.ratio[b] = bandCoeffsDouble.ratio[b] = 1;
+            bandCoeffs.thresholdDb[b] = bandCoeffsDouble.thresholdDb[b] = 0;
+        }
+    }
+}
+
+void CompressorEngine::startGainTable(bool finish) {
+    const float target = ratioRamp.target; // the ratio the ramp ends on
+    if (frontGainTableReady && gainTables[frontGainTable].ratio == target) {
+        buildingGainTable = false;
+        return;
+    }
+
+    // (re)start the back table, the front one stays in use until it is done
+    gainTables[1 - frontGainTable].ratio = target;
+    gainTableBuilt = 0;
+    gainTableSamplesLeft = 0;
+    buildingGainTable = true;
+    if (finish)
+        buildGainTable(CompressorKernel::gainTableSize);
+}
+
+void CompressorEngine::buildGainTable(int numEntries) {
+    CompressorKernel::GainTable& back = gainTables[1 - frontGainTable];
+    CompressorKernel::fillGainTable(back, gainTableBuilt, gainTableBuilt + numEntries);
+    gainTableBuilt += numEntries;
+    if (gainTableBuilt >= CompressorKernel::gainTableSize) {
+        frontGainTable = 1 - frontGainTable;
+        frontGainTableReady = true;
+        buildingGainTable = false;
+    }
+}
+
+void CompressorEngine::calcKeyFilter() {
+    using namespace CompressorKernel;
+
+    const int type = (int) std::lround(parameters[keyFilter]);
+    const bool highPass = type == 1 || type == 3;
+    const bool lowPass = type == 2 || type == 3;
+    int numStages = 0;
+    auto addSections = [this, &numStages] (FilterType filterType, double frequency) {
+        for (double q : butterworthQs) {
+            const Biquad b = designBiquad(filterType, std::min(frequency, 0.45*fs), fs, q);
+            keyFilterCoeffs.b0[numStages] = (float) b.b0;
+            keyFilterCoeffs.b1[numStages] = (float) b.b1;
+            keyFilterCoeffs.b2[numStages] = (float) b.b2;
+            keyFilterCoeffs.a1[numStages] = (float) b.a1;
+            keyFilterCoeffs.a2[numStages] = (float) b.a2;
+            numStages++;
+        }
+    };
+    if (highPass)
+        addSections(FilterType::highPass, parameters[keyLowCut]);
+    if (lowPass)
+        addSections(FilterType::lowPass, parameters[keyHighCut]);
+
+    // sections that come and go start from silence
+    for (int st = numStages; st < maxKeyStages; st++) {
+        for (int ch = 0; ch < 2; ch++)
+            keyFilterState.z1[ch][st] = keyFilterState.z2[ch][st] = 0;
+    }
+    keyFilterCoeffs.numStages = numStages;
+    prepareKeyFilter(keyFilterCoeffs);
+}
+
+void CompressorEngine::process(float* left, float* right, int numSamples) {
+    process(left, right, left, right, numSamples);
+}
+
+void CompressorEngine::process(const float* keyLeft, const float* keyRight,
+                               float* left, float* right, int numSamples) {
+    processSamples(keyLeft, keyRight, left, right, numSamples);
+}
+
+void CompressorEngine::process(double* left, double* right, int numSamples) {
+    process(left, right, left, right, numSamples);
+}
+
+void CompressorEngine::process(const double* keyLeft, const double* keyRight,
+                               double* left, double* right, int numSamples) {
+    processSamples(keyLeft, keyRight, left, right, numSamples);
+}
+
+template <typename Sample>
+void CompressorEngine::processSamples(const Sample* keyLeft, const Sample* keyRight,
+                                      Sample* left, Sample* right, int numSamples) {
+    // the bands' state lives in the audio's precision
+    CompressorKernel::BandState<Sample>& bands = bandStateFor(left);
+    const bool isDouble = !std::is_same<Sample, float>::value;
+    if (activeBands > 1 && isDouble != bandsInDouble) {
+        if (isDouble)
+            copyBandState(bandState, bandStateDouble);
+        else
+            copyBandState(bandStateDouble, bandState);
+    }
+    bandsInDouble = isDouble;
+
+    if (statsEnabled) {
+        float peak = 0;
+        float sumSquares = 0;
+        for (int i = 0; i < numSamples; i++) {
+            const float l = (float) left[i];
+            const float r = (float) right[i];
+            peak = std::max(peak, std::max(std::abs(l), std::abs(r)));
+            sumSquares += l*l + r*r;
+        }
+        stats.inputPeak = peak;
+        stats.inputRms = numSamples > 0 ? std::sqrt(sumSquares/(2*numSamples)) : 0;
+        state.minGainLinear = state.gainOutLinear;
+        state.maxGainLinear = state.gainOutLinear;
+        for (int b = 0; b < activeBands; b++)
+            bands.minGainLinear[b] = bands.maxGainLinear[b] = (float) bands.gainOutLinear[b];
+    }
+
+    // split the block where timed changes take effect
+    int done = 0;
+    int applied = 0;
+    while (done < numSamples) {
+        while (applied < numPendingChanges && pendingChanges[applied].offset <= done) {
+            applyTimedChange(applied);
+            applied++;
+        }
+        const int end = applied < numPendingChanges ? std::min(pendingChanges[applied].offset, numSamples) : numSamples;
+        processSegment(keyLeft + done, keyRight + done, left + done, right + done, end - done);
+        done = end;
+    }
+
+    // the rest are for later blocks
+    for (int i = applied; i < numPendingChanges; i++) {
+        pendingChanges[i - applied] = pendingChanges[i];
+        pendingChanges[i - applied].offset -= numSamples;
+    }
+    numPendingChanges -= applied;
+
+    // meters for the multiband mode: most reduced band, total detector
+    // level. Over the block, the most reduction of any band and the least
+    // reduction of the one that had the least headroom
+    float minGain = state.minGainLinear;
+    float maxGain = state.maxGainLinear;
+    if (activeBands > 1) {
+        double gain = 1;
+        double env = 0;
+        minGain = maxGain = 1;
+        for (int b = 0; b < activeBands; b++) {
+            gain = std::min(gain, bands.gainOutLinear[b]);
+            env += bands.envOut[b];
+            minGain = std::min(minGain, bands.minGainLinear[b]);
+            maxGain = std::min(maxGain, bands.maxGainLinear[b]);
+        }
+        bandsGainLinear = (float) gain;
+        bandsEnvelopeDb = (float) (10*log10(std::max(env, 1.0e-20)));
+    }
+
+    if (statsEnabled) {
+        stats.minGainLinear = minGain;
+        stats.maxGainLinear = maxGain;
+    }
+}
+
+template <typename Sample>
+void CompressorEngine::processSegment(const Sample* keyLeft, const Sample* keyRight,
+                                      Sample* left, Sample* right, int numSamples) {
+    if (parametersChanged) {
+        calcAlgorithmParams(false);
+        parametersChanged = false;
+    }
+
+    // a mono key (one buffer for both sides) is only converted, filtered
+    // and interpolated once
+    const int newKeyChannels = keyLeft == keyRight ? 1 : 2;
+    if (newKeyChannels != keyChannels) {
+        keyChannels = newKeyChannels;
+        selectBlockLoops();
+    }
+
+    // the whole block in one go unless the key has to be filtered or
+    // converted to float, or the audio delayed, a chunk at a time
+    const bool delayed = delayActive();
+    const bool filterActive = keyFilterCoeffs.numStages > 0;
+    const bool floatKey = std::is_same<Sample, float>::value;
+    const int chunk = delayed || filterActive || !floatKey ? delayChunk : numSamples;
+    Sample delayedLeft[delayChunk];
+    Sample delayedRight[delayChunk];
+    float keyChunkLeft[delayChunk];
+    float keyChunkRight[delayChunk];
+    for (int done = 0; done < numSamples; done += chunk) {
+        const int n = std::min(chunk, numSamples - done);
+        const float* kl = toFloatKey(keyLeft + done, keyChunkLeft, n);
+        const float* kr = keyChannels == 2 ? toFloatKey(keyRight + done, keyChunkRight, n) : kl;
+        if (filterActive) {
+            // a silent key lets the filters ring down to -200 dB, then they
+            // are cleared and skipped until the key returns
+            const bool silentKey = fastPathEnabled && CompressorKernel::getPeak(kl, n) == 0
+                                   && (keyChannels == 1 || CompressorKernel::getPeak(kr, n) == 0);
+            auto isClear = [](const float (&z)[2][CompressorKernel::maxKeyStages]) {
+                return std::all_of(&z[0][0], &z[0][0] + 2*CompressorKernel::maxKeyStages, [](float x) { return x == 0; });
+            };
+            const bool filterAtRest = isClear(keyFilterState.z1) && isClear(keyFilterState.z2);
+            if (silentKey && filterAtRest) {
+                std::fill(keyChunkLeft, keyChunkLeft + n, 0.0f);
+                std::fill(keyChunkRight, keyChunkRight + n, 0.0f);
+            } else {
+                CompressorKernel::filterKey(kl, keyChannels == 2 ? kr : nullptr, keyChunkLeft,
+                                            keyChannels == 2 ? keyChunkRight : nullptr, n, keyFilterCoeffs, keyFilterState);
+                if (silentKey && CompressorKernel::getPeak(keyChunkLeft, n) < 1.0e-10f
+                    && (keyChannels == 1 || CompressorKernel::getPeak(keyChunkRight, n) < 1.0e-10f))
+                    keyFilterState = CompressorKernel::KeyFilterState();
+            }
+            kl = keyChunkLeft;
+            kr = keyChannels == 2 ? keyChunkRight : kl;
+        }
+        if (delayed) {
+            readDelayLine(left + done, right + done, delayedLeft, delayedRight, n);
+            processRamped(kl, kr, delayedLeft, delayedRight, n, false);
+            std::copy(delayedLeft, delayedLeft + n, left + done);
+            std::copy(delayedRight, delayedRight + n, right + done);
+        } else {
+            processRamped(kl, kr, left + done, right + done, n,
+                          !filterActive && keyLeft == left && keyRight == right);
+        }
+    }
+}
+
+template <typename Sample>
+void CompressorEngine::readDelayLine(const Sample* left, const Sample* right,
+                                     Sample* delayedLeft, Sample* delayedRight, int numSamples) {
+    // write first, so delays shorter than the block read this block's input
+    for (int i = 0; i < numSamples; i++) {
+        delayLeft[(delayWrite + i) & delayMask] = left[i];
+        delayRight[(delayWrite + i) & delayMask] = right[i];
+    }
+
+    for (int i = 0; i < numSamples; i++) {
+        const int read = (delayWrite + i - delaySamples) & delayMask;
+        delayedLeft[i] = delayLeft[read];
+        delayedRight[i] = delayRight[read];
+    }
+
+    // crossfade from the previous delay after a lookahead change
+    const int fadeSamples = std::min(numSamples, delayFadeSamplesLeft);
+    for (int i = 0; i < fadeSamples; i++) {
+        const int read = (delayWrite + i - fadeFromDelaySamples) & delayMask;
+        const Sample fadeOut = (Sample) (delayFadeSamplesLeft - i)/delayFadeLength;
+        delayedLeft[i] += fadeOut*((Sample) delayLeft[read] - delayedLeft[i]);
+        delayedRight[i] += fadeOut*((Sample) delayRight[read] - delayedRight[i]);
+    }
+    delayFadeSamplesLeft -= fadeSamples;
+
+    delayWrite = (delayWrite + numSamples) & delayMask;
+}
+
+template <typename Sample>
+void CompressorEngine::processRamped(const float* keyLeft, const float* keyRight,
+                                     Sample* left, Sample* right, int numSamples, bool keyIsAudio) {
+    for (int done = 0; done < numSamples;) {
+        if (buildingGainTable && gainTableSamplesLeft == 0) {
+            buildGainTable(gainTableSlice);
+            gainTableSamplesLeft = gainTableSliceSamples;
+        }
+
+        // split the block where a ramp ends, at the exponential gain ramps'
+        // knots and where the next gain table slice is due. A ramp that
+        // has ended has a step of 0
+        int n = getRampSplit(numSamples - done);
+        if (buildingGainTable)
+            n = std::min(n, gainTableSamplesLeft);
+
+        if (activeBands > 1) {
+            CompressorKernel::BandCoeffs<Sample>& bands = bandCoeffsFor(left);
+            bands.preGainLinear = preGainRamp.current;
+            bands.postGainLinear = postGainRamp.current;
+            bands.preGainStep = preGainRamp.step;
+            bands.postGainStep = postGainRamp.step;
+            for (int b = 0; b < activeBands; b++) {
+                bands.thresholdDb[b] = bandThresholdRamps[b].current;
+                bands.ratio[b] = bandRatioRamps[b].current;
+                bands.thresholdStep[b] = bandThresholdRamps[b].step;
+                bands.ratioStep[b] = bandRatioRamps[b].step;
+            }
+            // the bands of the audio are their own key, in either precision
+            CompressorKernel::processBands(keyIsAudio ? nullptr : keyLeft + done, keyIsAudio ? nullptr : keyRight + done,
+                                           left + done, right + done, n, bands, bandStateFor(left));
+            advanceRamps(n);
+            done += n;
+            continue;
+        }
+
+        coeffs.preGainLinear = preGainRamp.current;
+        coeffs.postGainLinear = postGainRamp.current;
+        coeffs.thresholdDb = thresholdRamp.current;
+        coeffs.ratio = ratioRamp.current;
+        coeffs.preGainStep = preGainRamp.step;
+        coeffs.postGainStep = postGainRamp.step;
+        coeffs.thresholdStep = thresholdRamp.step;
+        coeffs.ratioStep = ratioRamp.step;
+        coeffs.gainTable = frontGainTableReady ? &gainTables[frontGainTable] : nullptr;
+
+        const CompressorKernel::Path path = fastPathEnabled
+            ? CompressorKernel::choosePath(keyLeft + done, keyRight + done, n, coeffs, state)
+            : CompressorKernel::Path::full;
+        if (path == CompressorKernel::Path::full)
+            blockLoops->run(CompressorKernel::getCurve(coeffs), keyLeft + done, keyRight + done,
+                            left + done, right + done, n, coeffs, state);
+        else
+            CompressorKernel::processFast(path, keyLeft + done, keyRight + done,
+                                          left + done, right + done, n, coeffs, state);
+        pathSamples[(int) path] += n;
+
+        advanceRamps(n);
+        done += n;
+    }
+}
+
+int CompressorEngine::getRampSplit(int numSamples) {
+    const bool knots = gainRampShape == RampShape::exponential;
+    forEachRamp([&numSamples, knots] (Ramp& r, bool gain) {
+        if (r.samplesLeft <= 0)
+            return;
+        numSamples = std::min(numSamples, r.samplesLeft);
+        if (gain && knots)
+            numSamples = std::min(numSamples, rampKnot - (r.length - r.samplesLeft) % rampKnot);
+    });
+    return numSamples;
+}
+
+void CompressorEngine::advanceRamps(int numSamples) {
+    if (buildingGainTable)
+        gainTableSamplesLeft -= numSamples;
+    forEachRamp([this, numSamples] (Ramp& r, bool gain) {
+        if (r.samplesLeft > 0) {
+            r.samplesLeft -= numSamples;
+            updateRamp(r, gain);
+        }
+    });
+}
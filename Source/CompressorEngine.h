@@ -0,0 +1,298 @@
+/*
+  ==============================================================================
+
+    CompressorEngine.h
+    Created: 16 Oct 2026 2:05:11pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "CompressorKernel.h"
+
+#include <cstdint>
+#include <vector>
+
+//==============================================================================
+/**
+ The compressor DSP without any JUCE dependency: parameters, coefficients,
+ detector/gain state and the block loop (CompressorKernel). The plugin
+ processor wraps one of these, and CompressorEngineC.h exposes it to C
+ callers.
+
+ Only prepare() allocates (the lookahead delay line, sized for the
+ longest lookahead); process() and parameter changes never do. Set
+ parameters and process from the same thread.
+
+ Parameter changes glide to their new values over rampTime, and can be
+ given a sample offset into the next block, where the block is split so
+ the change lands on the same sample however the host buffers the audio.
+ A timed change only touches its own parameter: one that glides heads
+ for the value of the next change queued for it, reaching it at that
+ change's offset, so a run of timed changes traces the automation line.
+ Timed changes are for engine, C interface and BatchRender callers: the
+ plugin reads its AudioParameterFloats (flagged by parameterValueChanged)
+ once per block and sets them untimed, at the block's start.
+ Besides the single band compressor it has lookahead, a true peak
+ detector, up to 5 bands (numBands), a key filter and eco mode
+ (ecoInterval); the true peak detector and eco mode are single band only.
+ Double precision audio takes the same paths, with the crossovers in
+ double and the detector on a float copy of the key.
+*/
+class CompressorEngine
+{
+public:
+    // same order as the plugin parameters
+    enum Parameter {
+        threshold,  // dB
+        ratio,      // ratio
+        attack,     // ms
+        release,    // ms
+        preGain,    // dB
+        postGain,   // dB
+        lookahead,  // ms
+        truePeak,   // 0 = off, 1 = 2x, 2 = 4x oversampled detector
+        numBands,   // 1..5, 1 = single band
+        crossover1, // Hz, lower edge of band 2
+        crossover2,
+        crossover3,
+        crossover4,
+        band2Threshold, band2Ratio, band2Attack, band2Release, // band 1 uses the
+        band3Threshold, band3Ratio, band3Attack, band3Release, // parameters above
+        band4Threshold, band4Ratio, band4Attack, band4Release,
+        band5Threshold, band5Ratio, band5Attack, band5Release,
+        keyFilter,  // 0 = off, 1 = high pass, 2 = low pass, 3 = band pass
+        keyLowCut,  // Hz, high pass corner
+        keyHighCut, // Hz, low pass corner
+        channelLink, // 0 = linked, 1 = in pairs, 2 = per channel, read by
+                     // MultichannelCompressor (an engine's two are linked)
+        ecoInterval, // samples per gain computer update, 1 = every sample
+        numParameters
+    };
+
+    // threshold, ratio, attack or release of a band (0 based)
+    static Parameter getBandParameter(int band, Parameter bandOneParameter);
+
+    CompressorEngine();
+
+    void prepare(double sampleRate, int maxBlockSize);
+    void reset();
+
+    // values are clamped to the ranges in defines.h, the new value takes
+    // effect (with a ramp) at the start of the next process() call
+    void setParameter(Parameter param, float value);
+    float getParameter(Parameter param) const;
+
+    // same, at sampleOffset into the next process() call, or a later one
+    // for an offset past its end (the offset then counts on from there).
+    // Changes at the same offset apply in the order given. Past
+    // maxPendingChanges the change takes effect at the next block's start.
+    // Threshold, ratio, the gains and the band thresholds and ratios glide
+    // from a timed change to the next one queued for the same parameter
+    // (over rampTime when there is none), the other parameters step there
+    void setParameter(Parameter param, float value, int sampleOffset);
+    static constexpr int maxPendingChanges = 256;
+
+    // shape of the pre and post gain glides: linear in gain, or
+    // exponential (a straight line in dB, followed a straight piece per
+    // rampKnot samples). Threshold and ratio are in dB and a ratio, and
+    // always glide linearly
+    enum class RampShape { linear, exponential };
+    void setGainRampShape(RampShape shape) { gainRampShape = shape; }
+    static constexpr int rampKnot = 64;
+
+    // processes a stereo block in place
+    void process(float* left, float* right, int numSamples);
+
+    // same, but the detector listens to keyLeft/keyRight (an external
+    // sidechain) instead. The key is read where it is, and may be the
+    // same buffers as left/right
+    void process(const float* keyLeft, const float* keyRight,
+                 float* left, float* right, int numSamples);
+
+    // double precision versions of the two above
+    void process(double* left, double* right, int numSamples);
+    void process(const double* keyLeft, const double* keyRight,
+                 double* left, double* right, int numSamples);
+
+    // true when both engines have the same settings and memory (detector,
+    // gain, filters, oversampler and the audio waiting in the delay line),
+    // bit for bit, so the same input from here on gives the same output.
+    // E.g. to check that an engine started part way into a file has caught
+    // up with one that ran from the start
+    bool isInSameState(const CompressorEngine& other) const;
+
+    // how far the output lags the input because of the lookahead and the
+    // oversampled detector
+    int getLatencySamples() const { return delaySamples; }
+
+    // with more than one band: the bands' total level and the gain of the
+    // most reduced band
+    float getRmsEnvelopeDb() const { return activeBands > 1 ? bandsEnvelopeDb : state.rmsEnvelopeDb; }
+    float getGainOutLinear() const { return activeBands > 1 ? bandsGainLinear : (float) state.gainOutLinear; }
+
+    // levels of the last processed block, only filled in while enabled
+    struct BlockStats {
+        float inputPeak = 0;        // linear, before pre gain
+        float inputRms = 0;         // linear, before pre gain
+        float minGainLinear = 1;    // most gain reduction
+        float maxGainLinear = 1;    // least gain reduction
+    };
+    void setStatsEnabled(bool enabled) { statsEnabled = enabled; }
+    const BlockStats& getLastBlockStats() const { return stats; }
+
+    // the silent and quiet block fast paths, on by default. Off runs every
+    // block through the full loop, e.g. to time the difference
+    void setFastPathEnabled(bool enabled) { fastPathEnabled = enabled; }
+
+    // samples processed on each path since prepare()
+    int64_t getPathSamples(CompressorKernel::Path path) const { return pathSamples[(int) path]; }
+
+    static float getParameterMin(Parameter param);
+    static float getParameterMax(Parameter param);
+    static float getParameterDefault(Parameter param);
+
+    // the plugin's parameter ID ("threshold", "band2Ratio", ...), which
+    // saved state and presets are keyed by
+    static const char* getParameterId(Parameter param);
+
+private:
+    // a coefficient that glides from start to target over length samples.
+    // current and step (per sample) are its value and slope at the sample
+    // the ramp has got to, see updateRamp. setting is the value the
+    // parameter asks for, which a timed ramp passes on its way to the
+    // next timed change's
+    struct Ramp {
+        float start = 0;
+        float current = 0;
+        float target = 0;
+        float step = 0;
+        float setting = 0;
+        int length = 1;
+        int samplesLeft = 0;
+    };
+
+    float parameters[numParameters];
+    bool parametersChanged = false; // coefficients are out of date
+
+    // timed changes for the coming blocks, in offset order
+    struct ParameterChange {
+        int offset;
+        Parameter param;
+        float value;
+    };
+    ParameterChange pendingChanges[maxPendingChanges];
+    int numPendingChanges = 0;
+
+    float fs = 44100;       // sampling rate
+    float envTau = 0.01;    // integration time in sec for RMS env follower
+    float rampTime = 0.02;  // glide time in sec after a parameter change
+
+    CompressorKernel::Coeffs coeffs; // envB0, attack & release, used as is
+    Ramp preGainRamp;
+    Ramp postGainRamp;
+    Ramp thresholdRamp;
+    Ramp ratioRamp;
+    RampShape gainRampShape = RampShape::linear;
+    void startRamp(Ramp& r, float setting, float target, int length, bool gain);
+    void updateRamp(Ramp& r, bool gain);
+
+    // calls f(ramp, gain) for every ramp, gain for the pre and post gain
+    template <typename Function>
+    void forEachRamp(Function f);
+
+    CompressorKernel::State state; // RMS env follower & gain dynamics memory
+
+    // eco mode, in use while ecoInterval is above 1
+    CompressorKernel::ControlRate controlRate;
+
+    // block loops for the current detector oversampling and key channel
+    // count, only looked up again when one of those changes
+    const CompressorKernel::BlockLoops* blockLoops = nullptr;
+    int keyChannels = 2;    // 1 when the key's left and right are the same buffer
+    void selectBlockLoops();
+
+    // gain computer lookup table for the current ratio. After a ratio
+    // change the other table is built a slice per gainTableSliceSamples
+    // processed, while the ramp runs on the gain computer maths, and
+    // swapped in when done
+    static constexpr int gainTableSlice = 256; // entries at a time
+    static constexpr int gainTableSliceSamples = 1024;
+    int gainTableSamplesLeft = 0; // until the next slice
+    CompressorKernel::GainTable gainTables[2];
+    int frontGainTable = 0;
+    bool frontGainTableReady = false;
+    bool buildingGainTable = false;
+    int gainTableBuilt = 0; // entries of the back table filled in
+
+    // multiband
+    int activeBands = 1;
+    CompressorKernel::BandCoeffs<float> bandCoeffs;
+    CompressorKernel::BandCoeffs<double> bandCoeffsDouble;
+    CompressorKernel::BandState<float> bandState;
+    CompressorKernel::BandState<double> bandStateDouble;
+    bool bandsInDouble = false;     // which of the two states is live
+    Ramp bandThresholdRamps[CompressorKernel::maxBands];
+    Ramp bandRatioRamps[CompressorKernel::maxBands];
+    float bandsEnvelopeDb = -200;   // meters at the end of the last block
+    float bandsGainLinear = 1;
+
+    // key filter
+    CompressorKernel::KeyFilterCoeffs keyFilterCoeffs;
+    CompressorKernel::KeyFilterState keyFilterState;
+
+    // lookahead: the audio runs through this delay line while the detector
+    // listens to the undelayed input. A lookahead change crossfades from the
+    // old delay to the new one over rampTime. The line is only written while
+    // the lookahead is on, and is cleared when it gets switched on again.
+    static constexpr int delayChunk = 256; // samples per pass, on the stack (also for the key filter)
+    std::vector<double> delayLeft;  // double so double audio passes through unchanged
+    std::vector<double> delayRight;
+    int delayMask = 0;              // line length - 1, length is a power of 2
+    int delayWrite = 0;
+    int maxDelaySamples = 0;        // 0 until prepare()
+    int delaySamples = 0;
+    int fadeFromDelaySamples = 0;   // delay being faded out
+    int delayFadeSamplesLeft = 0;
+    int delayFadeLength = 1;
+
+    bool delayActive() const { return delaySamples > 0 || delayFadeSamplesLeft > 0; }
+    void clearDelayLine();
+    template <typename Sample>
+    void processSamples(const Sample* keyLeft, const Sample* keyRight,
+                        Sample* left, Sample* right, int numSamples);
+    template <typename Sample>
+    void processSegment(const Sample* keyLeft, const Sample* keyRight,
+                        Sample* left, Sample* right, int numSamples);
+    template <typename Sample>
+    void readDelayLine(const Sample* left, const Sample* right,
+                       Sample* delayedLeft, Sample* delayedRight, int numSamples);
+    template <typename Sample>
+    void processRamped(const float* keyLeft, const float* keyRight,
+                       Sample* left, Sample* right, int numSamples, bool keyIsAudio);
+
+    // the band coeffs and state for float or double audio
+    CompressorKernel::BandCoeffs<float>& bandCoeffsFor(const float*) { return bandCoeffs; }
+    CompressorKernel::BandCoeffs<double>& bandCoeffsFor(const double*) { return bandCoeffsDouble; }
+    CompressorKernel::BandState<float>& bandStateFor(const float*) { return bandState; }
+    CompressorKernel::BandState<double>& bandStateFor(const double*) { return bandStateDouble; }
+
+    bool statsEnabled = false;
+    BlockStats stats;
+
+    bool fastPathEnabled = true;
+    int64_t pathSamples[CompressorKernel::numPaths] = {};
+
+    void calcAlgorithmParams(bool jumpToTargets);
+    void applyTimedChange(int index);
+    void calcBandDynamics(int band);
+    void calcControlRate();
+    void calcCrossovers();
+    void calcKeyFilter();
+    void startGainTable(bool finish);
+    void buildGainTable(int numEntries);
+    int getRampSplit(int numSamples);
+    void advanceRamps(int numSamples);
+};
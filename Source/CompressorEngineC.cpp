@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    CompressorEngineC.cpp
+    Created: 16 Oct 2026 2:48:30pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "CompressorEngineC.h"
+#include "CompressorBatch.h"
+#include "CompressorEngine.h"
+
+#include <new>
+
+struct CompressorEngineHandle {
+    CompressorEngine engine;
+};
+
+struct CompressorBatchHandle {
+    CompressorBatch batch;
+};
+
+static bool isValidParam(CompressorParam param) {
+    return param >= 0 && param < COMPRESSOR_NUM_PARAMS;
+}
+
+CompressorEngineHandle* compressorEngineCreate(void) {
+    return new (std::nothrow) CompressorEngineHandle();
+}
+
+void compressorEngineDestroy(CompressorEngineHandle* engine) {
+    delete engine;
+}
+
+int compressorEnginePrepare(CompressorEngineHandle* engine, double sampleRate, int maxBlockSize) {
+    if (engine == nullptr || !(sampleRate > 0) || maxBlockSize < 0)
+        return COMPRESSOR_ERROR_ARGUMENT;
+    engine->engine.prepare(sampleRate, maxBlockSize);
+    return COMPRESSOR_OK;
+}
+
+void compressorEngineReset(CompressorEngineHandle* engine) {
+    if (engine != nullptr)
+        engine->engine.reset();
+}
+
+int compressorEngineSetParam(CompressorEngineHandle* engine, CompressorParam param, float value) {
+    if (engine == nullptr || !isValidParam(param))
+        return COMPRESSOR_ERROR_ARGUMENT;
+    engine->engine.setParameter((CompressorEngine::Parameter) param, value);
+    return COMPRESSOR_OK;
+}
+
+int compressorEngineSetParamAt(CompressorEngineHandle* engine, CompressorParam param, float value,
+                               int sampleOffset) {
+    if (engine == nullptr || !isValidParam(param) || sampleOffset < 0)
+        return COMPRESSOR_ERROR_ARGUMENT;
+    engine->engine.setParameter((CompressorEngine::Parameter) param, value, sampleOffset);
+    return COMPRESSOR_OK;
+}
+
+int compressorEngineSetGainRampShape(CompressorEngineHandle* engine, CompressorRampShape shape) {
+    if (engine == nullptr || (shape != COMPRESSOR_RAMP_LINEAR && shape != COMPRESSOR_RAMP_EXPONENTIAL))
+        return COMPRESSOR_ERROR_ARGUMENT;
+    engine->engine.setGainRampShape(shape == COMPRESSOR_RAMP_EXPONENTIAL
+                                    ? CompressorEngine::RampShape::exponential
+                                    : CompressorEngine::RampShape::linear);
+    return COMPRESSOR_OK;
+}
+
+float compressorEngineGetParam(const CompressorEngineHandle* engine, CompressorParam param) {
+    if (engine == nullptr || !isValidParam(param))
+        return 0;
+    return engine->engine.getParameter((CompressorEngine::Parameter) param);
+}
+
+int compressorEngineGetLatency(const CompressorEngineHandle* engine) {
+    if (engine == nullptr)
+        return 0;
+    return engine->engine.getLatencySamples();
+}
+
+int compressorEngineProcess(CompressorEngineHandle* engine, float* const* channels,
+                            int numChannels, int numSamples) {
+    if (engine == nullptr || channels == nullptr || numChannels != 2 || numSamples < 0)
+        return COMPRESSOR_ERROR_ARGUMENT;
+    engine->engine.process(channels[0], channels[1], numSamples);
+    return COMPRESSOR_OK;
+}
+
+int compressorEngineProcessDouble(CompressorEngineHandle* engine, double* const* channels,
+                                  int numChannels, int numSamples) {
+    if (engine == nullptr || channels == nullptr || numChannels != 2 || numSamples < 0)
+        return COMPRESSOR_ERROR_ARGUMENT;
+    engine->engine.process(channels[0], channels[1], numSamples);
+    return COMPRESSOR_OK;
+}
+
+int compressorEngineProcessSidechain(CompressorEngineHandle* engine, float* const* channels, int numChannels,
+                                     const float* const* keyChannels, int numKeyChannels, int numSamples) {
+    if (engine == nullptr || channels == nullptr || numChannels != 2 || keyChannels == nullptr
+        || numKeyChannels < 1 || numKeyChannels > 2 || numSamples < 0)
+        return COMPRESSOR_ERROR_ARGUMENT;
+    engine->engine.process(keyChannels[0], keyChannels[numKeyChannels - 1],
+                           channels[0], channels[1], numSamples);
+    return COMPRESSOR_OK;
+}
+
+//==============================================================================
+CompressorBatchHandle* compressorBatchCreate(void) {
+    return new (std::nothrow) CompressorBatchHandle();
+}
+
+void compressorBatchDestroy(CompressorBatchHandle* batch) {
+    delete batch;
+}
+
+int compressorBatchPrepare(CompressorBatchHandle* batch, double sampleRate, int numInstances) {
+    if (batch == nullptr || !(sampleRate > 0) || numInstances < 0)
+        return COMPRESSOR_ERROR_ARGUMENT;
+    batch->batch.prepare(sampleRate, numInstances);
+    return COMPRESSOR_OK;
+}
+
+void compressorBatchReset(CompressorBatchHandle* batch) {
+    if (batch != nullptr)
+        batch->batch.reset();
+}
+
+int compressorBatchSetParam(CompressorBatchHandle* batch, int instance, CompressorParam param, float value) {
+    if (batch == nullptr || !isValidParam(param) || instance < 0 || instance >= batch->batch.getNumInstances()
+        || !CompressorBatch::isBatchParameter((CompressorEngine::Parameter) param))
+        return COMPRESSOR_ERROR_ARGUMENT;
+    batch->batch.setParameter(instance, (CompressorEngine::Parameter) param, value);
+    return COMPRESSOR_OK;
+}
+
+float compressorBatchGetParam(const CompressorBatchHandle* batch, int instance, CompressorParam param) {
+    if (batch == nullptr || !isValidParam(param))
+        return 0;
+    return batch->batch.getParameter(instance, (CompressorEngine::Parameter) param);
+}
+
+int compressorBatchProcess(CompressorBatchHandle* batch, float* const* channels, int numChannels, int numSamples) {
+    if (batch == nullptr || channels == nullptr || numChannels != 2*batch->batch.getNumInstances() || numSamples < 0)
+        return COMPRESSOR_ERROR_ARGUMENT;
+    batch->batch.process(channels, numSamples);
+    return COMPRESSOR_OK;
+}
@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    CompressorEngineC.h
+    Created: 16 Oct 2026 2:48:30pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+/*
+ Plain C interface to CompressorEngine for embedding the compressor
+ outside of a plugin host. An engine is not thread safe: set parameters
+ and process from the same thread (or synchronise around the calls).
+ Only compressorEngineCreate and compressorEnginePrepare allocate.
+
+ A batch (compressorBatch*) runs many single band compressors together,
+ e.g. one per mixer channel, a few times cheaper than an engine each.
+ The same rules apply, with compressorBatchCreate and
+ compressorBatchPrepare the only calls that allocate.
+ */
+
+#if defined(_WIN32)
+ #define COMPRESSOR_ENGINE_API __declspec(dllexport)
+#else
+ #define COMPRESSOR_ENGINE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CompressorEngineHandle CompressorEngineHandle;
+
+// same order and units as CompressorEngine::Parameter
+typedef enum {
+    COMPRESSOR_PARAM_THRESHOLD = 0, // dB
+    COMPRESSOR_PARAM_RATIO,         // ratio
+    COMPRESSOR_PARAM_ATTACK,        // ms
+    COMPRESSOR_PARAM_RELEASE,       // ms
+    COMPRESSOR_PARAM_PRE_GAIN,      // dB
+    COMPRESSOR_PARAM_POST_GAIN,     // dB
+    COMPRESSOR_PARAM_LOOKAHEAD,     // ms
+    COMPRESSOR_PARAM_TRUE_PEAK,     // 0 = off, 1 = 2x, 2 = 4x oversampled detector
+    COMPRESSOR_PARAM_NUM_BANDS,     // 1..5, band 1 uses THRESHOLD..RELEASE above
+    COMPRESSOR_PARAM_CROSSOVER1,    // Hz, between band 1 and 2
+    COMPRESSOR_PARAM_CROSSOVER2,    // Hz
+    COMPRESSOR_PARAM_CROSSOVER3,    // Hz
+    COMPRESSOR_PARAM_CROSSOVER4,    // Hz
+    COMPRESSOR_PARAM_BAND2_THRESHOLD, // dB
+    COMPRESSOR_PARAM_BAND2_RATIO,
+    COMPRESSOR_PARAM_BAND2_ATTACK,  // ms
+    COMPRESSOR_PARAM_BAND2_RELEASE, // ms
+    COMPRESSOR_PARAM_BAND3_THRESHOLD,
+    COMPRESSOR_PARAM_BAND3_RATIO,
+    COMPRESSOR_PARAM_BAND3_ATTACK,
+    COMPRESSOR_PARAM_BAND3_RELEASE,
+    COMPRESSOR_PARAM_BAND4_THRESHOLD,
+    COMPRESSOR_PARAM_BAND4_RATIO,
+    COMPRESSOR_PARAM_BAND4_ATTACK,
+    COMPRESSOR_PARAM_BAND4_RELEASE,
+    COMPRESSOR_PARAM_BAND5_THRESHOLD,
+    COMPRESSOR_PARAM_BAND5_RATIO,
+    COMPRESSOR_PARAM_BAND5_ATTACK,
+    COMPRESSOR_PARAM_BAND5_RELEASE,
+    COMPRESSOR_PARAM_KEY_FILTER,    // 0 = off, 1 = high pass, 2 = low pass, 3 = band pass
+    COMPRESSOR_PARAM_KEY_LOW_CUT,   // Hz
+    COMPRESSOR_PARAM_KEY_HIGH_CUT,  // Hz
+    COMPRESSOR_PARAM_CHANNEL_LINK,  // no effect on an engine (always linked) or a batch
+    COMPRESSOR_PARAM_ECO_INTERVAL,  // samples per gain computer update, 1 = every sample
+    COMPRESSOR_NUM_PARAMS
+} CompressorParam;
+
+// return codes
+#define COMPRESSOR_OK               0
+#define COMPRESSOR_ERROR_ARGUMENT   -1
+
+// returns NULL if out of memory
+COMPRESSOR_ENGINE_API CompressorEngineHandle* compressorEngineCreate(void);
+COMPRESSOR_ENGINE_API void compressorEngineDestroy(CompressorEngineHandle* engine);
+
+COMPRESSOR_ENGINE_API int compressorEnginePrepare(CompressorEngineHandle* engine,
+                                                  double sampleRate, int maxBlockSize);
+COMPRESSOR_ENGINE_API void compressorEngineReset(CompressorEngineHandle* engine);
+
+// values are clamped to the plugin ranges
+COMPRESSOR_ENGINE_API int compressorEngineSetParam(CompressorEngineHandle* engine,
+                                                   CompressorParam param, float value);
+COMPRESSOR_ENGINE_API float compressorEngineGetParam(const CompressorEngineHandle* engine,
+                                                     CompressorParam param);
+
+// same, taking effect sampleOffset samples into the next process call (or
+// a later one, for an offset past its end), so automation lands on the
+// same sample whatever the block size. Up to 256 changes can be pending.
+// Threshold, ratio, the gains and the band thresholds and ratios glide
+// from such a change to the next one queued for the same parameter
+COMPRESSOR_ENGINE_API int compressorEngineSetParamAt(CompressorEngineHandle* engine,
+                                                     CompressorParam param, float value,
+                                                     int sampleOffset);
+
+// shape of the pre and post gain glides after a change
+typedef enum {
+    COMPRESSOR_RAMP_LINEAR = 0,     // linear in gain
+    COMPRESSOR_RAMP_EXPONENTIAL     // linear in dB
+} CompressorRampShape;
+
+COMPRESSOR_ENGINE_API int compressorEngineSetGainRampShape(CompressorEngineHandle* engine,
+                                                           CompressorRampShape shape);
+
+// output delay in samples caused by the lookahead, updated by the first
+// compressorEngineProcess call after the lookahead changed
+COMPRESSOR_ENGINE_API int compressorEngineGetLatency(const CompressorEngineHandle* engine);
+
+// processes numChannels planar channels in place, numChannels must be 2
+COMPRESSOR_ENGINE_API int compressorEngineProcess(CompressorEngineHandle* engine,
+                                                  float* const* channels, int numChannels,
+                                                  int numSamples);
+
+// double precision version of compressorEngineProcess
+COMPRESSOR_ENGINE_API int compressorEngineProcessDouble(CompressorEngineHandle* engine,
+                                                        double* const* channels, int numChannels,
+                                                        int numSamples);
+
+// same, but the detector listens to the numKeyChannels (1 or 2) planar
+// key channels instead (an external sidechain)
+COMPRESSOR_ENGINE_API int compressorEngineProcessSidechain(CompressorEngineHandle* engine,
+                                                           float* const* channels, int numChannels,
+                                                           const float* const* keyChannels, int numKeyChannels,
+                                                           int numSamples);
+
+//==============================================================================
+typedef struct CompressorBatchHandle CompressorBatchHandle;
+
+// returns NULL if out of memory
+COMPRESSOR_ENGINE_API CompressorBatchHandle* compressorBatchCreate(void);
+COMPRESSOR_ENGINE_API void compressorBatchDestroy(CompressorBatchHandle* batch);
+
+// numInstances compressors, each keeps its settings across prepares
+COMPRESSOR_ENGINE_API int compressorBatchPrepare(CompressorBatchHandle* batch,
+                                                 double sampleRate, int numInstances);
+COMPRESSOR_ENGINE_API void compressorBatchReset(CompressorBatchHandle* batch);
+
+// THRESHOLD .. POST_GAIN of one instance, clamped to the plugin ranges.
+// The other parameters don't apply to a batch
+COMPRESSOR_ENGINE_API int compressorBatchSetParam(CompressorBatchHandle* batch, int instance,
+                                                  CompressorParam param, float value);
+COMPRESSOR_ENGINE_API float compressorBatchGetParam(const CompressorBatchHandle* batch, int instance,
+                                                    CompressorParam param);
+
+// processes numChannels planar channels in place, instance k on channels
+// 2k and 2k + 1, so numChannels must be twice the instance count
+COMPRESSOR_ENGINE_API int compressorBatchProcess(CompressorBatchHandle* batch,
+                                                 float* const* channels, int numChannels,
+                                                 int numSamples);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1593 @@
+/*
+  ==============================================================================
+
+    CompressorKernel.cpp
+    Created: 16 Oct 2026 9:12:40am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "CompressorKernel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+ #define KERNEL_X86 1
+ // GCC 12's AVX-512 intrinsics pass a self-initialised _mm512_undefined_*
+ // vector as the unused merge source, which -Wmaybe-uninitialized reports
+ // wherever they are inlined (GCC bug 105593, fixed in 12.3)
+ #if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+  #include <immintrin.h>
+  #pragma GCC diagnostic pop
+ #else
+  #include <immintrin.h>
+ #endif
+#elif defined(__aarch64__)
+ #define KERNEL_NEON 1
+ #include <arm_neon.h>
+#endif
+
+// AVX-512F includes FMA, and the compiler would fuse mul + add into it for
+// the AVX-512 path only. Keep two roundings everywhere so every path gives
+// the same results (the crossover filters in particular amplify the
+// difference). GCC has no pragma for it, so this file is built with
+// -ffp-contract=off (the FpContractOff flag scheme in the .jucer)
+#if defined(__clang__)
+ #pragma clang fp contract(off)
+#endif
+
+// runtime selection of AVX2/AVX-512 needs per-function target attributes
+#if KERNEL_X86 && (defined(__GNUC__) || defined(__clang__))
+ #define KERNEL_X86_DISPATCH 1
+#endif
+
+namespace CompressorKernel
+{
+
+// GainTable position of a level: its float bits shifted down to the
+// exponent and the top gainTableStepBits of the mantissa, less those of
+// 1.0. The bits below make the interpolation fraction.
+constexpr int gainTableShift = 23 - gainTableStepBits;
+constexpr int gainTableBias = 127 << gainTableStepBits;
+constexpr int gainTableFractionMask = (1 << gainTableShift) - 1;
+constexpr float gainTableFractionScale = 1.0f/(1 << gainTableShift);
+
+// 0, 1, 2, ... for building per-lane ramps
+alignas(64) static const float laneIndex[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+//==============================================================================
+// SSE2 (baseline on x86-64)
+#if KERNEL_X86
+namespace sse2
+{
+    #define KERNEL_TARGET
+    using Vec = __m128;
+    using Mask = __m128;
+    constexpr int width = 4;
+
+    static inline Vec set1(float x) { return _mm_set1_ps(x); }
+    static inline Vec load(const float* p) { return _mm_loadu_ps(p); }
+    static inline void store(float* p, Vec x) { _mm_storeu_ps(p, x); }
+    static inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    static inline Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+    static inline Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+    static inline Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+    static inline Mask lessThan(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static inline Vec exponentOf(Vec x) {
+        __m128i e = _mm_srli_epi32(_mm_castps_si128(x), 23);
+        return _mm_cvtepi32_ps(_mm_sub_epi32(e, _mm_set1_epi32(126)));
+    }
+    static inline Vec mantissaOf(Vec x) {
+        __m128i m = _mm_and_si128(_mm_castps_si128(x), _mm_set1_epi32(0x007fffff));
+        return _mm_castsi128_ps(_mm_or_si128(m, _mm_set1_epi32(0x3f000000)));
+    }
+    static inline Vec roundToInt(Vec x) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(x)); }
+    static inline Vec pow2(Vec n) {
+        __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+    }
+    using VecD = __m128d;
+    static inline VecD setD(double x) { return _mm_set1_pd(x); }
+    static inline VecD loadD(const double* p) { return _mm_loadu_pd(p); }
+    static inline void storeD(double* p, VecD x) { _mm_storeu_pd(p, x); }
+    static inline VecD addD(VecD a, VecD b) { return _mm_add_pd(a, b); }
+    static inline VecD subD(VecD a, VecD b) { return _mm_sub_pd(a, b); }
+    static inline VecD mulD(VecD a, VecD b) { return _mm_mul_pd(a, b); }
+    static inline VecD selectLessD(VecD a, VecD b, VecD x, VecD y) {
+        __m128d m = _mm_cmplt_pd(a, b);
+        return _mm_or_pd(_mm_and_pd(m, x), _mm_andnot_pd(m, y));
+    }
+    static inline VecD lowToDouble(Vec x) { return _mm_cvtps_pd(x); }
+    static inline VecD highToDouble(Vec x) { return _mm_cvtps_pd(_mm_movehl_ps(x, x)); }
+    static inline Vec toFloat(VecD low, VecD high) { return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)); }
+    static inline void transposeBlock(const float* in, int inStride, float* out, int outStride) {
+        __m128 r0 = _mm_loadu_ps(in), r1 = _mm_loadu_ps(in + inStride);
+        __m128 r2 = _mm_loadu_ps(in + 2*inStride), r3 = _mm_loadu_ps(in + 3*inStride);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(out, r0);
+        _mm_storeu_ps(out + outStride, r1);
+        _mm_storeu_ps(out + 2*outStride, r2);
+        _mm_storeu_ps(out + 3*outStride, r3);
+    }
+    static inline void transposeBlockD(const double* in, int inStride, double* out, int outStride) {
+        const __m128d r0 = _mm_loadu_pd(in), r1 = _mm_loadu_pd(in + inStride);
+        _mm_storeu_pd(out, _mm_unpacklo_pd(r0, r1));
+        _mm_storeu_pd(out + outStride, _mm_unpackhi_pd(r0, r1));
+    }
+    static inline Vec lookupGain(const float* table, Vec x) {
+        __m128i bits = _mm_castps_si128(x);
+        alignas(16) int index[4];
+        _mm_store_si128((__m128i*) index, _mm_sub_epi32(_mm_srli_epi32(bits, gainTableShift), _mm_set1_epi32(gainTableBias)));
+        Vec fraction = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(bits, _mm_set1_epi32(gainTableFractionMask))),
+                                  _mm_set1_ps(gainTableFractionScale));
+        Vec y0 = _mm_setr_ps(table[index[0]], table[index[1]], table[index[2]], table[index[3]]);
+        Vec y1 = _mm_setr_ps(table[index[0] + 1], table[index[1] + 1], table[index[2] + 1], table[index[3] + 1]);
+        return _mm_add_ps(y0, _mm_mul_ps(fraction, _mm_sub_ps(y1, y0)));
+    }
+
+    #include "CompressorKernelImpl.h"
+    #undef KERNEL_TARGET
+}
+#endif
+
+//==============================================================================
+// AVX2
+#if KERNEL_X86_DISPATCH
+namespace avx2
+{
+    #define KERNEL_TARGET __attribute__((target("avx2")))
+    using Vec = __m256;
+    using Mask = __m256;
+    constexpr int width = 8;
+
+    KERNEL_TARGET static inline Vec set1(float x) { return _mm256_set1_ps(x); }
+    KERNEL_TARGET static inline Vec load(const float* p) { return _mm256_loadu_ps(p); }
+    KERNEL_TARGET static inline void store(float* p, Vec x) { _mm256_storeu_ps(p, x); }
+    KERNEL_TARGET static inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    KERNEL_TARGET static inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    KERNEL_TARGET static inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    KERNEL_TARGET static inline Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+    KERNEL_TARGET static inline Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+    KERNEL_TARGET static inline Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+    KERNEL_TARGET static inline Mask lessThan(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    KERNEL_TARGET static inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+    KERNEL_TARGET static inline Vec exponentOf(Vec x) {
+        __m256i e = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+        return _mm256_cvtepi32_ps(_mm256_sub_epi32(e, _mm256_set1_epi32(126)));
+    }
+    KERNEL_TARGET static inline Vec mantissaOf(Vec x) {
+        __m256i m = _mm256_and_si256(_mm256_castps_si256(x), _mm256_set1_epi32(0x007fffff));
+        return _mm256_castsi256_ps(_mm256_or_si256(m, _mm256_set1_epi32(0x3f000000)));
+    }
+    KERNEL_TARGET static inline Vec roundToInt(Vec x) { return _mm256_cvtepi32_ps(_mm256_cvtps_epi32(x)); }
+    KERNEL_TARGET static inline Vec pow2(Vec n) {
+        __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+    }
+    using VecD = __m256d;
+    KERNEL_TARGET static inline VecD setD(double x) { return _mm256_set1_pd(x); }
+    KERNEL_TARGET static inline VecD loadD(const double* p) { return _mm256_loadu_pd(p); }
+    KERNEL_TARGET static inline void storeD(double* p, VecD x) { _mm256_storeu_pd(p, x); }
+    KERNEL_TARGET static inline VecD addD(VecD a, VecD b) { return _mm256_add_pd(a, b); }
+    KERNEL_TARGET static inline VecD subD(VecD a, VecD b) { return _mm256_sub_pd(a, b); }
+    KERNEL_TARGET static inline VecD mulD(VecD a, VecD b) { return _mm256_mul_pd(a, b); }
+    KERNEL_TARGET static inline VecD selectLessD(VecD a, VecD b, VecD x, VecD y) {
+        return _mm256_blendv_pd(y, x, _mm256_cmp_pd(a, b, _CMP_LT_OQ));
+    }
+    KERNEL_TARGET static inline VecD lowToDouble(Vec x) { return _mm256_cvtps_pd(_mm256_castps256_ps128(x)); }
+    KERNEL_TARGET static inline VecD highToDouble(Vec x) { return _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)); }
+    KERNEL_TARGET static inline Vec toFloat(VecD low, VecD high) {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+    }
+    KERNEL_TARGET static inline void transposeBlock(const float* in, int inStride, float* out, int outStride) {
+        __m256 r[8], t[8];
+        for (int k = 0; k < 8; k++)
+            r[k] = _mm256_loadu_ps(in + k*inStride);
+        for (int k = 0; k < 8; k += 2) {
+            t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+            t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+        }
+        // 4x4 blocks transposed within each 128 bit half
+        for (int k = 0; k < 8; k += 4) {
+            r[k] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+            r[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+            r[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+            r[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+        }
+        for (int k = 0; k < 4; k++) {
+            _mm256_storeu_ps(out + k*outStride, _mm256_permute2f128_ps(r[k], r[k + 4], 0x20));
+            _mm256_storeu_ps(out + (k + 4)*outStride, _mm256_permute2f128_ps(r[k], r[k + 4], 0x31));
+        }
+    }
+    KERNEL_TARGET static inline void transposeBlockD(const double* in, int inStride, double* out, int outStride) {
+        const __m256d r0 = _mm256_loadu_pd(in), r1 = _mm256_loadu_pd(in + inStride);
+        const __m256d r2 = _mm256_loadu_pd(in + 2*inStride), r3 = _mm256_loadu_pd(in + 3*inStride);
+        const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+        const __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+        _mm256_storeu_pd(out, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(out + outStride, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(out + 2*outStride, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(out + 3*outStride, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+    KERNEL_TARGET static inline Vec lookupGain(const float* table, Vec x) {
+        __m256i bits = _mm256_castps_si256(x);
+        __m256i index = _mm256_sub_epi32(_mm256_srli_epi32(bits, gainTableShift), _mm256_set1_epi32(gainTableBias));
+        Vec fraction = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(bits, _mm256_set1_epi32(gainTableFractionMask))),
+                                     _mm256_set1_ps(gainTableFractionScale));
+        Vec y0 = _mm256_i32gather_ps(table, index, 4);
+        Vec y1 = _mm256_i32gather_ps(table + 1, index, 4);
+        return _mm256_add_ps(y0, _mm256_mul_ps(fraction, _mm256_sub_ps(y1, y0)));
+    }
+
+    #include "CompressorKernelImpl.h"
+    #undef KERNEL_TARGET
+}
+
+//==============================================================================
+// AVX-512 (foundation only)
+namespace avx512
+{
+    #define KERNEL_TARGET __attribute__((target("avx512f")))
+    using Vec = __m512;
+    using Mask = __mmask16;
+    constexpr int width = 16;
+
+    KERNEL_TARGET static inline Vec set1(float x) { return _mm512_set1_ps(x); }
+    KERNEL_TARGET static inline Vec load(const float* p) { return _mm512_loadu_ps(p); }
+    KERNEL_TARGET static inline void store(float* p, Vec x) { _mm512_storeu_ps(p, x); }
+    KERNEL_TARGET static inline Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+    KERNEL_TARGET static inline Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+    KERNEL_TARGET static inline Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+    KERNEL_TARGET static inline Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+    KERNEL_TARGET static inline Vec min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+    KERNEL_TARGET static inline Vec max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+    KERNEL_TARGET static inline Mask lessThan(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    KERNEL_TARGET static inline Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+    KERNEL_TARGET static inline Vec exponentOf(Vec x) {
+        __m512i e = _mm512_srli_epi32(_mm512_castps_si512(x), 23);
+        return _mm512_cvtepi32_ps(_mm512_sub_epi32(e, _mm512_set1_epi32(126)));
+    }
+    KERNEL_TARGET static inline Vec mantissaOf(Vec x) {
+        __m512i m = _mm512_and_si512(_mm512_castps_si512(x), _mm512_set1_epi32(0x007fffff));
+        return _mm512_castsi512_ps(_mm512_or_si512(m, _mm512_set1_epi32(0x3f000000)));
+    }
+    KERNEL_TARGET static inline Vec roundToInt(Vec x) { return _mm512_cvtepi32_ps(_mm512_cvtps_epi32(x)); }
+    KERNEL_TARGET static inline Vec pow2(Vec n) {
+        __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+    }
+    using VecD = __m512d;
+    KERNEL_TARGET static inline VecD setD(double x) { return _mm512_set1_pd(x); }
+    KERNEL_TARGET static inline VecD loadD(const double* p) { return _mm512_loadu_pd(p); }
+    KERNEL_TARGET static inline void storeD(double* p, VecD x) { _mm512_storeu_pd(p, x); }
+    KERNEL_TARGET static inline VecD addD(VecD a, VecD b) { return _mm512_add_pd(a, b); }
+    KERNEL_TARGET static inline VecD subD(VecD a, VecD b) { return _mm512_sub_pd(a, b); }
+    KERNEL_TARGET static inline VecD mulD(VecD a, VecD b) { return _mm512_mul_pd(a, b); }
+    KERNEL_TARGET static inline VecD selectLessD(VecD a, VecD b, VecD x, VecD y) {
+        return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ), y, x);
+    }
+    KERNEL_TARGET static inline VecD lowToDouble(Vec x) { return _mm512_cvtps_pd(_mm512_castps512_ps256(x)); }
+    KERNEL_TARGET static inline VecD highToDouble(Vec x) {
+        return _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1)));
+    }
+    KERNEL_TARGET static inline Vec toFloat(VecD low, VecD high) {
+        __m512d packed = _mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(low)));
+        return _mm512_castpd_ps(_mm512_insertf64x4(packed, _mm256_castps_pd(_mm512_cvtpd_ps(high)), 1));
+    }
+    KERNEL_TARGET static inline void transposeBlock(const float* in, int inStride, float* out, int outStride) {
+        __m512 r[16], t[16];
+        for (int k = 0; k < 16; k++)
+            r[k] = _mm512_loadu_ps(in + k*inStride);
+        for (int k = 0; k < 16; k += 2) {
+            t[k] = _mm512_unpacklo_ps(r[k], r[k + 1]);
+            t[k + 1] = _mm512_unpackhi_ps(r[k], r[k + 1]);
+        }
+        // 4x4 blocks transposed within each 128 bit quarter: r[4q + m]
+        // holds rows 4q..4q+3 of columns m, 4 + m, 8 + m and 12 + m
+        for (int k = 0; k < 16; k += 4) {
+            r[k] = _mm512_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+            r[k + 1] = _mm512_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+            r[k + 2] = _mm512_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+            r[k + 3] = _mm512_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+        }
+        // then the quarters
+        for (int m = 0; m < 4; m++) {
+            const __m512 v0 = _mm512_shuffle_f32x4(r[m], r[4 + m], 0x44);
+            const __m512 v1 = _mm512_shuffle_f32x4(r[m], r[4 + m], 0xee);
+            const __m512 v2 = _mm512_shuffle_f32x4(r[8 + m], r[12 + m], 0x44);
+            const __m512 v3 = _mm512_shuffle_f32x4(r[8 + m], r[12 + m], 0xee);
+            _mm512_storeu_ps(out + m*outStride, _mm512_shuffle_f32x4(v0, v2, 0x88));
+            _mm512_storeu_ps(out + (4 + m)*outStride, _mm512_shuffle_f32x4(v0, v2, 0xdd));
+            _mm512_storeu_ps(out + (8 + m)*outStride, _mm512_shuffle_f32x4(v1, v3, 0x88));
+            _mm512_storeu_ps(out + (12 + m)*outStride, _mm512_shuffle_f32x4(v1, v3, 0xdd));
+        }
+    }
+    KERNEL_TARGET static inline void transposeBlockD(const double* in, int inStride, double* out, int outStride) {
+        __m512d r[8], t[8];
+        for (int k = 0; k < 8; k++)
+            r[k] = _mm512_loadu_pd(in + k*inStride);
+        // t[2p] holds the even columns of rows 2p and 2p + 1, a column per
+        // 128 bit quarter, t[2p + 1] the odd ones
+        for (int k = 0; k < 8; k += 2) {
+            t[k] = _mm512_unpacklo_pd(r[k], r[k + 1]);
+            t[k + 1] = _mm512_unpackhi_pd(r[k], r[k + 1]);
+        }
+        // r[m]: rows 0..3 of columns m and m + 4 (m < 4, in the order
+        // 0 2 1 3), r[4 + m] the same for rows 4..7
+        for (int k = 0; k < 8; k += 4) {
+            r[k] = _mm512_shuffle_f64x2(t[k], t[k + 2], 0x88);
+            r[k + 1] = _mm512_shuffle_f64x2(t[k], t[k + 2], 0xdd);
+            r[k + 2] = _mm512_shuffle_f64x2(t[k + 1], t[k + 3], 0x88);
+            r[k + 3] = _mm512_shuffle_f64x2(t[k + 1], t[k + 3], 0xdd);
+        }
+        const int columns[4] = { 0, 2, 1, 3 };
+        for (int m = 0; m < 4; m++) {
+            _mm512_storeu_pd(out + columns[m]*outStride, _mm512_shuffle_f64x2(r[m], r[4 + m], 0x88));
+            _mm512_storeu_pd(out + (columns[m] + 4)*outStride, _mm512_shuffle_f64x2(r[m], r[4 + m], 0xdd));
+        }
+    }
+    KERNEL_TARGET static inline Vec lookupGain(const float* table, Vec x) {
+        __m512i bits = _mm512_castps_si512(x);
+        __m512i index = _mm512_sub_epi32(_mm512_srli_epi32(bits, gainTableShift), _mm512_set1_epi32(gainTableBias));
+        Vec fraction = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_and_si512(bits, _mm512_set1_epi32(gainTableFractionMask))),
+                                     _mm512_set1_ps(gainTableFractionScale));
+        Vec y0 = _mm512_i32gather_ps(index, table, 4);
+        Vec y1 = _mm512_i32gather_ps(index, table + 1, 4);
+        return _mm512_add_ps(y0, _mm512_mul_ps(fraction, _mm512_sub_ps(y1, y0)));
+    }
+
+    #include "CompressorKernelImpl.h"
+    #undef KERNEL_TARGET
+}
+#endif
+
+//==============================================================================
+// NEON (always present on arm64)
+#if KERNEL_NEON
+namespace neon
+{
+    #define KERNEL_TARGET
+    using Vec = float32x4_t;
+    using Mask = uint32x4_t;
+    constexpr int width = 4;
+
+    static inline Vec set1(float x) { return vdupq_n_f32(x); }
+    static inline Vec load(const float* p) { return vld1q_f32(p); }
+    static inline void store(float* p, Vec x) { vst1q_f32(p, x); }
+    static inline Vec add(Vec a, Vec b) { return vaddq_f32(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return vsubq_f32(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+    static inline Vec div(Vec a, Vec b) { return vdivq_f32(a, b); }
+    static inline Vec min(Vec a, Vec b) { return vminq_f32(a, b); }
+    static inline Vec max(Vec a, Vec b) { return vmaxq_f32(a, b); }
+    static inline Mask lessThan(Vec a, Vec b) { return vcltq_f32(a, b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return vbslq_f32(m, a, b); }
+    static inline Vec exponentOf(Vec x) {
+        uint32x4_t e = vshrq_n_u32(vreinterpretq_u32_f32(x), 23);
+        return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(e), vdupq_n_s32(126)));
+    }
+    static inline Vec mantissaOf(Vec x) {
+        uint32x4_t m = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x007fffff));
+        return vreinterpretq_f32_u32(vorrq_u32(m, vdupq_n_u32(0x3f000000)));
+    }
+    static inline Vec roundToInt(Vec x) { return vcvtq_f32_s32(vcvtnq_s32_f32(x)); }
+    static inline Vec pow2(Vec n) {
+        int32x4_t e = vaddq_s32(vcvtnq_s32_f32(n), vdupq_n_s32(127));
+        return vreinterpretq_f32_s32(vshlq_n_s32(e, 23));
+    }
+    using VecD = float64x2_t;
+    static inline VecD setD(double x) { return vdupq_n_f64(x); }
+    static inline VecD loadD(const double* p) { return vld1q_f64(p); }
+    static inline void storeD(double* p, VecD x) { vst1q_f64(p, x); }
+    static inline VecD addD(VecD a, VecD b) { return vaddq_f64(a, b); }
+    static inline VecD subD(VecD a, VecD b) { return vsubq_f64(a, b); }
+    static inline VecD mulD(VecD a, VecD b) { return vmulq_f64(a, b); }
+    static inline VecD selectLessD(VecD a, VecD b, VecD x, VecD y) { return vbslq_f64(vcltq_f64(a, b), x, y); }
+    static inline VecD lowToDouble(Vec x) { return vcvt_f64_f32(vget_low_f32(x)); }
+    static inline VecD highToDouble(Vec x) { return vcvt_high_f64_f32(x); }
+    static inline Vec toFloat(VecD low, VecD high) { return vcvt_high_f32_f64(vcvt_f32_f64(low), high); }
+    static inline void transposeBlock(const float* in, int inStride, float* out, int outStride) {
+        const float32x4x2_t p01 = vtrnq_f32(vld1q_f32(in), vld1q_f32(in + inStride));
+        const float32x4x2_t p23 = vtrnq_f32(vld1q_f32(in + 2*inStride), vld1q_f32(in + 3*inStride));
+        vst1q_f32(out, vcombine_f32(vget_low_f32(p01.val[0]), vget_low_f32(p23.val[0])));
+        vst1q_f32(out + outStride, vcombine_f32(vget_low_f32(p01.val[1]), vget_low_f32(p23.val[1])));
+        vst1q_f32(out + 2*outStride, vcombine_f32(vget_high_f32(p01.val[0]), vget_high_f32(p23.val[0])));
+        vst1q_f32(out + 3*outStride, vcombine_f32(vget_high_f32(p01.val[1]), vget_high_f32(p23.val[1])));
+    }
+    static inline void transposeBlockD(const double* in, int inStride, double* out, int outStride) {
+        const float64x2_t r0 = vld1q_f64(in), r1 = vld1q_f64(in + inStride);
+        vst1q_f64(out, vzip1q_f64(r0, r1));
+        vst1q_f64(out + outStride, vzip2q_f64(r0, r1));
+    }
+    static inline Vec lookupGain(const float* table, Vec x) {
+        uint32x4_t bits = vreinterpretq_u32_f32(x);
+        int index[4];
+        vst1q_s32(index, vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, gainTableShift)), vdupq_n_s32(gainTableBias)));
+        Vec fraction = vmulq_f32(vcvtq_f32_u32(vandq_u32(bits, vdupq_n_u32(gainTableFractionMask))),
+                                 vdupq_n_f32(gainTableFractionScale));
+        const float y0Values[4] = { table[index[0]], table[index[1]], table[index[2]], table[index[3]] };
+        const float y1Values[4] = { table[index[0] + 1], table[index[1] + 1], table[index[2] + 1], table[index[3] + 1] };
+        Vec y0 = vld1q_f32(y0Values);
+        return vaddq_f32(y0, vmulq_f32(fraction, vsubq_f32(vld1q_f32(y1Values), y0)));
+    }
+
+    #include "CompressorKernelImpl.h"
+    #undef KERNEL_TARGET
+}
+#endif
+
+//==============================================================================
+namespace
+{
+    // samples per pass through the stages, sized to stay in L1
+    constexpr int chunkSize = 256;
+    constexpr int maxWidth = 16;
+
+    using FirFunction = void (*) (const float*, float*, int, const float*, int);
+
+    struct StageFunctions {
+        int width;
+        void (*power) (const float*, const float*, float*, int, float, float);
+        FirFunction fir;
+        void (*gainComputer) (float*, int, float, float, float, float);
+        void (*gainTable) (float*, int, float, const GainTable&);
+        void (*apply) (float*, float*, const float*, int, float, float, float, float);
+        void (*bands) (const float*, const float*, float*, float*, int, const BandCoeffs<float>&, BandState<float>&);
+        void (*bandsDouble) (const float*, const float*, double*, double*, int,
+                             const BandCoeffs<double>&, BandState<double>&);
+        void (*keyFilter) (const float*, float*, int, const KeyFilterCoeffs&, int, float&, float&);
+        float (*peak) (const float*, int);
+        void (*batch) (const float* const*, int, float* const*, int, const BatchCoeffs&, BatchState&);
+        void (*batchDouble) (const double* const*, int, double* const*, int, const BatchCoeffs&, BatchState&);
+    };
+
+    StageFunctions getStageFunctions(Isa isa) {
+        switch (isa) {
+           #if KERNEL_X86_DISPATCH
+            case Isa::avx512: return { avx512::width, avx512::powerStage, avx512::firStage, avx512::gainComputerStage,
+                                avx512::gainTableStage, avx512::applyStage, avx512::bandsStage, avx512::bandsStage,
+                                avx512::keyFilterStage, avx512::peakStage,
+                                avx512::batchStage, avx512::batchStage };
+            case Isa::avx2:   return { avx2::width, avx2::powerStage, avx2::firStage, avx2::gainComputerStage,
+                                avx2::gainTableStage, avx2::applyStage, avx2::bandsStage, avx2::bandsStage,
+                                avx2::keyFilterStage, avx2::peakStage,
+                                avx2::batchStage, avx2::batchStage };
+           #endif
+           #if KERNEL_X86
+            case Isa::sse2:   return { sse2::width, sse2::powerStage, sse2::firStage, sse2::gainComputerStage,
+                                sse2::gainTableStage, sse2::applyStage, sse2::bandsStage, sse2::bandsStage,
+                                sse2::keyFilterStage, sse2::peakStage,
+                                sse2::batchStage, sse2::batchStage };
+           #endif
+           #if KERNEL_NEON
+            case Isa::neon:   return { neon::width, neon::powerStage, neon::firStage, neon::gainComputerStage,
+                                neon::gainTableStage, neon::applyStage, neon::bandsStage, neon::bandsStage,
+                                neon::keyFilterStage, neon::peakStage,
+                                neon::batchStage, neon::batchStage };
+           #endif
+            default:          return { 0, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                       nullptr };
+        }
+    }
+
+    bool isSupported(Isa isa) {
+        if (isa == Isa::scalar)
+            return true;
+        if (getStageFunctions(isa).width == 0)
+            return false;
+       #if KERNEL_X86_DISPATCH
+        __builtin_cpu_init();
+        if (isa == Isa::avx512)
+            return __builtin_cpu_supports("avx512f");
+        if (isa == Isa::avx2)
+            return __builtin_cpu_supports("avx2");
+       #endif
+        return true;
+    }
+
+    // the bands (or a batch's compressors) share one vector, so wider
+    // registers than the band count only add idle lanes: step down to the
+    // narrowest set that holds them
+    Isa getBandsIsa(Isa isa, int numBands) {
+       #if KERNEL_X86_DISPATCH
+        if (isa == Isa::avx512 && numBands <= avx2::width)
+            isa = Isa::avx2;
+        if (isa == Isa::avx2 && numBands <= sse2::width)
+            isa = Isa::sse2;
+       #endif
+        return isa;
+    }
+
+    Isa detectIsa() {
+        for (Isa isa : { Isa::avx512, Isa::avx2, Isa::sse2, Isa::neon })
+            if (isSupported(isa))
+                return isa;
+        return Isa::scalar;
+    }
+
+    std::atomic<Isa> selectedIsa { detectIsa() };
+
+    //==============================================================================
+    // oversampled detector: one or two 2x half-band interpolators (Kaiser
+    // windowed sinc, 47 taps for the first, 15 for the second, >53 dB stop
+    // band, <0.01 dB ripple up to 0.4 fs). Only the non-trivial polyphase
+    // branch is filtered, the other one is the input delayed, and only half
+    // of each symmetric branch is stored.
+    constexpr int upsampleTaps1 = 24;
+    constexpr int upsampleTaps2 = 8;
+    const float upsampleCoeffs1[upsampleTaps1/2] = {
+        -5.660827480e-04f, 1.760104988e-03f, -3.886837061e-03f, 7.323934569e-03f,
+        -1.254497381e-02f, 2.017995364e-02f, -3.116426616e-02f, 4.711509691e-02f,
+        -7.138569118e-02f, 1.126813055e-01f, -2.031577904e-01f, 6.336452457e-01f
+    };
+    const float upsampleCoeffs2[upsampleTaps2/2] = {
+        -1.857236073e-03f, 2.824751119e-02f, -1.296500103e-01f, 6.032597352e-01f
+    };
+
+    static_assert(sizeof(State::upsampleHistory1[0])/sizeof(float) == upsampleTaps1 - 1, "history size");
+    static_assert(sizeof(State::upsampleHistory2[0])/sizeof(float) == upsampleTaps2 - 1, "history size");
+
+    // base rate samples per pass, keeps the oversampled buffers small
+    constexpr int oversampleChunk = 64;
+
+    void powerScalar(const float* keyLeft, const float* keyRight, float* power,
+                     int numSamples, float preGainLinear, float preGainStep) {
+        for (int i = 0; i < numSamples; i++) {
+            const float gain = preGainLinear + i*preGainStep;
+            const float l = keyLeft[i]*gain;
+            const float r = keyRight[i]*gain;
+            power[i] = 0.5f*(l*l + r*r);
+        }
+    }
+
+    void firScalar(const float* x, float* y, int numSamples, const float* halfTaps, int numTaps) {
+        for (int i = 0; i < numSamples; i++) {
+            float acc = 0;
+            for (int k = 0; k < numTaps/2; k++)
+                acc += halfTaps[k]*(x[i + k] + x[i + numTaps - 1 - k]);
+            y[i] = acc;
+        }
+    }
+
+    // detector input for each sample: the largest mean of the squared
+    // channels among the 2 or 4 interpolated points around it, so that
+    // inter-sample peaks reach the detector. A mono key (KeyChannels 1) is
+    // only interpolated once, from keyLeft
+    template <int Factor, int KeyChannels>
+    void oversampledPower(const StageFunctions& f, const float* keyLeft, const float* keyRight,
+                          float* power, int numSamples, float preGainLinear, float preGainStep,
+                          State& s) {
+        constexpr int history1 = upsampleTaps1 - 1;
+        constexpr int history2 = upsampleTaps2 - 1;
+        alignas(64) float x[history1 + oversampleChunk + maxWidth];
+        alignas(64) float y[oversampleChunk + maxWidth];
+        alignas(64) float u[2][history2 + 2*oversampleChunk + maxWidth]; // 2x
+        alignas(64) float w[2*oversampleChunk + maxWidth];
+        alignas(64) float v[2][4*oversampleChunk + maxWidth];           // 4x
+        alignas(64) float q[4*oversampleChunk + maxWidth];
+
+        for (int start = 0; start < numSamples; start += oversampleChunk) {
+            const int n = std::min(oversampleChunk, numSamples - start);
+            const int padded = (n + f.width - 1)/f.width*f.width;
+            const int padded2 = (2*n + f.width - 1)/f.width*f.width;
+            const float preGain = preGainLinear + start*preGainStep;
+            const float* key[2] = { keyLeft + start, keyRight + start };
+
+            for (int ch = 0; ch < KeyChannels; ch++) {
+                // first 2x: FIR branch at n - 11.5, delayed input at n - 11
+                std::copy(s.upsampleHistory1[ch], s.upsampleHistory1[ch] + history1, x);
+                for (int i = 0; i < n; i++)
+                    x[history1 + i] = key[ch][i]*(preGain + i*preGainStep);
+                std::fill(x + history1 + n, x + history1 + padded, 0.0f);
+                f.fir(x, y, padded, upsampleCoeffs1, upsampleTaps1);
+                std::copy(x + n, x + n + history1, s.upsampleHistory1[ch]);
+
+                float* up = u[ch] + history2;
+                for (int i = 0; i < n; i++) {
+                    up[2*i] = y[i];
+                    up[2*i + 1] = x[i + history1 - 11];
+                }
+                std::fill(up + 2*n, up + padded2, 0.0f);
+                if (Factor == 2)
+                    continue;
+
+                // second 2x on top, another 1.75 samples of delay
+                std::copy(s.upsampleHistory2[ch], s.upsampleHistory2[ch] + history2, u[ch]);
+                f.fir(u[ch], w, padded2, upsampleCoeffs2, upsampleTaps2);
+                std::copy(u[ch] + 2*n, u[ch] + 2*n + history2, s.upsampleHistory2[ch]);
+                for (int i = 0; i < 2*n; i++) {
+                    v[ch][2*i] = w[i];
+                    v[ch][2*i + 1] = u[ch][i + history2 - 3];
+                }
+            }
+
+            // mean square at every interpolated point, then the largest per sample
+            const int m = Factor*n;
+            const float* l = Factor == 2 ? u[0] + history2 : v[0];
+            const float* r = Factor == 2 ? u[KeyChannels - 1] + history2 : v[KeyChannels - 1];
+            const int vectorEnd = m - m % f.width;
+            f.power(l, r, q, vectorEnd, 1.0f, 0.0f);
+            powerScalar(l + vectorEnd, r + vectorEnd, q + vectorEnd, m - vectorEnd, 1.0f, 0.0f);
+            for (int i = 0; i < n; i++) {
+                float p = q[Factor*i];
+                for (int k = 1; k < Factor; k++)
+                    p = std::max(p, q[Factor*i + k]);
+                power[start + i] = p;
+            }
+        }
+    }
+
+    float peakScalar(const float* x, int numSamples) {
+        float peak = 0;
+        for (int i = 0; i < numSamples; i++)
+            peak = std::max(peak, std::abs(x[i]));
+        return peak;
+    }
+
+    const StageFunctions scalarStages { 1, powerScalar, firScalar, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, peakScalar,
+                                        nullptr, nullptr };
+
+    // one key filter biquad the plain way, for Isa::scalar and vector tails
+    void keyFilterScalar(const float* x, float* y, int numSamples,
+                         const KeyFilterCoeffs& c, int stage, float& z1, float& z2) {
+        for (int i = 0; i < numSamples; i++) {
+            const float in = x[i];
+            const float out = c.b0[stage]*in + z1;
+            z1 = c.b1[stage]*in + z2 - c.a1[stage]*out;
+            z2 = c.b2[stage]*in - c.a2[stage]*out;
+            y[i] = out;
+        }
+    }
+
+    // a gain this close to 1 has settled there (-170 dB away)
+    constexpr double settledGainDistance = 1.0e-9;
+
+    // a control rate detector level this low (-200 dB) has died away
+    double settledLevel(double level) {
+        return level < 1.0e-20 ? 0 : level;
+    }
+
+    // the detector level now, while at control rate: its level at the last
+    // control point kept over the samples since, plus their weighted power
+    // (weighted for the end of the interval, so moved back to now)
+    double controlRateLevel(const State& s, double envB0) {
+        if (s.controlInterval == 0 || s.controlPosition == 0)
+            return s.envOut;
+        const double keep = 1 - envB0;
+        return s.envOut*std::pow(keep, s.controlPosition)
+               + s.controlSum*std::pow(keep, s.controlPosition - s.controlInterval);
+    }
+
+    // true once a silent key has brought the control rate detector to 0
+    // and the gain to 1, where the silent fast path carries on from
+    bool isControlRateAtRest(const State& s, const ControlRate& rate) {
+        return s.controlInterval == rate.interval && s.envOut == 0 && s.controlSum == 0
+               && s.controlGain == 1 && s.gainStep == 0;
+    }
+
+    // back to a per-sample detector and gain from wherever the control rate
+    // left them, also before another interval takes over
+    void leaveControlRate(State& s, double envB0) {
+        s.envOut = controlRateLevel(s, envB0);
+        s.controlInterval = 0;
+        s.controlPosition = 0;
+        s.controlSum = 0;
+        s.controlGain = s.gainOutLinear;
+        s.gainStep = 0;
+    }
+
+    // the original per-sample loop, kept as the reference path. detectorPower
+    // replaces the mean of the squared key channels when not null
+    template <typename Sample>
+    void processScalar(const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                       int numSamples, const Coeffs& c, State& s,
+                       const float* detectorPower = nullptr) {
+        float leftSquared, rightSquared, rmsEnvelopeLin,
+            preDynamicsGainDb, preDynamicsGainLinear,
+            leftIn, rightIn;
+        double gainCoeff;
+        Sample finalGainLinear;
+
+        for (int samp = 0; samp < numSamples; samp++) {
+            // parameter ramps
+            const float preGainLinear = c.preGainLinear + samp*c.preGainStep;
+            const float postGainLinear = c.postGainLinear + samp*c.postGainStep;
+            const float thresholdDb = c.thresholdDb + samp*c.thresholdStep;
+            const float ratio = c.ratio + samp*c.ratioStep;
+
+            // pre gain
+            leftIn = keyLeft[samp]*preGainLinear;
+            rightIn = keyRight[samp]*preGainLinear;
+
+            // RMS level detector
+            leftSquared = leftIn*leftIn;
+            rightSquared = rightIn*rightIn;
+            rmsEnvelopeLin = detectorPower != nullptr ? detectorPower[samp] : 0.5*(leftSquared + rightSquared);
+            s.envOut += c.envB0*(rmsEnvelopeLin - s.envOut); // leaky integrator
+            rmsEnvelopeLin = sqrt(s.envOut);
+            s.rmsEnvelopeDb = 20*log10(rmsEnvelopeLin);
+
+            // gain calculation
+            if (s.rmsEnvelopeDb <= thresholdDb) {
+                preDynamicsGainDb = 0;
+            } else {
+                preDynamicsGainDb = (1.0/ratio - 1)*(s.rmsEnvelopeDb - thresholdDb);
+            }
+            preDynamicsGainLinear = pow(10,preDynamicsGainDb/20.0);
+
+            // gain dynamics
+            if (preDynamicsGainLinear < s.gainOutLinear) {
+                gainCoeff = c.attackCoeff;
+            } else {
+                gainCoeff = c.releaseCoeff;
+            }
+            s.gainOutLinear += gainCoeff*(preDynamicsGainLinear - s.gainOutLinear); // leaky integrator
+            s.minGainLinear = std::min(s.minGainLinear, (float) s.gainOutLinear);
+            s.maxGainLinear = std::max(s.maxGainLinear, (float) s.gainOutLinear);
+
+            // post gain
+            finalGainLinear = s.gainOutLinear*postGainLinear;
+
+            // apply gain to outputs
+            left[samp] = finalGainLinear*(left[samp]*preGainLinear);
+            right[samp] = finalGainLinear*(right[samp]*preGainLinear);
+        }
+    }
+
+    // processScalar with the detector and gain computer at control rate,
+    // one sample at a time: the reference for controlRateGains
+    template <typename Sample>
+    void processScalarControlRate(const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                                  int numSamples, const Coeffs& c, const ControlRate& rate, State& s,
+                                  const float* detectorPower = nullptr) {
+        const int interval = rate.interval;
+        auto gainComputer = [&c](double level, int samp) {
+            const float thresholdDb = c.thresholdDb + samp*c.thresholdStep;
+            const float ratio = c.ratio + samp*c.ratioStep;
+            const float levelDb = 20*log10(sqrt((float) level));
+            const float gainDb = levelDb <= thresholdDb ? 0 : (1.0/ratio - 1)*(levelDb - thresholdDb);
+            return (double) (float) pow(10, gainDb/20.0);
+        };
+        auto control = [&s, &rate, interval](double target) {
+            const double coeff = target < s.controlGain ? rate.attackCoeff : rate.releaseCoeff;
+            s.gainStep = coeff*(target - s.controlGain)/interval;
+        };
+
+        // coming from per-sample processing or another interval, the first
+        // control point is just before sample 0
+        if (s.controlInterval != interval) {
+            leaveControlRate(s, c.envB0);
+            s.controlInterval = interval;
+            control(gainComputer(s.envOut, -1));
+        }
+
+        for (int samp = 0; samp < numSamples; samp++) {
+            const float preGainLinear = c.preGainLinear + samp*c.preGainStep;
+            const float postGainLinear = c.postGainLinear + samp*c.postGainStep;
+
+            // RMS level detector, a weighted sum over the interval
+            const float leftIn = keyLeft[samp]*preGainLinear;
+            const float rightIn = keyRight[samp]*preGainLinear;
+            const float power = detectorPower != nullptr ? detectorPower[samp]
+                                                         : 0.5f*(leftIn*leftIn + rightIn*rightIn);
+            s.controlSum += rate.envWeights[s.controlPosition++]*power;
+
+            // gain ramp, and the next one at a control point
+            const Sample gainLinear = (Sample) (s.controlGain + s.controlPosition*s.gainStep);
+            s.gainOutLinear = s.controlGain + s.controlPosition*s.gainStep;
+            s.minGainLinear = std::min(s.minGainLinear, (float) s.gainOutLinear);
+            s.maxGainLinear = std::max(s.maxGainLinear, (float) s.gainOutLinear);
+            if (s.controlPosition == interval) {
+                s.envOut = settledLevel(rate.envDecay*s.envOut + s.controlSum);
+                s.controlSum = 0;
+                s.controlPosition = 0;
+                s.controlGain += interval*s.gainStep;
+                if (std::abs(1 - s.controlGain) < settledGainDistance)
+                    s.controlGain = 1;
+                s.gainOutLinear = s.controlGain;
+                control(gainComputer(s.envOut, samp));
+            }
+
+            // post gain, apply
+            const Sample finalGainLinear = gainLinear*postGainLinear;
+            left[samp] = finalGainLinear*(left[samp]*preGainLinear);
+            right[samp] = finalGainLinear*(right[samp]*preGainLinear);
+        }
+        s.rmsEnvelopeDb = 10*log10(std::max(s.envOut, 1.0e-20));
+    }
+
+    template <typename Sample>
+    void processScalarOversampled(const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                                  int numSamples, const Coeffs& c, const ControlRate* rate, State& s) {
+        float power[chunkSize];
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            const int n = std::min(chunkSize, numSamples - start);
+
+            // ramps continue from the previous chunk
+            Coeffs chunk = c;
+            chunk.preGainLinear += start*c.preGainStep;
+            chunk.postGainLinear += start*c.postGainStep;
+            chunk.thresholdDb += start*c.thresholdStep;
+            chunk.ratio += start*c.ratioStep;
+
+            if (c.oversampling == 2)
+                oversampledPower<2, 2>(scalarStages, keyLeft + start, keyRight + start, power, n,
+                                       chunk.preGainLinear, c.preGainStep, s);
+            else
+                oversampledPower<4, 2>(scalarStages, keyLeft + start, keyRight + start, power, n,
+                                       chunk.preGainLinear, c.preGainStep, s);
+            if (rate != nullptr)
+                processScalarControlRate(keyLeft + start, keyRight + start, left + start, right + start,
+                                         n, chunk, *rate, s, power);
+            else
+                processScalar(keyLeft + start, keyRight + start, left + start, right + start,
+                              n, chunk, s, power);
+        }
+    }
+
+    // reference for the bands stage, one band at a time with the
+    // original maths
+    template <typename Sample>
+    void processBandsScalar(const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                            int numSamples, const BandCoeffs<Sample>& c, BandState<Sample>& s) {
+        const bool separateKey = keyLeft != nullptr
+                                 && ((const void*) keyLeft != left || (const void*) keyRight != right);
+        auto biquad = [&c](Sample x, int stage, int band, Sample& z1, Sample& z2) {
+            const Sample y = c.b0[stage][band]*x + z1;
+            z1 = c.b1[stage][band]*x + z2 - c.a1[stage][band]*y;
+            z2 = c.b2[stage][band]*x - c.a2[stage][band]*y;
+            return y;
+        };
+
+        for (int samp = 0; samp < numSamples; samp++) {
+            const float pre = c.preGainLinear + samp*c.preGainStep;
+            Sample sumLeft = 0;
+            Sample sumRight = 0;
+            for (int b = 0; b < c.numBands; b++) {
+                Sample l = left[samp]*pre;
+                Sample r = right[samp]*pre;
+                Sample kl = separateKey ? keyLeft[samp]*pre : l;
+                Sample kr = separateKey ? keyRight[samp]*pre : r;
+                for (int st = 0; st < c.numStages; st++) {
+                    l = biquad(l, st, b, s.z1[0][st][b], s.z2[0][st][b]);
+                    r = biquad(r, st, b, s.z1[1][st][b], s.z2[1][st][b]);
+                    if (separateKey) {
+                        kl = biquad(kl, st, b, s.keyZ1[0][st][b], s.keyZ2[0][st][b]);
+                        kr = biquad(kr, st, b, s.keyZ1[1][st][b], s.keyZ2[1][st][b]);
+                    }
+                }
+                if (!separateKey) {
+                    kl = l;
+                    kr = r;
+                }
+
+                s.envOut[b] += c.envB0*((Sample) 0.5*(kl*kl + kr*kr) - s.envOut[b]);
+                const float levelDb = 10*log10(std::max(s.envOut[b], 1.0e-20));
+                const float thresholdDb = c.thresholdDb[b] + samp*c.thresholdStep[b];
+                const float ratio = c.ratio[b] + samp*c.ratioStep[b];
+                const float gainDb = levelDb <= thresholdDb ? 0 : (1.0/ratio - 1)*(levelDb - thresholdDb);
+                const float target = pow(10, gainDb/20.0);
+
+                const double coeff = target < s.gainOutLinear[b] ? c.attackCoeff[b] : c.releaseCoeff[b];
+                s.gainOutLinear[b] += coeff*(target - s.gainOutLinear[b]);
+
+                const Sample gain = (Sample) s.gainOutLinear[b];
+                s.minGainLinear[b] = std::min(s.minGainLinear[b], (float) gain);
+                s.maxGainLinear[b] = std::max(s.maxGainLinear[b], (float) gain);
+                sumLeft += l*gain;
+                sumRight += r*gain;
+            }
+            const float post = c.postGainLinear + samp*c.postGainStep;
+            left[samp] = sumLeft*post;
+            right[samp] = sumRight*post;
+        }
+    }
+
+    // a stereo lane of the batch reference. The key of double audio goes
+    // to processScalar as a float copy, a chunk at a time
+    void processScalarLane(const float* keyLeft, const float* keyRight, float* left, float* right,
+                           int numSamples, const Coeffs& c, State& s) {
+        processScalar(keyLeft, keyRight, left, right, numSamples, c, s);
+    }
+
+    void processScalarLane(const double* keyLeft, const double* keyRight, double* left, double* right,
+                           int numSamples, const Coeffs& c, State& s) {
+        float keyCopy[2][chunkSize];
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            const int n = std::min(chunkSize, numSamples - start);
+            for (int i = 0; i < n; i++) {
+                keyCopy[0][i] = (float) keyLeft[start + i];
+                keyCopy[1][i] = (float) keyRight[start + i];
+            }
+            Coeffs chunk = c;
+            chunk.preGainLinear += start*c.preGainStep;
+            chunk.postGainLinear += start*c.postGainStep;
+            chunk.thresholdDb += start*c.thresholdStep;
+            chunk.ratio += start*c.ratioStep;
+            processScalar(keyCopy[0], keyCopy[1], left + start, right + start, n, chunk, s);
+        }
+    }
+
+    // reference for the batch stage, one compressor at a time
+    template <typename Sample>
+    void processBatchScalar(const Sample* const* keyChannels, int numKeyChannels, Sample* const* channels,
+                            int numSamples, const BatchCoeffs& coeffs, BatchState& state) {
+        Sample* const* lane = channels;
+        for (int k = 0; k < coeffs.numLanes; lane += coeffs.laneChannels[k], k++) {
+            Coeffs c;
+            c.preGainLinear = coeffs.preGainLinear[k];
+            c.postGainLinear = coeffs.postGainLinear[k];
+            c.envB0 = coeffs.envB0;
+            c.attackCoeff = coeffs.attackCoeff[k];
+            c.releaseCoeff = coeffs.releaseCoeff[k];
+            c.thresholdDb = coeffs.thresholdDb[k];
+            c.ratio = coeffs.ratio[k];
+            c.preGainStep = coeffs.preGainStep[k];
+            c.postGainStep = coeffs.postGainStep[k];
+            c.thresholdStep = coeffs.thresholdStep[k];
+            c.ratioStep = coeffs.ratioStep[k];
+
+            State s;
+            s.envOut = state.envOut[k];
+            s.gainOutLinear = state.gainOutLinear[k];
+            s.minGainLinear = state.minGainLinear[k];
+            s.maxGainLinear = state.maxGainLinear[k];
+            const int numChannels = coeffs.laneChannels[k];
+            const Sample* const* key = numKeyChannels > 0 ? keyChannels : lane;
+            const int numKey = numKeyChannels > 0 ? numKeyChannels : numChannels;
+            if (numChannels == 2 && numKey <= 2) {
+                processScalarLane(key[0], key[numKey - 1], lane[0], lane[1], numSamples, c, s);
+            } else {
+                // the detector hears the mean square of all the key channels, and
+                // every pair of the lane's starts from the same state, so gets the
+                // same gains (a mono channel is paired with a silent spare)
+                float power[chunkSize];
+                Sample spare[chunkSize];
+                for (int start = 0; start < numSamples; start += chunkSize) {
+                    const int n = std::min(chunkSize, numSamples - start);
+                    Coeffs chunk = c;
+                    chunk.preGainLinear += start*c.preGainStep;
+                    chunk.postGainLinear += start*c.postGainStep;
+                    chunk.thresholdDb += start*c.thresholdStep;
+                    chunk.ratio += start*c.ratioStep;
+
+                    if (numKey <= 2) {
+                        // as processScalar's key
+                        for (int i = 0; i < n; i++) {
+                            const float gain = chunk.preGainLinear + i*c.preGainStep;
+                            const float keyL = (float) key[0][start + i]*gain;
+                            const float keyR = (float) key[numKey - 1][start + i]*gain;
+                            power[i] = 0.5f*(keyL*keyL + keyR*keyR);
+                        }
+                    } else {
+                        std::fill(power, power + n, 0.0f);
+                        for (int ch = 0; ch < numKey; ch++) {
+                            for (int i = 0; i < n; i++) {
+                                const float x = (float) key[ch][start + i]*(chunk.preGainLinear + i*c.preGainStep);
+                                power[i] += x*x;
+                            }
+                        }
+                        for (int i = 0; i < n; i++)
+                            power[i] *= 1.0f/numKey;
+                    }
+
+                    const State chunkStart = s;
+                    for (int ch = 0; ch < numChannels; ch += 2) {
+                        s = chunkStart;
+                        Sample* left = lane[ch] + start;
+                        Sample* right = spare;
+                        if (ch + 1 < numChannels)
+                            right = lane[ch + 1] + start;
+                        else
+                            std::fill(spare, spare + n, (Sample) 0);
+                        // with detectorPower the key is not heard
+                        processScalar(power, power, left, right, n, chunk, s, power);
+                    }
+                }
+            }
+            state.envOut[k] = s.envOut;
+            state.gainOutLinear[k] = s.gainOutLinear;
+            state.rmsEnvelopeDb[k] = s.rmsEnvelopeDb;
+            state.minGainLinear[k] = s.minGainLinear;
+            state.maxGainLinear[k] = s.maxGainLinear;
+        }
+    }
+
+    // pre gain + post gain + apply, vectorized for float audio and plain
+    // scalar maths for double. Returns how many samples were done
+    int applyGains(const StageFunctions& f, float* left, float* right, const float* gains, int numSamples,
+                   float preGain, float preGainStep, float postGain, float postGainStep) {
+        f.apply(left, right, gains, numSamples, preGain, preGainStep, postGain, postGainStep);
+        return numSamples;
+    }
+
+    int applyGains(const StageFunctions&, double*, double*, const double*, int, float, float, float, float) {
+        return 0;
+    }
+
+    // the reference for any configuration, rate is null for a per-sample
+    // detector and gain
+    template <typename Sample>
+    void processReference(const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                          int numSamples, const Coeffs& c, const ControlRate* rate, State& s) {
+        if (c.oversampling > 1)
+            processScalarOversampled(keyLeft, keyRight, left, right, numSamples, c, rate, s);
+        else if (rate != nullptr)
+            processScalarControlRate(keyLeft, keyRight, left, right, numSamples, c, *rate, s);
+        else
+            processScalar(keyLeft, keyRight, left, right, numSamples, c, s);
+    }
+
+    // control rate detector, gain computer and gain dynamics of processLoop
+    // for one chunk, power in and gains out. The detector sums each
+    // interval's power with the weights that carry it to the interval's
+    // end, and adds that to what is left of the level before at the control
+    // point (the sum of an interval cut by a chunk boundary is carried in
+    // the state, so the result doesn't depend on the block sizes). The gain
+    // computer and the gain integrator only run at the control points, and
+    // the gain ramps in a straight line to where the integrator gets to by
+    // the next one. start is the chunk's position in the block, for the ramps
+    template <Curve curve, typename Sample>
+    void controlRateGains(const StageFunctions& f, const float* power, Sample* gains, int numSamples, int start,
+                          float thresholdScale, const Coeffs& c, const ControlRate& rate, State& s) {
+        const int interval = rate.interval;
+        alignas(64) float controls[chunkSize + 1 + maxWidth];   // detector level at each control point
+        float sums[chunkSize/2];
+        int numControls = 0;
+
+        // coming from per-sample processing or another interval, the first
+        // control point is now, just before sample 0
+        const bool entering = s.controlInterval != interval;
+        if (entering) {
+            leaveControlRate(s, c.envB0);
+            s.controlInterval = interval;
+            controls[numControls++] = (float) s.envOut;
+        }
+        const int firstPosition = s.controlPosition;
+
+        // detector, the interval in progress first
+        double env = s.envOut;
+        float sum = s.controlSum;
+        int position = firstPosition;
+        const int head = std::min(interval - position, numSamples);
+        for (int i = 0; i < head; i++)
+            sum += rate.envWeights[position + i]*power[i];
+        position += head;
+        if (position == interval) {
+            env = settledLevel(rate.envDecay*env + sum);
+            controls[numControls++] = (float) env;
+            sum = 0;
+            position = 0;
+        }
+        const int numWhole = (numSamples - head)/interval;
+        const float* whole = power + head;
+        std::fill(sums, sums + numWhole, 0.0f);
+        for (int k = 0; k < interval; k++) {
+            const float weight = rate.envWeights[k];
+            for (int j = 0; j < numWhole; j++)
+                sums[j] += weight*whole[j*interval + k];
+        }
+        for (int j = 0; j < numWhole; j++) {
+            env = settledLevel(rate.envDecay*env + sums[j]);
+            controls[numControls++] = (float) env;
+        }
+        for (int i = head + numWhole*interval; i < numSamples; i++)
+            sum += rate.envWeights[position++]*power[i];
+        s.envOut = env;
+        s.controlSum = sum;
+        s.controlPosition = position;
+
+        // dB conversion + gain computer at the control points
+        const int first = entering ? -1 : interval - firstPosition - 1;
+        const int paddedControls = (numControls + f.width - 1)/f.width*f.width;
+        std::fill(controls + numControls, controls + paddedControls, 0.0f);
+        if (curve == Curve::table)
+            f.gainTable(controls, paddedControls, thresholdScale, *c.gainTable);
+        else if (curve == Curve::ramped)
+            f.gainComputer(controls, paddedControls, c.thresholdDb + (start + first)*c.thresholdStep,
+                           interval*c.thresholdStep, c.ratio + (start + first)*c.ratioStep, interval*c.ratioStep);
+        else
+            f.gainComputer(controls, paddedControls, c.thresholdDb, 0, c.ratio, 0);
+
+        // gain dynamics, a step per control point and a ramp in between,
+        // always from the gain at the last control point. The ramps are
+        // straight, so the gain's range is that of their ends
+        double gain = s.controlGain;
+        double step = s.gainStep;
+        float minGain = s.minGainLinear;
+        float maxGain = s.maxGainLinear;
+        int next = 0;
+        auto control = [&]() {
+            const double target = controls[next++];
+            const double coeff = target < gain ? rate.attackCoeff : rate.releaseCoeff;
+            step = coeff*(target - gain)/interval;
+        };
+        if (entering)
+            control();
+        position = firstPosition;
+        for (int i = 0; i < numSamples;) {
+            const int n = std::min(interval - position, numSamples - i);
+            for (int k = 0; k < n; k++)
+                gains[i + k] = (Sample) (gain + (position + k + 1)*step);
+            i += n;
+            position += n;
+            if (position == interval) {
+                gain += interval*step;
+                if (std::abs(1 - gain) < settledGainDistance)
+                    gain = 1;
+                minGain = std::min(minGain, (float) gain);
+                maxGain = std::max(maxGain, (float) gain);
+                position = 0;
+                control();
+            }
+        }
+        s.controlGain = gain;
+        s.gainStep = step;
+        s.gainOutLinear = gain + position*step;
+        s.minGainLinear = std::min(minGain, (float) s.gainOutLinear);
+        s.maxGainLinear = std::max(maxGain, (float) s.gainOutLinear);
+    }
+
+    // the staged block loop for one configuration: the detector's
+    // oversampling, the key's channel count and the static curve are
+    // compile time constants, so the only run time choices left are the
+    // instruction set (once per call) and attack or release (a select)
+    template <int Oversampling, int KeyChannels, Curve curve, typename Sample>
+    void processLoop(const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                     int numSamples, const Coeffs& c, State& s) {
+        if (KeyChannels == 1)
+            keyRight = keyLeft;
+        const Isa isa = activeIsa();
+        const ControlRate* rate = c.controlRate != nullptr && c.controlRate->interval > 1 ? c.controlRate : nullptr;
+        if (rate == nullptr && s.controlInterval != 0)
+            leaveControlRate(s, c.envB0);
+        if (isa == Isa::scalar) {
+            processReference(keyLeft, keyRight, left, right, numSamples, c, rate, s);
+            return;
+        }
+        const StageFunctions f = getStageFunctions(isa);
+
+        // value of a parameter ramp at sample i, constant unless ramping
+        auto at = [](float value, float step, int i) {
+            return curve == Curve::ramped ? value + i*step : value;
+        };
+        const float preGainStep = curve == Curve::ramped ? c.preGainStep : 0;
+        const float postGainStep = curve == Curve::ramped ? c.postGainStep : 0;
+        const float thresholdScale = curve == Curve::table ? (float) std::pow(10, -c.thresholdDb/10) : 0;
+
+        alignas(64) float buffer[chunkSize + maxWidth];
+        alignas(64) Sample gains[chunkSize];
+
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            const float* kl = keyLeft + start;
+            const float* kr = keyRight + start;
+            Sample* l = left + start;
+            Sample* r = right + start;
+            const int n = std::min(chunkSize, numSamples - start);
+            const int vectorEnd = n - n % f.width;
+
+            // ramps continue from the previous chunk
+            const float preGain = at(c.preGainLinear, c.preGainStep, start);
+            const float postGain = at(c.postGainLinear, c.postGainStep, start);
+
+            // pre gain + squaring, the tail is plain scalar maths
+            if (Oversampling > 1) {
+                oversampledPower<Oversampling, KeyChannels>(f, kl, kr, buffer, n, preGain, preGainStep, s);
+            } else {
+                f.power(kl, kr, buffer, vectorEnd, preGain, preGainStep);
+                for (int i = vectorEnd; i < n; i++) {
+                    const float gain = at(preGain, preGainStep, i);
+                    const float keyL = kl[i]*gain;
+                    const float keyR = kr[i]*gain;
+                    buffer[i] = 0.5f*(keyL*keyL + keyR*keyR);
+                }
+            }
+
+            if (rate != nullptr) {
+                controlRateGains<curve>(f, buffer, gains, n, start, thresholdScale, c, *rate, s);
+            } else {
+                // RMS detector
+                double env = s.envOut;
+                for (int i = 0; i < n; i++) {
+                    env += c.envB0*(buffer[i] - env); // leaky integrator
+                    buffer[i] = (float) env;
+                }
+                s.envOut = env;
+
+                // dB conversion + gain computer, padded up to a whole vector
+                for (int i = n; i < vectorEnd + f.width; i++)
+                    buffer[i] = 0;
+                const int paddedEnd = n == vectorEnd ? n : vectorEnd + f.width;
+                if (curve == Curve::table)
+                    f.gainTable(buffer, paddedEnd, thresholdScale, *c.gainTable);
+                else if (curve == Curve::ramped)
+                    f.gainComputer(buffer, paddedEnd, at(c.thresholdDb, c.thresholdStep, start), c.thresholdStep,
+                                   at(c.ratio, c.ratioStep, start), c.ratioStep);
+                else
+                    f.gainComputer(buffer, paddedEnd, c.thresholdDb, 0, c.ratio, 0);
+
+                // gain dynamics
+                double gain = s.gainOutLinear;
+                float minGain = s.minGainLinear;
+                float maxGain = s.maxGainLinear;
+                for (int i = 0; i < n; i++) {
+                    const double coeff = buffer[i] < gain ? c.attackCoeff : c.releaseCoeff;
+                    gain += coeff*(buffer[i] - gain); // leaky integrator
+                    gains[i] = (Sample) gain;
+                    minGain = std::min(minGain, (float) gain);
+                    maxGain = std::max(maxGain, (float) gain);
+                }
+                s.gainOutLinear = gain;
+                s.minGainLinear = minGain;
+                s.maxGainLinear = maxGain;
+            }
+
+            // pre gain + post gain + apply
+            const int applied = applyGains(f, l, r, gains, vectorEnd, preGain, preGainStep, postGain, postGainStep);
+            for (int i = applied; i < n; i++) {
+                const float pre = at(preGain, preGainStep, i);
+                const Sample g = gains[i]*at(postGain, postGainStep, i);
+                l[i] = (l[i]*pre)*g;
+                r[i] = (r[i]*pre)*g;
+            }
+        }
+
+        // detector level for the GUI, only needed once per block
+        s.rmsEnvelopeDb = 10*log10(std::max(s.envOut, 1.0e-20));
+    }
+
+    // the gain dynamics and apply stage of processLoop for a block whose
+    // target gain is 1 throughout: the gain releases towards 1, the same
+    // maths and so the same result as the loop. Once it is there, and with
+    // unity pre and post gain, the audio is left as it is
+    template <typename Sample>
+    void releaseAndApply(const StageFunctions& f, Sample* left, Sample* right, int numSamples,
+                         const Coeffs& c, State& s) {
+        if (s.gainOutLinear == 1 && c.preGainLinear == 1 && c.postGainLinear == 1) {
+            s.minGainLinear = std::min(s.minGainLinear, 1.0f);
+            s.maxGainLinear = std::max(s.maxGainLinear, 1.0f);
+            return;
+        }
+
+        alignas(64) Sample gains[chunkSize];
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            Sample* l = left + start;
+            Sample* r = right + start;
+            const int n = std::min(chunkSize, numSamples - start);
+            const int vectorEnd = f.apply != nullptr ? n - n % f.width : 0;
+
+            if (s.gainOutLinear == 1) {
+                std::fill(gains, gains + n, (Sample) 1);
+                s.minGainLinear = std::min(s.minGainLinear, 1.0f);
+                s.maxGainLinear = std::max(s.maxGainLinear, 1.0f);
+            } else {
+                double gain = s.gainOutLinear;
+                float minGain = s.minGainLinear;
+                float maxGain = s.maxGainLinear;
+                for (int i = 0; i < n; i++) {
+                    gain += c.releaseCoeff*(1.0f - gain);
+                    gains[i] = (Sample) gain;
+                    minGain = std::min(minGain, (float) gain);
+                    maxGain = std::max(maxGain, (float) gain);
+                }
+                s.gainOutLinear = gain;
+                s.minGainLinear = minGain;
+                s.maxGainLinear = maxGain;
+            }
+
+            const int applied = applyGains(f, l, r, gains, vectorEnd, c.preGainLinear, 0, c.postGainLinear, 0);
+            for (int i = applied; i < n; i++) {
+                const Sample g = gains[i]*c.postGainLinear;
+                l[i] = (l[i]*c.preGainLinear)*g;
+                r[i] = (r[i]*c.preGainLinear)*g;
+            }
+        }
+        if (1 - s.gainOutLinear < settledGainDistance)
+            s.gainOutLinear = 1;
+    }
+
+    template <typename Sample>
+    void processFastPath(Path path, const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                         int numSamples, const Coeffs& c, State& s) {
+        const Isa isa = activeIsa();
+        const StageFunctions f = isa == Isa::scalar ? scalarStages : getStageFunctions(isa);
+        if (path == Path::silent && c.controlRate != nullptr && isControlRateAtRest(s, *c.controlRate)) {
+            // nothing changes but where the control points fall
+            s.controlPosition = (s.controlPosition + numSamples) % s.controlInterval;
+        } else if (s.controlInterval != 0) {
+            leaveControlRate(s, c.envB0);
+        }
+
+        if (path == Path::silent) {
+            // the detector decays towards 0 in closed form, and is cleared
+            // below -200 dB rather than running on into denormals
+            s.envOut *= std::pow(1 - c.envB0, numSamples);
+            if (s.envOut < 1.0e-20)
+                s.envOut = 0;
+        } else {
+            // the detector as in processLoop, only the gain computer is left out
+            alignas(64) float power[chunkSize];
+            double env = s.envOut;
+            for (int start = 0; start < numSamples; start += chunkSize) {
+                const int n = std::min(chunkSize, numSamples - start);
+                const int vectorEnd = n - n % f.width;
+                f.power(keyLeft + start, keyRight + start, power, vectorEnd, c.preGainLinear, 0);
+                powerScalar(keyLeft + start + vectorEnd, keyRight + start + vectorEnd, power + vectorEnd,
+                            n - vectorEnd, c.preGainLinear, 0);
+                for (int i = 0; i < n; i++)
+                    env += c.envB0*(power[i] - env); // leaky integrator
+            }
+            s.envOut = env;
+        }
+
+        // when the key is the audio itself that is silent too and stays
+        // silent whatever the gain, which then also releases in closed form
+        const bool keyIsAudio = (const void*) keyLeft == (const void*) left
+                                && (const void*) keyRight == (const void*) right;
+        if (path == Path::silent && keyIsAudio) {
+            const double startGain = s.gainOutLinear;
+            s.gainOutLinear = 1 - (1 - startGain)*std::pow(1 - c.releaseCoeff, numSamples);
+            if (numSamples > 0) {
+                s.minGainLinear = std::min(s.minGainLinear, (float) (startGain + c.releaseCoeff*(1 - startGain)));
+                s.maxGainLinear = std::max(s.maxGainLinear, (float) s.gainOutLinear);
+            }
+            if (1 - s.gainOutLinear < settledGainDistance)
+                s.gainOutLinear = 1;
+        } else {
+            releaseAndApply(f, left, right, numSamples, c, s);
+        }
+        s.rmsEnvelopeDb = 10*log10(std::max(s.envOut, 1.0e-20));
+    }
+
+    // one table entry per configuration
+    template <int Oversampling, int KeyChannels>
+    constexpr BlockLoops makeBlockLoops() {
+        return { { processLoop<Oversampling, KeyChannels, Curve::ramped, float>,
+                   processLoop<Oversampling, KeyChannels, Curve::steady, float>,
+                   processLoop<Oversampling, KeyChannels, Curve::table, float> },
+                 { processLoop<Oversampling, KeyChannels, Curve::ramped, double>,
+                   processLoop<Oversampling, KeyChannels, Curve::steady, double>,
+                   processLoop<Oversampling, KeyChannels, Curve::table, double> } };
+    }
+
+    // [oversampling 1, 2, 4][key channels 1, 2]
+    constexpr BlockLoops blockLoopTable[3][2] = {
+        { makeBlockLoops<1, 1>(), makeBlockLoops<1, 2>() },
+        { makeBlockLoops<2, 1>(), makeBlockLoops<2, 2>() },
+        { makeBlockLoops<4, 1>(), makeBlockLoops<4, 2>() }
+    };
+}
+
+//==============================================================================
+Isa bestIsa() {
+    return detectIsa();
+}
+
+Isa activeIsa() {
+    return selectedIsa.load(std::memory_order_relaxed);
+}
+
+void setIsa(Isa isa) {
+    selectedIsa.store(isSupported(isa) ? isa : detectIsa(), std::memory_order_relaxed);
+}
+
+void fillGainTable(GainTable& table, int begin, int end) {
+    // entry k is at level 2^octave*(1 + step/steps) over the threshold,
+    // k = octave*steps + step
+    const double slope = 1.0/table.ratio - 1;
+    for (int k = std::max(begin, 0); k < std::min(end, gainTableSize); k++) {
+        const int position = std::min(k, gainTableSize - 2);
+        const double level = std::ldexp(1.0 + (double) (position % gainTableStepsPerOctave)/gainTableStepsPerOctave,
+                                        position/gainTableStepsPerOctave);
+        table.gain[k] = (float) std::pow(level, 0.5*slope); // 10^(slope*dB/20), dB = 10*log10(level)
+    }
+}
+
+void prepareControlRate(ControlRate& rate, int interval, const Coeffs& coeffs) {
+    // over n samples the detector keeps (1 - envB0)^n of its level and the
+    // gain (1 - coeff)^n of its distance to the target
+    rate.interval = std::min(std::max(interval, 1), maxControlInterval);
+    const double keep = 1 - coeffs.envB0;
+    rate.envDecay = std::pow(keep, rate.interval);
+    rate.attackCoeff = 1 - std::pow(1 - coeffs.attackCoeff, rate.interval);
+    rate.releaseCoeff = 1 - std::pow(1 - coeffs.releaseCoeff, rate.interval);
+    for (int k = 0; k < rate.interval; k++)
+        rate.envWeights[k] = (float) (coeffs.envB0*std::pow(keep, rate.interval - 1 - k));
+}
+
+void prepareKeyFilter(KeyFilterCoeffs& c) {
+    // run each section over an impulse and over each state value alone
+    for (int st = 0; st < c.numStages; st++) {
+        auto respond = [&c, st] (double x0, double z1, double z2, float* out) {
+            for (int i = 0; i < keyBlock; i++) {
+                const double x = i == 0 ? x0 : 0;
+                const double y = c.b0[st]*x + z1;
+                z1 = c.b1[st]*x + z2 - c.a1[st]*y;
+                z2 = c.b2[st]*x - c.a2[st]*y;
+                out[i] = (float) y;
+            }
+        };
+        std::fill(c.impulse[st], c.impulse[st] + keyBlock, 0.0f);
+        respond(1, 0, 0, c.impulse[st] + keyBlock);
+        respond(0, 1, 0, c.fromZ1[st]);
+        respond(0, 0, 1, c.fromZ2[st]);
+    }
+}
+
+void filterKey(const float* keyLeft, const float* keyRight, float* outLeft, float* outRight,
+               int numSamples, const KeyFilterCoeffs& coeffs, KeyFilterState& state) {
+    const Isa isa = activeIsa();
+    const StageFunctions f = isa == Isa::scalar ? scalarStages : getStageFunctions(isa);
+    const int vectorEnd = f.keyFilter != nullptr ? numSamples - numSamples % f.width : 0;
+    const float* in[2] = { keyLeft, keyRight };
+    float* out[2] = { outLeft, outRight };
+    const int numChannels = keyRight != nullptr ? 2 : 1;
+
+    for (int ch = 0; ch < numChannels; ch++) {
+        if (coeffs.numStages == 0) {
+            std::copy(in[ch], in[ch] + numSamples, out[ch]);
+            continue;
+        }
+        // the first section reads the key, the others work in place
+        for (int st = 0; st < coeffs.numStages; st++) {
+            const float* x = st == 0 ? in[ch] : out[ch];
+            float& z1 = state.z1[ch][st];
+            float& z2 = state.z2[ch][st];
+            if (vectorEnd > 0)
+                f.keyFilter(x, out[ch], vectorEnd, coeffs, st, z1, z2);
+            keyFilterScalar(x + vectorEnd, out[ch] + vectorEnd, numSamples - vectorEnd, coeffs, st, z1, z2);
+        }
+    }
+}
+
+void processBands(const float* keyLeft, const float* keyRight, float* left, float* right,
+                  int numSamples, const BandCoeffs<float>& coeffs, BandState<float>& state) {
+    const Isa isa = getBandsIsa(activeIsa(), coeffs.numBands);
+    if (isa == Isa::scalar)
+        processBandsScalar(keyLeft, keyRight, left, right, numSamples, coeffs, state);
+    else
+        getStageFunctions(isa).bands(keyLeft, keyRight, left, right, numSamples, coeffs, state);
+}
+
+void processBands(const float* keyLeft, const float* keyRight, double* left, double* right,
+                  int numSamples, const BandCoeffs<double>& coeffs, BandState<double>& state) {
+    // a band takes two float lanes' worth of a vector in double
+    const Isa isa = getBandsIsa(activeIsa(), 2*coeffs.numBands);
+    if (isa == Isa::scalar)
+        processBandsScalar(keyLeft, keyRight, left, right, numSamples, coeffs, state);
+    else
+        getStageFunctions(isa).bandsDouble(keyLeft, keyRight, left, right, numSamples, coeffs, state);
+}
+
+void processBatch(const float* const* keyChannels, int numKeyChannels, float* const* channels,
+                  int numSamples, const BatchCoeffs& coeffs, BatchState& state) {
+    const Isa isa = getBandsIsa(activeIsa(), coeffs.numLanes);
+    if (isa == Isa::scalar)
+        processBatchScalar(keyChannels, numKeyChannels, channels, numSamples, coeffs, state);
+    else
+        getStageFunctions(isa).batch(keyChannels, numKeyChannels, channels, numSamples, coeffs, state);
+}
+
+void processBatch(const double* const* keyChannels, int numKeyChannels, double* const* channels,
+                  int numSamples, const BatchCoeffs& coeffs, BatchState& state) {
+    const Isa isa = getBandsIsa(activeIsa(), coeffs.numLanes);
+    if (isa == Isa::scalar)
+        processBatchScalar(keyChannels, numKeyChannels, channels, numSamples, coeffs, state);
+    else
+        getStageFunctions(isa).batchDouble(keyChannels, numKeyChannels, channels, numSamples, coeffs, state);
+}
+
+int getOversamplingLatency(int oversampling) {
+    // group delay of the interpolators, rounded down to whole samples
+    if (oversampling >= 4)
+        return 13; // 11.5 + 1.75
+    if (oversampling == 2)
+        return 11; // 11.5
+    return 0;
+}
+
+const char* getIsaName(Isa isa) {
+    switch (isa) {
+        case Isa::scalar: return "scalar";
+        case Isa::sse2:   return "SSE2";
+        case Isa::avx2:   return "AVX2";
+        case Isa::avx512: return "AVX-512";
+        case Isa::neon:   return "NEON";
+    }
+    return "unknown";
+}
+
+Curve getCurve(const Coeffs& coeffs) {
+    if (coeffs.thresholdStep != 0 || coeffs.ratioStep != 0 || coeffs.preGainStep != 0 || coeffs.postGainStep != 0)
+        return Curve::ramped;
+    // the table only holds while the ratio is the one it was built for
+    if (coeffs.gainTable != nullptr && coeffs.gainTable->ratio == coeffs.ratio)
+        return Curve::table;
+    return Curve::steady;
+}
+
+float getPeak(const float* samples, int numSamples) {
+    const Isa isa = activeIsa();
+    const StageFunctions f = isa == Isa::scalar ? scalarStages : getStageFunctions(isa);
+    const int vectorEnd = numSamples - numSamples % f.width;
+    return std::max(f.peak(samples, vectorEnd), peakScalar(samples + vectorEnd, numSamples - vectorEnd));
+}
+
+Path choosePath(const float* keyLeft, const float* keyRight, int numSamples,
+                const Coeffs& coeffs, const State& state) {
+    // the reference loop runs every block, and ramps always take the full path
+    if (activeIsa() == Isa::scalar || getCurve(coeffs) == Curve::ramped)
+        return Path::full;
+
+    // the detector is a running mean of the key's power, so over the block
+    // it stays below the larger of where it starts and the key's peak power
+    const double quietLevel = std::pow(10.0, (coeffs.thresholdDb - quietMarginDb)/10); // mean square
+    if (controlRateLevel(state, coeffs.envB0) >= quietLevel)
+        return Path::full;
+    float peak = getPeak(keyLeft, numSamples);
+    if (keyRight != keyLeft)
+        peak = std::max(peak, getPeak(keyRight, numSamples));
+
+    // the oversampled detector also hears what is left in its interpolators
+    bool silent = peak == 0;
+    if (coeffs.oversampling > 1) {
+        auto isClear = [](const auto& history) {
+            const float* first = &history[0][0];
+            return std::all_of(first, first + sizeof(history)/sizeof(float), [](float x) { return x == 0; });
+        };
+        silent = silent && isClear(state.upsampleHistory1) && isClear(state.upsampleHistory2);
+    }
+
+    // at control rate only the silent path keeps where the control points
+    // fall, and only once the detector and gain are at rest
+    if (coeffs.controlRate != nullptr && coeffs.controlRate->interval > 1)
+        silent = silent && isControlRateAtRest(state, *coeffs.controlRate);
+    if (silent)
+        return Path::silent;
+    if (coeffs.oversampling > 1 || (coeffs.controlRate != nullptr && coeffs.controlRate->interval > 1))
+        return Path::full;
+    const double keyPeak = peak*coeffs.preGainLinear;
+    return keyPeak*keyPeak < quietLevel ? Path::quiet : Path::full;
+}
+
+void processFast(Path path, const float* keyLeft, const float* keyRight, float* left, float* right,
+                 int numSamples, const Coeffs& coeffs, State& state) {
+    processFastPath(path, keyLeft, keyRight, left, right, numSamples, coeffs, state);
+}
+
+void processFast(Path path, const float* keyLeft, const float* keyRight, double* left, double* right,
+                 int numSamples, const Coeffs& coeffs, State& state) {
+    processFastPath(path, keyLeft, keyRight, left, right, numSamples, coeffs, state);
+}
+
+const BlockLoops& getBlockLoops(int oversampling, int keyChannels) {
+    const int detector = oversampling >= 4 ? 2 : oversampling == 2 ? 1 : 0;
+    return blockLoopTable[detector][keyChannels == 1 ? 0 : 1];
+}
+
+void processStereo(const float* keyLeft, const float* keyRight, float* left, float* right,
+                   int numSamples, const Coeffs& coeffs, State& state) {
+    getBlockLoops(coeffs.oversampling, keyLeft == keyRight ? 1 : 2)
+        .run(getCurve(coeffs), keyLeft, keyRight, left, right, numSamples, coeffs, state);
+}
+
+void processStereo(const float* keyLeft, const float* keyRight, double* left, double* right,
+                   int numSamples, const Coeffs& coeffs, State& state) {
+    getBlockLoops(coeffs.oversampling, keyLeft == keyRight ? 1 : 2)
+        .run(getCurve(coeffs), keyLeft, keyRight, left, right, numSamples, coeffs, state);
+}
+
+void processStereo(float* left, float* right, int numSamples,
+                   const Coeffs& coeffs, State& state) {
+    processStereo(left, right, left, right, numSamples, coeffs, state);
+}
+
+}
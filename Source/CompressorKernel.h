@@ -0,0 +1,418 @@
+/*
+  ==============================================================================
+
+    CompressorKernel.h
+    Created: 16 Oct 2026 9:12:40am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+/*
+ Block-oriented version of the stereo RMS compressor loop.
+
+ The per-sample loop is split into stages:
+    pre gain + squaring  -> vectorized
+    RMS detector         -> scalar (leaky integrator recurrence)
+    dB conversion + gain computer + dB to linear -> vectorized, or an
+                         interpolated GainTable lookup when one is given
+    gain dynamics        -> scalar (attack/release recurrence)
+    post gain + gain application -> vectorized
+
+ The vectorized stages are compiled for SSE2, AVX2 and AVX-512 on x86
+ (picked at runtime from what the CPU supports) and NEON on arm64, and
+ the loop around them once per detector oversampling, key channel count,
+ static curve and sample type (getBlockLoops). Isa::scalar is the
+ original per-sample loop (sqrt, log10, pow), kept as the reference for
+ the others (README.md has their measured accuracy and speed).
+
+ Besides the single band loop: an oversampled (true peak) detector
+ (Coeffs::oversampling), multiband (processBands), the key filter
+ (filterKey), many independent compressors in the lanes of one pass
+ (processBatch), a gain computer at control rate (Coeffs::controlRate)
+ and fast paths for blocks that leave the gain computer nothing to do
+ (choosePath). The detector and gain integrators are double for float
+ and double audio alike.
+ */
+namespace CompressorKernel
+{
+    enum class Isa
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    //==============================================================================
+    // static gain computer curve for one ratio, sampled over the detector
+    // level relative to the threshold (mean square / threshold),
+    // gainTableStepsPerOctave points per octave from 2^0 (the threshold, so
+    // the knee falls on a point) to 2^gainTableOctaves (+102 dB). Lower
+    // levels get no gain reduction, higher ones are clamped. The position
+    // of a level is read straight off its float bits (exponent and top
+    // mantissa bits), and the rest of the mantissa interpolates.
+    constexpr int gainTableOctaves = 34;
+    constexpr int gainTableStepsPerOctave = 64;
+    constexpr int gainTableStepBits = 6;    // log2 of the above
+    constexpr int gainTableSize = gainTableOctaves*gainTableStepsPerOctave + 2;
+
+    struct GainTable {
+        float ratio = 1;
+        float gain[gainTableSize] = {}; // linear, the last entry repeats the one before
+    };
+
+    // fills in gain[begin..end) for table.ratio, so the table can be built
+    // a slice at a time
+    void fillGainTable(GainTable& table, int begin, int end);
+
+    // control rate gain: the detector is only read, and the gain computer
+    // and the gain dynamics only run, every interval samples (the control
+    // points), and the gain goes in a straight line from one to the next.
+    // Filled in by prepareControlRate() from the per-sample coefficients
+    constexpr int maxControlInterval = 32;
+
+    struct ControlRate {
+        int interval = 1;
+        double envDecay = 1;        // the detector's memory over one interval
+        double attackCoeff = 0;     // the gain integrator over one interval
+        double releaseCoeff = 0;
+        float envWeights[maxControlInterval] = {}; // each sample's share of the detector at the interval's end
+    };
+
+    // per-block coefficients, same meaning as the members in the processor
+    struct Coeffs {
+        float preGainLinear;
+        float postGainLinear;
+        double envB0;           // the recurrences run in double, see State
+        double attackCoeff;
+        double releaseCoeff;
+        float thresholdDb;
+        float ratio;
+
+        // per-sample increments that ramp the values above across the
+        // block (value at sample i = value + i*step), 0 when not ramping
+        float preGainStep = 0;
+        float postGainStep = 0;
+        float thresholdStep = 0;
+        float ratioStep = 0;
+
+        // detector oversampling factor: 1, 2 or 4
+        int oversampling = 1;
+
+        // when set (for this ratio), looked up instead of working out the
+        // gain computer while threshold and ratio are not ramping
+        const GainTable* gainTable = nullptr;
+
+        // when set with an interval above 1, the block loops run the gain
+        // computer and gain dynamics at that control rate (Isa::scalar with
+        // the original maths, one sample at a time)
+        const ControlRate* controlRate = nullptr;
+    };
+
+    // interval is clamped to 1..maxControlInterval, coeffs gives envB0,
+    // attackCoeff and releaseCoeff
+    void prepareControlRate(ControlRate& rate, int interval, const Coeffs& coeffs);
+
+    // state carried from block to block. The two integrators are double:
+    // with a 2 s release at 192 kHz the coefficient is 2.6e-6, and a float
+    // gain stops moving ~0.1 dB short of its target once the step drops
+    // below half an ulp
+    struct State {
+        double envOut = 0.0;        // RMS env follower memory (mean square)
+        double gainOutLinear = 1;   // gain dynamics memory
+        float rmsEnvelopeDb = -200; // detector level at the end of the last block
+
+        // lowest/highest gainOutLinear seen, only ever widened here so the
+        // caller decides when to reset them
+        float minGainLinear = 1;
+        float maxGainLinear = 1;
+
+        // control rate gain, kept where the control points fall whatever
+        // the block sizes: the interval in use (0 while running per
+        // sample), samples since the last control point and the weighted
+        // power since (envOut is the detector level at that point), and
+        // the gain there and its slope per sample up to the next one
+        int controlInterval = 0;
+        int controlPosition = 0;
+        float controlSum = 0;
+        double controlGain = 1;
+        double gainStep = 0;
+
+        // interpolator memory of the oversampled detector (left, right)
+        float upsampleHistory1[2][23] = {};
+        float upsampleHistory2[2][7] = {};
+    };
+
+    //==============================================================================
+    // multiband: the input is split by Linkwitz-Riley crossovers and every
+    // band gets its own detector, gain computer and gain dynamics. The bands
+    // sit side by side in the lanes of one vector (structure of arrays,
+    // bandLanes apart), so all bands are filtered and compressed by the
+    // same instructions.
+    constexpr int maxBands = 5;
+    constexpr int bandLanes = 16;                           // the widest vector
+    constexpr int maxCrossoverStages = 2*(maxBands - 1);    // biquads per band
+
+    // Sample is the audio's type, the crossovers run in it
+    template <typename Sample>
+    struct BandCoeffs {
+        int numBands = 1;
+        int numStages = 0;      // biquads per band, 2 per crossover
+
+        float preGainLinear = 1;
+        float postGainLinear = 1;
+        double envB0 = 0;
+        float preGainStep = 0;
+        float postGainStep = 0;
+
+        // crossover network, per biquad and band (transposed direct form II,
+        // a0 normalised to 1). Each band runs the low pass, high pass or
+        // all pass section of every crossover that makes up its share.
+        Sample b0[maxCrossoverStages][bandLanes] = {};
+        Sample b1[maxCrossoverStages][bandLanes] = {};
+        Sample b2[maxCrossoverStages][bandLanes] = {};
+        Sample a1[maxCrossoverStages][bandLanes] = {};
+        Sample a2[maxCrossoverStages][bandLanes] = {};
+
+        // per band, threshold and ratio ramp by step per sample
+        double attackCoeff[bandLanes] = {};
+        double releaseCoeff[bandLanes] = {};
+        float thresholdDb[bandLanes] = {};
+        float ratio[bandLanes] = {};
+        float thresholdStep[bandLanes] = {};
+        float ratioStep[bandLanes] = {};
+    };
+
+    // the integrators are double, as in State
+    template <typename Sample>
+    struct BandState {
+        double envOut[bandLanes] = {};
+        double gainOutLinear[bandLanes] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+
+        // per band, range of the gain since the caller last reset these
+        float minGainLinear[bandLanes] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+        float maxGainLinear[bandLanes] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+
+        // crossover memory per channel, for the audio and (when the key is
+        // a separate signal) the key
+        Sample z1[2][maxCrossoverStages][bandLanes] = {};
+        Sample z2[2][maxCrossoverStages][bandLanes] = {};
+        Sample keyZ1[2][maxCrossoverStages][bandLanes] = {};
+        Sample keyZ2[2][maxCrossoverStages][bandLanes] = {};
+    };
+
+    //==============================================================================
+    // batch: up to batchLanes unrelated compressors, each in a lane of the
+    // same vectors (structure of arrays, batchLanes apart). Lane k processes
+    // its laneChannels[k] channels in place, the ones after lane k - 1's (by
+    // default stereo: channels[2k] and channels[2k + 1]), with the computed
+    // curve (no GainTable) and no oversampling. Its detector hears the mean
+    // square of all its channels (or of the key channels, shared by every
+    // lane, when given), and the one gain goes to all of them. Callers with
+    // more compressors run several batches.
+    constexpr int batchLanes = 16;                          // the widest vector
+
+    struct BatchCoeffs {
+        int numLanes = 0;
+        double envB0 = 0;       // shared, it only depends on the sample rate
+        int laneChannels[batchLanes] = { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 };
+
+        // per lane, same meaning as in Coeffs
+        float preGainLinear[batchLanes] = {};
+        float postGainLinear[batchLanes] = {};
+        double attackCoeff[batchLanes] = {};
+        double releaseCoeff[batchLanes] = {};
+        float thresholdDb[batchLanes] = {};
+        float ratio[batchLanes] = {};
+        float preGainStep[batchLanes] = {};
+        float postGainStep[batchLanes] = {};
+        float thresholdStep[batchLanes] = {};
+        float ratioStep[batchLanes] = {};
+    };
+
+    struct BatchState {
+        double envOut[batchLanes] = {};
+        double gainOutLinear[batchLanes] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+        float rmsEnvelopeDb[batchLanes] = {};
+        float minGainLinear[batchLanes] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+        float maxGainLinear[batchLanes] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+    };
+
+    //==============================================================================
+    // key (sidechain) filter: a cascade of biquads run on the detector input.
+    // Each section outputs a whole vector of samples per step: its first
+    // outputs are a weighted sum of the inputs (the impulse response) plus
+    // the responses to the two state values, so the only recurrence left is
+    // the state handed from one vector to the next.
+    constexpr int maxKeyStages = 4;
+    constexpr int keyBlock = 16;    // the widest vector
+
+    struct KeyFilterCoeffs {
+        int numStages = 0;
+
+        // per biquad, transposed direct form II, a0 normalised to 1
+        float b0[maxKeyStages] = {};
+        float b1[maxKeyStages] = {};
+        float b2[maxKeyStages] = {};
+        float a1[maxKeyStages] = {};
+        float a2[maxKeyStages] = {};
+
+        // filled in by prepareKeyFilter(): impulse response after keyBlock
+        // zeros, and the output for z1 = 1 or z2 = 1 with no input
+        float impulse[maxKeyStages][2*keyBlock] = {};
+        float fromZ1[maxKeyStages][keyBlock] = {};
+        float fromZ2[maxKeyStages][keyBlock] = {};
+    };
+
+    struct KeyFilterState {
+        float z1[2][maxKeyStages] = {}; // per channel and biquad
+        float z2[2][maxKeyStages] = {};
+    };
+
+    // fills in the vector tables from the biquad coefficients
+    void prepareKeyFilter(KeyFilterCoeffs& coeffs);
+
+    // filters a stereo key into outLeft/outRight, which may be the inputs.
+    // For a mono key keyRight and outRight are null
+    void filterKey(const float* keyLeft, const float* keyRight, float* outLeft, float* outRight,
+                   int numSamples, const KeyFilterCoeffs& coeffs, KeyFilterState& state);
+
+    // best instruction set the running CPU supports
+    Isa bestIsa();
+
+    // instruction set used by processStereo, defaults to bestIsa()
+    Isa activeIsa();
+
+    // forces an instruction set (e.g. scalar to compare against the reference),
+    // falls back to bestIsa() if the CPU does not support the one requested
+    void setIsa(Isa isa);
+
+    const char* getIsaName(Isa isa);
+
+    // multiband version of processStereo. The key may be the same buffers as
+    // left/right, or null when the detectors hear the bands of the audio
+    void processBands(const float* keyLeft, const float* keyRight, float* left, float* right,
+                      int numSamples, const BandCoeffs<float>& coeffs, BandState<float>& state);
+
+    // double precision audio, the crossovers and the band gains run in
+    // double. A key (not null) is a separate float buffer, filtered by its
+    // own copy of the crossovers
+    void processBands(const float* keyLeft, const float* keyRight, double* left, double* right,
+                      int numSamples, const BandCoeffs<double>& coeffs, BandState<double>& state);
+
+    // processes coeffs.numLanes compressors, see BatchCoeffs. With
+    // numKeyChannels > 0, every lane's detector listens to keyChannels
+    // instead of its own channels
+    void processBatch(const float* const* keyChannels, int numKeyChannels, float* const* channels,
+                      int numSamples, const BatchCoeffs& coeffs, BatchState& state);
+
+    // double precision audio, the detectors hear a float copy (as in
+    // processStereo) and the gains are applied in double
+    void processBatch(const double* const* keyChannels, int numKeyChannels, double* const* channels,
+                      int numSamples, const BatchCoeffs& coeffs, BatchState& state);
+
+    // how many samples the oversampled detector lags its input, the engine
+    // delays the audio by this much to keep them aligned
+    int getOversamplingLatency(int oversampling);
+
+    // processes a stereo block in place
+    void processStereo(float* left, float* right, int numSamples,
+                       const Coeffs& coeffs, State& state);
+
+    // same, but the detector listens to keyLeft/keyRight instead of the
+    // audio being processed (e.g. the undelayed input for lookahead).
+    // The key may be the same buffers as left/right.
+    void processStereo(const float* keyLeft, const float* keyRight, float* left, float* right,
+                       int numSamples, const Coeffs& coeffs, State& state);
+
+    // double precision audio, same detector and gain maths (the key stays
+    // float), the gain is applied in double
+    void processStereo(const float* keyLeft, const float* keyRight, double* left, double* right,
+                       int numSamples, const Coeffs& coeffs, State& state);
+
+    //==============================================================================
+    // processStereo works out the configuration on every call and runs the
+    // block loop compiled for it. A caller that keeps its configuration
+    // from block to block can look the loops up once instead (getBlockLoops,
+    // again when the oversampling or the key's channel count changes) and
+    // only pick the curve per call.
+
+    // static curve of a call: the gain computer with threshold/ratio
+    // ramping, the same without ramps, or the GainTable
+    enum class Curve
+    {
+        ramped,
+        steady,
+        table
+    };
+    constexpr int numCurves = 3;
+
+    // the curve processStereo would use for these coefficients
+    Curve getCurve(const Coeffs& coeffs);
+
+    template <typename Sample>
+    using BlockLoop = void (*) (const float* keyLeft, const float* keyRight, Sample* left, Sample* right,
+                                int numSamples, const Coeffs& coeffs, State& state);
+
+    // the loops for one detector oversampling and key channel count, per
+    // curve. A loop for a mono key only reads keyLeft.
+    struct BlockLoops {
+        BlockLoop<float> floatLoops[numCurves];
+        BlockLoop<double> doubleLoops[numCurves];
+
+        void run(Curve curve, const float* keyLeft, const float* keyRight, float* left, float* right,
+                 int numSamples, const Coeffs& coeffs, State& state) const {
+            floatLoops[(int) curve](keyLeft, keyRight, left, right, numSamples, coeffs, state);
+        }
+
+        void run(Curve curve, const float* keyLeft, const float* keyRight, double* left, double* right,
+                 int numSamples, const Coeffs& coeffs, State& state) const {
+            doubleLoops[(int) curve](keyLeft, keyRight, left, right, numSamples, coeffs, state);
+        }
+    };
+
+    // oversampling 1, 2 or 4, keyChannels 1 or 2
+    const BlockLoops& getBlockLoops(int oversampling, int keyChannels);
+
+    //==============================================================================
+    // fast paths for blocks that leave the gain computer nothing to do, i.e.
+    // every target gain is 1:
+    //    quiet   the key's peak power and the detector stay quietMarginDb
+    //            below the threshold. The detector and the gain's release
+    //            run as in the block loop, with the same result bit for bit
+    //    silent  the key is digital silence and the detector already below
+    //            the threshold. The detector decays in closed form
+    // Both apply the pre gain, gain and post gain as the block loop does,
+    // and leave the audio untouched once the gain has settled at 1 with
+    // unity pre and post gain.
+    // The quiet path needs the 1x detector and the per-sample gain, the
+    // silent one an oversampled detector whose interpolators have emptied.
+    // Neither runs for ramps or with Isa::scalar. Choosing scans the key's
+    // peak, and only once the detector is already below the threshold.
+    enum class Path
+    {
+        full,   // the block loop
+        quiet,
+        silent
+    };
+    constexpr int numPaths = 3;
+    constexpr float quietMarginDb = 1; // well clear of the fast maths' error
+
+    // largest magnitude in a buffer
+    float getPeak(const float* samples, int numSamples);
+
+    // the path a block can take with these coefficients, keyRight the same
+    // buffer as keyLeft for a mono key
+    Path choosePath(const float* keyLeft, const float* keyRight, int numSamples,
+                    const Coeffs& coeffs, const State& state);
+
+    // processes a block on a fast path choosePath returned for it
+    void processFast(Path path, const float* keyLeft, const float* keyRight, float* left, float* right,
+                     int numSamples, const Coeffs& coeffs, State& state);
+    void processFast(Path path, const float* keyLeft, const float* keyRight, double* left, double* right,
+                     int numSamples, const Coeffs& coeffs, State& state);
+}
@@ -0,0 +1,776 @@
+/*
+  ==============================================================================
+
+    CompressorKernelImpl.h
+    Created: 16 Oct 2026 9:40:02am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+// No include guard: this file is included once per instruction set by
+// CompressorKernel.cpp, inside a namespace that provides
+//    KERNEL_TARGET, Vec, Mask, width
+//    set1, load, store, add, sub, mul, div, min, max, lessThan, select
+//    exponentOf, mantissaOf, roundToInt, pow2, lookupGain
+//    VecD (width/2 doubles), setD, loadD, storeD, addD, subD, mulD,
+//    selectLessD, lowToDouble, highToDouble, toFloat
+//    transposeBlock (width x width floats, rows inStride apart in, columns
+//    outStride apart out), transposeBlockD (the same, width/2 doubles square)
+// so that every function here gets compiled for that instruction set.
+// The stage functions expect numSamples to be a multiple of width,
+// except bandsStage and batchStage which vectorise across bands and
+// compressors instead of samples.
+
+// natural log, Cephes logf polynomial (x > 0, no denormals)
+KERNEL_TARGET static inline Vec fastLog(Vec x)
+{
+    Vec e = exponentOf(x);  // x = m * 2^e, 0.5 <= m < 1
+    Vec m = mantissaOf(x);
+
+    // shift m to [sqrt(0.5), sqrt(2)) around 1
+    Mask small = lessThan(m, set1(0.707106781186547524f));
+    e = select(small, sub(e, set1(1.0f)), e);
+    m = sub(select(small, add(m, m), m), set1(1.0f));
+
+    Vec z = mul(m, m);
+    Vec y = set1(7.0376836292e-2f);
+    y = add(mul(y, m), set1(-1.1514610310e-1f));
+    y = add(mul(y, m), set1(1.1676998740e-1f));
+    y = add(mul(y, m), set1(-1.2420140846e-1f));
+    y = add(mul(y, m), set1(1.4249322787e-1f));
+    y = add(mul(y, m), set1(-1.6668057665e-1f));
+    y = add(mul(y, m), set1(2.0000714765e-1f));
+    y = add(mul(y, m), set1(-2.4999993993e-1f));
+    y = add(mul(y, m), set1(3.3333331174e-1f));
+    y = mul(mul(y, m), z);
+
+    y = add(y, mul(e, set1(-2.12194440e-4f)));
+    y = sub(y, mul(z, set1(0.5f)));
+    return add(add(m, y), mul(e, set1(0.693359375f)));
+}
+
+// e^x, Cephes expf polynomial
+KERNEL_TARGET static inline Vec fastExp(Vec x)
+{
+    x = min(max(x, set1(-87.0f)), set1(88.0f));
+
+    Vec n = roundToInt(mul(x, set1(1.44269504088896341f)));
+    x = sub(x, mul(n, set1(0.693359375f)));
+    x = sub(x, mul(n, set1(-2.12194440e-4f)));
+
+    Vec y = set1(1.9875691500e-4f);
+    y = add(mul(y, x), set1(1.3981999507e-3f));
+    y = add(mul(y, x), set1(8.3334519073e-3f));
+    y = add(mul(y, x), set1(4.1665795894e-2f));
+    y = add(mul(y, x), set1(1.6666665459e-1f));
+    y = add(mul(y, x), set1(5.0000001201e-1f));
+    y = add(add(mul(y, mul(x, x)), x), set1(1.0f));
+    return mul(y, pow2(n));
+}
+
+// start + (i + lane)*step for each lane
+KERNEL_TARGET static inline Vec ramp(float start, float step, int i)
+{
+    return add(set1(start + i*step), mul(load(laneIndex), set1(step)));
+}
+
+// stage 1: mean of the squared, pre gained key (detector input) channels
+KERNEL_TARGET static void powerStage(const float* keyLeft, const float* keyRight, float* power,
+                                     int numSamples, float preGainLinear, float preGainStep)
+{
+    const Vec half = set1(0.5f);
+    for (int i = 0; i < numSamples; i += width) {
+        Vec gain = ramp(preGainLinear, preGainStep, i);
+        Vec l = mul(load(keyLeft + i), gain);
+        Vec r = mul(load(keyRight + i), gain);
+        store(power + i, mul(half, add(mul(l, l), mul(r, r))));
+    }
+}
+
+// stage 1 for a key of more than two channels: adds one channel's squared,
+// pre gained samples to sum
+KERNEL_TARGET static void sumSquaresStage(const float* key, float* sum, int numSamples,
+                                          float preGainLinear, float preGainStep)
+{
+    for (int i = 0; i < numSamples; i += width) {
+        Vec x = mul(load(key + i), ramp(preGainLinear, preGainStep, i));
+        store(sum + i, add(load(sum + i), mul(x, x)));
+    }
+}
+
+// largest magnitude among the samples, numSamples a multiple of width
+// (the silence and level check ahead of the fast paths)
+KERNEL_TARGET static float peakStage(const float* x, int numSamples)
+{
+    const Vec zero = set1(0.0f);
+    Vec peak = zero;
+    for (int i = 0; i < numSamples; i += width) {
+        Vec v = load(x + i);
+        peak = max(peak, max(v, sub(zero, v)));
+    }
+    alignas(64) float lanes[width];
+    store(lanes, peak);
+    float result = 0;
+    for (int k = 0; k < width; k++)
+        result = std::max(result, lanes[k]);
+    return result;
+}
+
+// stage 1, oversampled detector: symmetric FIR for the half-band
+// interpolators, y[i] = sum over k < numTaps/2 of
+// halfTaps[k]*(x[i + k] + x[i + numTaps - 1 - k]).
+// x holds numTaps - 1 samples of history before the first output
+KERNEL_TARGET static void firStage(const float* x, float* y, int numSamples,
+                                   const float* halfTaps, int numTaps)
+{
+    for (int i = 0; i < numSamples; i += width) {
+        Vec acc = set1(0.0f);
+        for (int k = 0; k < numTaps/2; k++)
+            acc = add(acc, mul(set1(halfTaps[k]), add(load(x + i + k), load(x + i + numTaps - 1 - k))));
+        store(y + i, acc);
+    }
+}
+
+// stage 3: detector level (mean square) -> target gain (linear)
+KERNEL_TARGET static void gainComputerStage(float* envelope, int numSamples,
+                                            float thresholdDb, float thresholdStep,
+                                            float ratio, float ratioStep)
+{
+    const Vec floor = set1(1.0e-20f); // -200 dB, keeps log away from 0
+    const Vec toDb = set1(4.34294481903251828f); // 10/ln(10): mean square -> dB
+    const Vec fromDb = set1(0.115129254649702284f); // ln(10)/20: dB -> ln(amplitude)
+    const Vec zero = set1(0.0f);
+    const Vec one = set1(1.0f);
+    const bool ramping = thresholdStep != 0 || ratioStep != 0;
+    Vec thresh = set1(thresholdDb);
+    Vec slope = set1(1.0f/ratio - 1.0f);
+    for (int i = 0; i < numSamples; i += width) {
+        if (ramping) {
+            thresh = ramp(thresholdDb, thresholdStep, i);
+            slope = sub(div(one, ramp(ratio, ratioStep, i)), one);
+        }
+        Vec levelDb = mul(fastLog(max(load(envelope + i), floor)), toDb);
+        Vec gainDb = min(zero, mul(slope, sub(levelDb, thresh)));
+        store(envelope + i, fastExp(mul(gainDb, fromDb)));
+    }
+}
+
+// stage 3 with a GainTable: detector level -> target gain by interpolated
+// lookup. thresholdScale is 1/threshold as a mean square
+KERNEL_TARGET static void gainTableStage(float* envelope, int numSamples,
+                                         float thresholdScale, const GainTable& table)
+{
+    const Vec scale = set1(thresholdScale);
+    const Vec lowest = set1(1.0f);
+    const Vec highest = set1(std::ldexp(1.0f, gainTableOctaves));
+    for (int i = 0; i < numSamples; i += width) {
+        Vec overThreshold = min(max(mul(load(envelope + i), scale), lowest), highest);
+        store(envelope + i, lookupGain(table.gain, overThreshold));
+    }
+}
+
+// multiband: the bands sit in lanes (groups of width bands if there are
+// more bands than lanes) and run one sample at a time. The filter, envelope
+// and gain memory stay in locals for a whole group and chunk, so nothing
+// in the recurrences goes through memory that might alias the audio.
+KERNEL_TARGET static inline Vec bandBiquad(Vec x, Vec b0, Vec b1, Vec b2, Vec a1, Vec a2, Vec& z1, Vec& z2)
+{
+    Vec y = add(mul(b0, x), z1);
+    z1 = sub(add(mul(b1, x), z2), mul(a1, y));
+    z2 = sub(mul(b2, x), mul(a2, y));
+    return y;
+}
+
+KERNEL_TARGET static void bandsStage(const float* keyLeft, const float* keyRight,
+                                     float* left, float* right, int numSamples,
+                                     const BandCoeffs<float>& c, BandState<float>& s)
+{
+    constexpr int bandChunk = 64;
+    const bool separateKey = keyLeft != nullptr && (keyLeft != left || keyRight != right);
+    const Vec half = set1(0.5f);
+    const Vec floor = set1(1.0e-20f);
+    const Vec toDb = set1(4.34294481903251828f);
+    const Vec fromDb = set1(0.115129254649702284f);
+    const Vec zero = set1(0.0f);
+    const Vec one = set1(1.0f);
+    constexpr int halfWidth = width/2;
+    const VecD envB0 = setD(c.envB0);
+    const int numStages = c.numStages;
+    bool ramping = false;
+    for (int b = 0; b < c.numBands; b++)
+        ramping = ramping || c.thresholdStep[b] != 0 || c.ratioStep[b] != 0;
+    alignas(64) float bandLeft[bandLanes];
+    alignas(64) float bandRight[bandLanes];
+
+    for (int start = 0; start < numSamples; start += bandChunk) {
+        const int n = std::min(bandChunk, numSamples - start);
+        float sumLeft[bandChunk] = {};
+        float sumRight[bandChunk] = {};
+
+        for (int g = 0; g < c.numBands; g += width) {
+            const int groupBands = std::min(width, c.numBands - g);
+            Vec z1[2][maxCrossoverStages], z2[2][maxCrossoverStages];
+            Vec keyZ1[2][maxCrossoverStages], keyZ2[2][maxCrossoverStages];
+            for (int st = 0; st < numStages; st++) {
+                for (int ch = 0; ch < 2; ch++) {
+                    z1[ch][st] = load(s.z1[ch][st] + g);
+                    z2[ch][st] = load(s.z2[ch][st] + g);
+                    keyZ1[ch][st] = load(s.keyZ1[ch][st] + g);
+                    keyZ2[ch][st] = load(s.keyZ2[ch][st] + g);
+                }
+            }
+            VecD envLow = loadD(s.envOut + g);
+            VecD envHigh = loadD(s.envOut + g + halfWidth);
+            VecD gainLow = loadD(s.gainOutLinear + g);
+            VecD gainHigh = loadD(s.gainOutLinear + g + halfWidth);
+            const VecD attackLow = loadD(c.attackCoeff + g);
+            const VecD attackHigh = loadD(c.attackCoeff + g + halfWidth);
+            const VecD releaseLow = loadD(c.releaseCoeff + g);
+            const VecD releaseHigh = loadD(c.releaseCoeff + g + halfWidth);
+            const Vec thresholdStart = load(c.thresholdDb + g);
+            const Vec ratioStart = load(c.ratio + g);
+            Vec thresh = thresholdStart;
+            Vec slope = sub(div(one, ratioStart), one);
+            Vec minGain = load(s.minGainLinear + g);
+            Vec maxGain = load(s.maxGainLinear + g);
+
+            for (int j = 0; j < n; j++) {
+                const int i = start + j;
+                const float pre = c.preGainLinear + i*c.preGainStep;
+
+                // crossover network, every lane gets the same input
+                Vec l = set1(left[i]*pre);
+                Vec r = set1(right[i]*pre);
+                Vec kl = l;
+                Vec kr = r;
+                if (separateKey) {
+                    kl = set1(keyLeft[i]*pre);
+                    kr = set1(keyRight[i]*pre);
+                }
+                for (int st = 0; st < numStages; st++) {
+                    const Vec b0 = load(c.b0[st] + g);
+                    const Vec b1 = load(c.b1[st] + g);
+                    const Vec b2 = load(c.b2[st] + g);
+                    const Vec a1 = load(c.a1[st] + g);
+                    const Vec a2 = load(c.a2[st] + g);
+                    l = bandBiquad(l, b0, b1, b2, a1, a2, z1[0][st], z2[0][st]);
+                    r = bandBiquad(r, b0, b1, b2, a1, a2, z1[1][st], z2[1][st]);
+                    if (separateKey) {
+                        kl = bandBiquad(kl, b0, b1, b2, a1, a2, keyZ1[0][st], keyZ2[0][st]);
+                        kr = bandBiquad(kr, b0, b1, b2, a1, a2, keyZ1[1][st], keyZ2[1][st]);
+                    }
+                }
+                if (!separateKey) {
+                    kl = l;
+                    kr = r;
+                }
+
+                // RMS detector, in double
+                const Vec power = mul(half, add(mul(kl, kl), mul(kr, kr)));
+                envLow = addD(envLow, mulD(envB0, subD(lowToDouble(power), envLow)));
+                envHigh = addD(envHigh, mulD(envB0, subD(highToDouble(power), envHigh)));
+                const Vec env = toFloat(envLow, envHigh);
+
+                // gain computer
+                if (ramping) {
+                    const Vec sampleIndex = set1((float) i);
+                    thresh = add(thresholdStart, mul(load(c.thresholdStep + g), sampleIndex));
+                    slope = sub(div(one, add(ratioStart, mul(load(c.ratioStep + g), sampleIndex))), one);
+                }
+                Vec levelDb = mul(fastLog(max(env, floor)), toDb);
+                Vec target = fastExp(mul(min(zero, mul(slope, sub(levelDb, thresh))), fromDb));
+
+                // gain dynamics, in double
+                const VecD targetLow = lowToDouble(target);
+                const VecD targetHigh = highToDouble(target);
+                gainLow = addD(gainLow, mulD(selectLessD(targetLow, gainLow, attackLow, releaseLow),
+                                             subD(targetLow, gainLow)));
+                gainHigh = addD(gainHigh, mulD(selectLessD(targetHigh, gainHigh, attackHigh, releaseHigh),
+                                               subD(targetHigh, gainHigh)));
+                const Vec gain = toFloat(gainLow, gainHigh);
+                minGain = min(minGain, gain);
+                maxGain = max(maxGain, gain);
+
+                // sum the bands of this group
+                store(bandLeft, mul(l, gain));
+                store(bandRight, mul(r, gain));
+                for (int b = 0; b < groupBands; b++) {
+                    sumLeft[j] += bandLeft[b];
+                    sumRight[j] += bandRight[b];
+                }
+            }
+
+            for (int st = 0; st < numStages; st++) {
+                for (int ch = 0; ch < 2; ch++) {
+                    store(s.z1[ch][st] + g, z1[ch][st]);
+                    store(s.z2[ch][st] + g, z2[ch][st]);
+                    store(s.keyZ1[ch][st] + g, keyZ1[ch][st]);
+                    store(s.keyZ2[ch][st] + g, keyZ2[ch][st]);
+                }
+            }
+            storeD(s.envOut + g, envLow);
+            storeD(s.envOut + g + halfWidth, envHigh);
+            storeD(s.gainOutLinear + g, gainLow);
+            storeD(s.gainOutLinear + g + halfWidth, gainHigh);
+            store(s.minGainLinear + g, minGain);
+            store(s.maxGainLinear + g, maxGain);
+        }
+
+        // post gain
+        for (int j = 0; j < n; j++) {
+            const float post = c.postGainLinear + (start + j)*c.postGainStep;
+            left[start + j] = sumLeft[j]*post;
+            right[start + j] = sumRight[j]*post;
+        }
+    }
+}
+
+// the same for double audio, with the crossovers and the gain dynamics in
+// double: the bands sit in the lanes of the double vectors (width/2 per
+// group) and only the gain computer runs in float, in the low half of a
+// Vec. A key is a separate float buffer here.
+KERNEL_TARGET static inline VecD bandBiquad(VecD x, VecD b0, VecD b1, VecD b2, VecD a1, VecD a2, VecD& z1, VecD& z2)
+{
+    VecD y = addD(mulD(b0, x), z1);
+    z1 = subD(addD(mulD(b1, x), z2), mulD(a1, y));
+    z2 = subD(mulD(b2, x), mulD(a2, y));
+    return y;
+}
+
+KERNEL_TARGET static void bandsStage(const float* keyLeft, const float* keyRight,
+                                     double* left, double* right, int numSamples,
+                                     const BandCoeffs<double>& c, BandState<double>& s)
+{
+    constexpr int bandChunk = 64;
+    constexpr int halfWidth = width/2;
+    const VecD half = setD(0.5);
+    const Vec floor = set1(1.0e-20f);
+    const Vec toDb = set1(4.34294481903251828f);
+    const Vec fromDb = set1(0.115129254649702284f);
+    const Vec zero = set1(0.0f);
+    const Vec one = set1(1.0f);
+    const VecD envB0 = setD(c.envB0);
+    const int numStages = c.numStages;
+    const bool separateKey = keyLeft != nullptr;
+    bool ramping = false;
+    for (int b = 0; b < c.numBands; b++)
+        ramping = ramping || c.thresholdStep[b] != 0 || c.ratioStep[b] != 0;
+    alignas(64) double bandLeft[bandLanes];
+    alignas(64) double bandRight[bandLanes];
+    alignas(64) float gainRange[2][bandLanes];
+
+    for (int start = 0; start < numSamples; start += bandChunk) {
+        const int n = std::min(bandChunk, numSamples - start);
+        double sumLeft[bandChunk] = {};
+        double sumRight[bandChunk] = {};
+
+        for (int g = 0; g < c.numBands; g += halfWidth) {
+            const int groupBands = std::min(halfWidth, c.numBands - g);
+            VecD z1[2][maxCrossoverStages], z2[2][maxCrossoverStages];
+            VecD keyZ1[2][maxCrossoverStages], keyZ2[2][maxCrossoverStages];
+            for (int st = 0; st < numStages; st++) {
+                for (int ch = 0; ch < 2; ch++) {
+                    z1[ch][st] = loadD(s.z1[ch][st] + g);
+                    z2[ch][st] = loadD(s.z2[ch][st] + g);
+                    keyZ1[ch][st] = loadD(s.keyZ1[ch][st] + g);
+                    keyZ2[ch][st] = loadD(s.keyZ2[ch][st] + g);
+                }
+            }
+            VecD env = loadD(s.envOut + g);
+            VecD gain = loadD(s.gainOutLinear + g);
+            const VecD attack = loadD(c.attackCoeff + g);
+            const VecD release = loadD(c.releaseCoeff + g);
+            const Vec thresholdStart = load(c.thresholdDb + g);
+            const Vec ratioStart = load(c.ratio + g);
+            Vec thresh = thresholdStart;
+            Vec slope = sub(div(one, ratioStart), one);
+            Vec minGain = load(s.minGainLinear + g);
+            Vec maxGain = load(s.maxGainLinear + g);
+
+            for (int j = 0; j < n; j++) {
+                const int i = start + j;
+                const float pre = c.preGainLinear + i*c.preGainStep;
+
+                // crossover network, every lane gets the same input
+                VecD l = setD(left[i]*pre);
+                VecD r = setD(right[i]*pre);
+                VecD kl = l;
+                VecD kr = r;
+                if (separateKey) {
+                    kl = setD(keyLeft[i]*pre);
+                    kr = setD(keyRight[i]*pre);
+                }
+                for (int st = 0; st < numStages; st++) {
+                    const VecD b0 = loadD(c.b0[st] + g);
+                    const VecD b1 = loadD(c.b1[st] + g);
+                    const VecD b2 = loadD(c.b2[st] + g);
+                    const VecD a1 = loadD(c.a1[st] + g);
+                    const VecD a2 = loadD(c.a2[st] + g);
+                    l = bandBiquad(l, b0, b1, b2, a1, a2, z1[0][st], z2[0][st]);
+                    r = bandBiquad(r, b0, b1, b2, a1, a2, z1[1][st], z2[1][st]);
+                    if (separateKey) {
+                        kl = bandBiquad(kl, b0, b1, b2, a1, a2, keyZ1[0][st], keyZ2[0][st]);
+                        kr = bandBiquad(kr, b0, b1, b2, a1, a2, keyZ1[1][st], keyZ2[1][st]);
+                    }
+                }
+                if (!separateKey) {
+                    kl = l;
+                    kr = r;
+                }
+
+                // RMS detector
+                env = addD(env, mulD(envB0, subD(mulD(half, addD(mulD(kl, kl), mulD(kr, kr))), env)));
+
+                // gain computer
+                if (ramping) {
+                    const Vec sampleIndex = set1((float) i);
+                    thresh = add(thresholdStart, mul(load(c.thresholdStep + g), sampleIndex));
+                    slope = sub(div(one, add(ratioStart, mul(load(c.ratioStep + g), sampleIndex))), one);
+                }
+                Vec levelDb = mul(fastLog(max(toFloat(env, env), floor)), toDb);
+                Vec target = fastExp(mul(min(zero, mul(slope, sub(levelDb, thresh))), fromDb));
+
+                // gain dynamics
+                const VecD targetD = lowToDouble(target);
+                gain = addD(gain, mulD(selectLessD(targetD, gain, attack, release), subD(targetD, gain)));
+                const Vec gainFloat = toFloat(gain, gain);
+                minGain = min(minGain, gainFloat);
+                maxGain = max(maxGain, gainFloat);
+
+                // sum the bands of this group
+                storeD(bandLeft, mulD(l, gain));
+                storeD(bandRight, mulD(r, gain));
+                for (int b = 0; b < groupBands; b++) {
+                    sumLeft[j] += bandLeft[b];
+                    sumRight[j] += bandRight[b];
+                }
+            }
+
+            for (int st = 0; st < numStages; st++) {
+                for (int ch = 0; ch < 2; ch++) {
+                    storeD(s.z1[ch][st] + g, z1[ch][st]);
+                    storeD(s.z2[ch][st] + g, z2[ch][st]);
+                    storeD(s.keyZ1[ch][st] + g, keyZ1[ch][st]);
+                    storeD(s.keyZ2[ch][st] + g, keyZ2[ch][st]);
+                }
+            }
+            storeD(s.envOut + g, env);
+            storeD(s.gainOutLinear + g, gain);
+
+            // a Vec spans the next group's bands too, only this group's go back
+            store(gainRange[0], minGain);
+            store(gainRange[1], maxGain);
+            for (int b = 0; b < groupBands; b++) {
+                s.minGainLinear[g + b] = gainRange[0][b];
+                s.maxGainLinear[g + b] = gainRange[1][b];
+            }
+        }
+
+        // post gain
+        for (int j = 0; j < n; j++) {
+            const float post = c.postGainLinear + (start + j)*c.postGainStep;
+            left[start + j] = sumLeft[j]*post;
+            right[start + j] = sumRight[j]*post;
+        }
+    }
+}
+
+// key filter, one biquad over a channel: y[i..i+width) is the inputs
+// times the shifted impulse response plus the state terms, then the state
+// for the next vector comes from the last two inputs and outputs.
+// x and y may be the same buffer
+KERNEL_TARGET static void keyFilterStage(const float* x, float* y, int numSamples,
+                                         const KeyFilterCoeffs& c, int stage, float& z1, float& z2)
+{
+    const float* h = c.impulse[stage] + keyBlock;
+    const Vec fromZ1 = load(c.fromZ1[stage]);
+    const Vec fromZ2 = load(c.fromZ2[stage]);
+    const float b1 = c.b1[stage], b2 = c.b2[stage], a1 = c.a1[stage], a2 = c.a2[stage];
+    for (int i = 0; i < numSamples; i += width) {
+        Vec acc = add(mul(fromZ1, set1(z1)), mul(fromZ2, set1(z2)));
+        for (int j = 0; j < width; j++)
+            acc = add(acc, mul(load(h - j), set1(x[i + j])));
+        const float x1 = x[i + width - 1];
+        const float x2 = x[i + width - 2];
+        store(y + i, acc);
+        const float y1 = y[i + width - 1];
+        const float y2 = y[i + width - 2];
+        z2 = b2*x1 - a2*y1;
+        z1 = b1*x1 + (b2*x2 - a2*y2) - a1*y1;
+    }
+}
+
+// stage 5: pre gain, post gain and gain application (in place)
+KERNEL_TARGET static void applyStage(float* left, float* right, const float* gain, int numSamples,
+                                     float preGainLinear, float preGainStep,
+                                     float postGainLinear, float postGainStep)
+{
+    for (int i = 0; i < numSamples; i += width) {
+        Vec pre = ramp(preGainLinear, preGainStep, i);
+        Vec g = mul(load(gain + i), ramp(postGainLinear, postGainStep, i));
+        store(left + i, mul(mul(load(left + i), pre), g));
+        store(right + i, mul(mul(load(right + i), pre), g));
+    }
+}
+
+// stage 5 for a single channel
+KERNEL_TARGET static void applyMonoStage(float* x, const float* gain, int numSamples,
+                                         float preGainLinear, float preGainStep,
+                                         float postGainLinear, float postGainStep)
+{
+    for (int i = 0; i < numSamples; i += width) {
+        Vec pre = ramp(preGainLinear, preGainStep, i);
+        Vec g = mul(load(gain + i), ramp(postGainLinear, postGainStep, i));
+        store(x + i, mul(mul(load(x + i), pre), g));
+    }
+}
+
+// batch, samples per pass (each call handles at most this many)
+constexpr int batchChunk = 64;
+
+// the detector's input as floats: float audio as it is, double audio as a
+// float copy in buffer, as the block loop's key
+KERNEL_TARGET static inline const float* floatSamples(const float* x, float*, int)
+{
+    return x;
+}
+
+KERNEL_TARGET static inline const float* floatSamples(const double* x, float* buffer, int numSamples)
+{
+    for (int i = 0; i < numSamples; i++)
+        buffer[i] = (float) x[i];
+    return buffer;
+}
+
+// batch, detector input of one lane: the mean of its channels' squared,
+// pre gained samples. One or two channels go through powerStage (a mono
+// one as both sides, which squares it exactly), like the block loop's key
+template <typename Sample>
+KERNEL_TARGET static void batchPower(const Sample* const* lane, int numChannels, int start, float* power,
+                                     int numSamples, float preGainLinear, float preGainStep)
+{
+    alignas(64) float copy[2][batchChunk];
+    const int vectorEnd = numSamples - numSamples % width;
+    const float pre = preGainLinear + start*preGainStep;
+    if (numChannels <= 2) {
+        const float* l = floatSamples(lane[0] + start, copy[0], numSamples);
+        const float* r = numChannels == 2 ? floatSamples(lane[1] + start, copy[1], numSamples) : l;
+        powerStage(l, r, power, vectorEnd, pre, preGainStep);
+        for (int j = vectorEnd; j < numSamples; j++) {
+            const float gain = pre + j*preGainStep;
+            const float keyL = l[j]*gain;
+            const float keyR = r[j]*gain;
+            power[j] = 0.5f*(keyL*keyL + keyR*keyR);
+        }
+        return;
+    }
+
+    std::fill(power, power + numSamples, 0.0f);
+    for (int ch = 0; ch < numChannels; ch++) {
+        const float* key = floatSamples(lane[ch] + start, copy[0], numSamples);
+        sumSquaresStage(key, power, vectorEnd, pre, preGainStep);
+        for (int j = vectorEnd; j < numSamples; j++) {
+            const float x = key[j]*(pre + j*preGainStep);
+            power[j] += x*x;
+        }
+    }
+    const float scale = 1.0f/numChannels;
+    for (int j = 0; j < numSamples; j++)
+        power[j] *= scale;
+}
+
+// batch, the gains of one lane applied to each of its channels, in pairs
+KERNEL_TARGET static void batchApply(float* const* lane, int numChannels, int start, const float* gain,
+                                     int numSamples, float preGainLinear, float preGainStep,
+                                     float postGainLinear, float postGainStep)
+{
+    const int vectorEnd = numSamples - numSamples % width;
+    const float pre = preGainLinear + start*preGainStep;
+    const float post = postGainLinear + start*postGainStep;
+    for (int ch = 0; ch < numChannels; ch += 2) {
+        float* l = lane[ch] + start;
+        if (ch + 1 == numChannels) {
+            applyMonoStage(l, gain, vectorEnd, pre, preGainStep, post, postGainStep);
+            for (int j = vectorEnd; j < numSamples; j++)
+                l[j] = (l[j]*(pre + j*preGainStep))*(gain[j]*(post + j*postGainStep));
+            continue;
+        }
+        float* r = lane[ch + 1] + start;
+        applyStage(l, r, gain, vectorEnd, pre, preGainStep, post, postGainStep);
+        for (int j = vectorEnd; j < numSamples; j++) {
+            const float g = gain[j]*(post + j*postGainStep);
+            l[j] = (l[j]*(pre + j*preGainStep))*g;
+            r[j] = (r[j]*(pre + j*preGainStep))*g;
+        }
+    }
+}
+
+// the same for double audio, with the gains in double, as the block loop
+// applies them
+KERNEL_TARGET static void batchApply(double* const* lane, int numChannels, int start, const double* gain,
+                                     int numSamples, float preGainLinear, float preGainStep,
+                                     float postGainLinear, float postGainStep)
+{
+    const float pre = preGainLinear + start*preGainStep;
+    const float post = postGainLinear + start*postGainStep;
+    for (int ch = 0; ch < numChannels; ch++) {
+        double* x = lane[ch] + start;
+        for (int j = 0; j < numSamples; j++)
+            x[j] = (x[j]*(pre + j*preGainStep))*(gain[j]*(post + j*postGainStep));
+    }
+}
+
+// a group's gains for one sample, in the audio's precision
+KERNEL_TARGET static inline void storeGains(float* p, VecD low, VecD high)
+{
+    store(p, toFloat(low, high));
+}
+
+KERNEL_TARGET static inline void storeGains(double* p, VecD low, VecD high)
+{
+    storeD(p, low);
+    storeD(p + width/2, high);
+}
+
+// width x width doubles, as four blocks of transposeBlockD
+KERNEL_TARGET static inline void transposeBlock(const double* in, int inStride, double* out, int outStride)
+{
+    constexpr int half = width/2;
+    for (int i = 0; i < width; i += half)
+        for (int j = 0; j < width; j += half)
+            transposeBlockD(in + i*inStride + j, inStride, out + j*outStride + i, outStride);
+}
+
+// batch: a compressor per lane (groups of width lanes if there are more).
+// The key power and the gain application run per lane with the stages
+// above, and are transposed a block at a time to and from a sample-major
+// buffer for the rest, which runs one sample at a time with the lanes
+// side by side. As in the block loop, the gain computer is a pass of its
+// own between the two recurrences, so its latency overlaps across samples
+// instead of holding up the gain. The integrators stay double, and each
+// stereo lane gives the block loop's result (computed curve) bit for bit;
+// for double audio too, whose gains go back to the lanes in double.
+template <typename Sample>
+KERNEL_TARGET static void batchStage(const Sample* const* keyChannels, int numKeyChannels,
+                                     Sample* const* channels, int numSamples,
+                                     const BatchCoeffs& c, BatchState& s)
+{
+    constexpr int half = width/2;
+    const Vec floor = set1(1.0e-20f);
+    const Vec toDb = set1(4.34294481903251828f);
+    const Vec fromDb = set1(0.115129254649702284f);
+    const Vec zero = set1(0.0f);
+    const Vec one = set1(1.0f);
+    const VecD envB0 = setD(c.envB0);
+    const int numGroupLanes = (c.numLanes + width - 1)/width*width;
+    bool ramping = false;
+    for (int k = 0; k < c.numLanes; k++)
+        ramping = ramping || c.thresholdStep[k] != 0 || c.ratioStep[k] != 0;
+
+    // each lane's channels follow the previous lane's
+    Sample* const* lanes[batchLanes];
+    for (int k = 0, ch = 0; k < c.numLanes; ch += c.laneChannels[k], k++)
+        lanes[k] = channels + ch;
+
+    alignas(64) float laneBuffer[batchLanes][batchChunk];   // per lane: detector input
+    alignas(64) float sampleBuffer[batchChunk][batchLanes]; // the same, transposed, then the target gain
+    alignas(64) Sample sampleGains[batchChunk][batchLanes]; // gain, in the audio's precision
+    alignas(64) Sample laneGains[batchLanes][batchChunk];   // the same, transposed back
+
+    for (int start = 0; start < numSamples; start += batchChunk) {
+        const int n = std::min(batchChunk, numSamples - start);
+        const int vectorEnd = n - n % width;
+
+        // pre gain + squaring, the idle lanes of the last group stay silent
+        for (int k = 0; k < c.numLanes; k++) {
+            if (numKeyChannels > 0)
+                batchPower(keyChannels, numKeyChannels, start, laneBuffer[k], n,
+                           c.preGainLinear[k], c.preGainStep[k]);
+            else
+                batchPower(lanes[k], c.laneChannels[k], start, laneBuffer[k], n,
+                           c.preGainLinear[k], c.preGainStep[k]);
+        }
+        for (int k = c.numLanes; k < numGroupLanes; k++)
+            std::fill(laneBuffer[k], laneBuffer[k] + n, 0.0f);
+        for (int g = 0; g < c.numLanes; g += width) {
+            for (int j = 0; j < vectorEnd; j += width)
+                transposeBlock(laneBuffer[g] + j, batchChunk, sampleBuffer[j] + g, batchLanes);
+            for (int j = vectorEnd; j < n; j++)
+                for (int k = g; k < g + width; k++)
+                    sampleBuffer[j][k] = laneBuffer[k][j];
+        }
+
+        for (int g = 0; g < c.numLanes; g += width) {
+            // RMS detector
+            VecD envLow = loadD(s.envOut + g);
+            VecD envHigh = loadD(s.envOut + g + half);
+            for (int j = 0; j < n; j++) {
+                const Vec power = load(sampleBuffer[j] + g);
+                envLow = addD(envLow, mulD(envB0, subD(lowToDouble(power), envLow)));
+                envHigh = addD(envHigh, mulD(envB0, subD(highToDouble(power), envHigh)));
+                store(sampleBuffer[j] + g, toFloat(envLow, envHigh));
+            }
+            storeD(s.envOut + g, envLow);
+            storeD(s.envOut + g + half, envHigh);
+
+            // gain computer
+            const Vec thresholdStart = load(c.thresholdDb + g);
+            const Vec ratioStart = load(c.ratio + g);
+            Vec thresh = thresholdStart;
+            Vec slope = sub(div(one, ratioStart), one);
+            for (int j = 0; j < n; j++) {
+                if (ramping) {
+                    const Vec sampleIndex = set1((float) (start + j));
+                    thresh = add(thresholdStart, mul(load(c.thresholdStep + g), sampleIndex));
+                    slope = sub(div(one, add(ratioStart, mul(load(c.ratioStep + g), sampleIndex))), one);
+                }
+                Vec levelDb = mul(fastLog(max(load(sampleBuffer[j] + g), floor)), toDb);
+                store(sampleBuffer[j] + g, fastExp(mul(min(zero, mul(slope, sub(levelDb, thresh))), fromDb)));
+            }
+
+            // gain dynamics
+            VecD gainLow = loadD(s.gainOutLinear + g);
+            VecD gainHigh = loadD(s.gainOutLinear + g + half);
+            const VecD attackLow = loadD(c.attackCoeff + g);
+            const VecD attackHigh = loadD(c.attackCoeff + g + half);
+            const VecD releaseLow = loadD(c.releaseCoeff + g);
+            const VecD releaseHigh = loadD(c.releaseCoeff + g + half);
+            Vec minGain = load(s.minGainLinear + g);
+            Vec maxGain = load(s.maxGainLinear + g);
+            for (int j = 0; j < n; j++) {
+                const Vec target = load(sampleBuffer[j] + g);
+                const VecD targetLow = lowToDouble(target);
+                const VecD targetHigh = highToDouble(target);
+                gainLow = addD(gainLow, mulD(selectLessD(targetLow, gainLow, attackLow, releaseLow),
+                                             subD(targetLow, gainLow)));
+                gainHigh = addD(gainHigh, mulD(selectLessD(targetHigh, gainHigh, attackHigh, releaseHigh),
+                                               subD(targetHigh, gainHigh)));
+                storeGains(sampleGains[j] + g, gainLow, gainHigh);
+                const Vec gainFloat = toFloat(gainLow, gainHigh);
+                minGain = min(minGain, gainFloat);
+                maxGain = max(maxGain, gainFloat);
+            }
+            storeD(s.gainOutLinear + g, gainLow);
+            storeD(s.gainOutLinear + g + half, gainHigh);
+            store(s.minGainLinear + g, minGain);
+            store(s.maxGainLinear + g, maxGain);
+        }
+
+        // pre gain + post gain + apply
+        for (int g = 0; g < c.numLanes; g += width) {
+            for (int j = 0; j < vectorEnd; j += width)
+                transposeBlock(sampleGains[j] + g, batchLanes, laneGains[g] + j, batchChunk);
+            for (int j = vectorEnd; j < n; j++)
+                for (int k = g; k < g + width; k++)
+                    laneGains[k][j] = sampleGains[j][k];
+        }
+        for (int k = 0; k < c.numLanes; k++)
+            batchApply(lanes[k], c.laneChannels[k], start, laneGains[k], n,
+                       c.preGainLinear[k], c.preGainStep[k], c.postGainLinear[k], c.postGainStep[k]);
+    }
+
+    // detector level for meters, once per call, -200 dB for a silent lane
+    for (int k = 0; k < c.numLanes; k++)
+        s.rmsEnvelopeDb[k] = (float) (10*std::log10(std::max(s.envOut[k], 1.0e-20)));
+}
@@ -0,0 +1,199 @@
+/*
+  ==============================================================================
+
+    CompressorState.cpp
+    Created: 17 Oct 2026 9:12:48am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "CompressorState.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const int numParameters = CompressorEngine::numParameters;
+    const size_t bankHeaderSize = 12;
+    const size_t nameSize = CompressorState::maxNameLength + 1;
+
+    uint16_t readU16(const uint8_t* p) { return (uint16_t) (p[0] | (p[1] << 8)); }
+    uint32_t readU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24); }
+
+    float readF32(const uint8_t* p) {
+        const uint32_t bits = readU32(p);
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return f;
+    }
+
+    uint8_t* writeU16(uint8_t* p, uint16_t v) {
+        p[0] = v & 0xff;
+        p[1] = v >> 8;
+        return p + 2;
+    }
+
+    uint8_t* writeU32(uint8_t* p, uint32_t v) {
+        for (int i = 0; i < 4; i++)
+            p[i] = (v >> (8*i)) & 0xff;
+        return p + 4;
+    }
+
+    uint8_t* writeF32(uint8_t* p, float f) {
+        uint32_t bits;
+        std::memcpy(&bits, &f, 4);
+        return writeU32(p, bits);
+    }
+
+    struct ParameterHashes {
+        uint32_t hash[numParameters];
+        ParameterHashes() {
+            for (int i = 0; i < numParameters; i++)
+                hash[i] = CompressorState::hashParameterId(CompressorEngine::getParameterId((CompressorEngine::Parameter) i));
+        }
+    };
+
+    // the parameter with this ID hash, or -1
+    int findParameter(uint32_t hash) {
+        static const ParameterHashes hashes;
+        for (int i = 0; i < numParameters; i++) {
+            if (hashes.hash[i] == hash)
+                return i;
+        }
+        return -1;
+    }
+
+    void setDefaults(float* values) {
+        for (int i = 0; i < numParameters; i++)
+            values[i] = CompressorEngine::getParameterDefault((CompressorEngine::Parameter) i);
+    }
+}
+
+uint32_t CompressorState::hashParameterId(const char* id) {
+    uint32_t hash = 2166136261u;
+    for (; *id != 0; id++)
+        hash = (hash ^ (uint8_t) *id)*16777619u;
+    return hash;
+}
+
+size_t CompressorState::writeState(const float* values, uint8_t* out) {
+    uint8_t* p = out;
+    std::memcpy(p, "M45S", 4);
+    p = writeU16(p + 4, version);
+    p = writeU16(p, (uint16_t) numParameters);
+    for (int i = 0; i < numParameters; i++) {
+        p = writeU32(p, hashParameterId(CompressorEngine::getParameterId((CompressorEngine::Parameter) i)));
+        p = writeF32(p, values[i]);
+    }
+    return (size_t) (p - out);
+}
+
+bool CompressorState::readState(const void* data, size_t size, float* values) {
+    const uint8_t* p = (const uint8_t*) data;
+    if (p == nullptr || size < 8 || std::memcmp(p, "M45S", 4) != 0)
+        return false;
+    const int count = readU16(p + 6);
+    if (size < 8 + 8*(size_t) count)
+        return false;
+
+    setDefaults(values);
+    for (int k = 0; k < count; k++) {
+        const uint8_t* entry = p + 8 + 8*k;
+        const int param = findParameter(readU32(entry));
+        if (param >= 0)
+            values[param] = readF32(entry + 4);
+    }
+    return true;
+}
+
+bool CompressorState::PresetBank::open(const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*) data;
+    numPresets = 0;
+    if (p == nullptr || size < bankHeaderSize || std::memcmp(p, "M45B", 4) != 0)
+        return false;
+    const int numColumns = readU16(p + 6);
+    const uint32_t presets = readU32(p + 8);
+    rowSize = nameSize + 4*(size_t) numColumns;
+    const size_t rowsOffset = bankHeaderSize + 4*(size_t) numColumns;
+    if (size < rowsOffset || (size - rowsOffset)/rowSize < presets)
+        return false;
+
+    for (int i = 0; i < numParameters; i++)
+        columns[i] = -1;
+    for (int c = 0; c < numColumns; c++) {
+        const int param = findParameter(readU32(p + bankHeaderSize + 4*c));
+        if (param >= 0)
+            columns[param] = c;
+    }
+
+    rows = p + rowsOffset;
+    for (uint32_t k = 0; k < presets; k++) {
+        if (rows[k*rowSize + maxNameLength] != 0)
+            return false; // names are null terminated
+    }
+    numPresets = (int) presets;
+    return true;
+}
+
+const char* CompressorState::PresetBank::getName(int preset) const {
+    return (const char*) (rows + preset*rowSize);
+}
+
+int CompressorState::PresetBank::findPreset(const char* name) const {
+    for (int k = 0; k < numPresets; k++) {
+        if (std::strcmp(getName(k), name) == 0)
+            return k;
+    }
+    return -1;
+}
+
+void CompressorState::PresetBank::getValues(int preset, float* values) const {
+    const uint8_t* row = rows + preset*rowSize + nameSize;
+    for (int i = 0; i < numParameters; i++)
+        values[i] = columns[i] >= 0 ? readF32(row + 4*columns[i])
+                                    : CompressorEngine::getParameterDefault((CompressorEngine::Parameter) i);
+}
+
+void CompressorState::addPreset(std::vector<uint8_t>& bank, const std::string& name, const float* values) {
+    // what the bank has, in the current layout
+    struct Preset {
+        char name[nameSize];
+        float values[numParameters];
+    };
+    std::vector<Preset> presets;
+    PresetBank existing;
+    if (existing.open(bank.data(), bank.size())) {
+        presets.resize(existing.getNumPresets());
+        for (int k = 0; k < existing.getNumPresets(); k++) {
+            std::memcpy(presets[k].name, existing.getName(k), nameSize);
+            existing.getValues(k, presets[k].values);
+        }
+    }
+
+    Preset preset = {};
+    std::strncpy(preset.name, name.c_str(), maxNameLength);
+    std::copy(values, values + numParameters, preset.values);
+    auto same = std::find_if(presets.begin(), presets.end(),
+                             [&](const Preset& p) { return std::strcmp(p.name, preset.name) == 0; });
+    if (same != presets.end())
+        *same = preset;
+    else
+        presets.push_back(preset);
+
+    bank.assign(bankHeaderSize + 4*numParameters + presets.size()*(nameSize + 4*numParameters), 0);
+    uint8_t* p = bank.data();
+    std::memcpy(p, "M45B", 4);
+    p = writeU16(p + 4, version);
+    p = writeU16(p, (uint16_t) numParameters);
+    p = writeU32(p, (uint32_t) presets.size());
+    for (int i = 0; i < numParameters; i++)
+        p = writeU32(p, hashParameterId(CompressorEngine::getParameterId((CompressorEngine::Parameter) i)));
+    for (const Preset& row : presets) {
+        std::memcpy(p, row.name, nameSize);
+        p += nameSize;
+        for (int i = 0; i < numParameters; i++)
+            p = writeF32(p, row.values[i]);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    CompressorState.h
+    Created: 17 Oct 2026 9:12:48am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "CompressorEngine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//==============================================================================
+/**
+ Saved plugin state and preset banks, without JUCE so that the command
+ line tools read and write the same files.
+
+ A state blob (getStateInformation) is, little endian,
+     "M45S", u16 version, u16 count, count * { u32 id hash, f32 value }
+ with values in parameter units (dB, ms, ...), 280 bytes for all 34
+ parameters. Entries are matched by the FNV-1a hash of the parameter ID
+ rather than by position, so parameters can be added or reordered:
+ unknown entries are skipped, parameters a blob lacks get their defaults.
+
+ A preset bank file is
+     "M45B", u16 version, u16 numColumns, u32 numPresets,
+     numColumns * u32 id hash,
+     numPresets * { char name[32], numColumns * f32 value }
+ The rows have a fixed size, so a bank is used where it lies (a mapped
+ file): PresetBank::open() matches the columns to the parameters once,
+ after that switching presets reads one row and never allocates.
+*/
+namespace CompressorState
+{
+    const uint16_t version = 1;
+    const size_t maxStateSize = 8 + 8*CompressorEngine::numParameters;
+    const int maxNameLength = 31;
+
+    uint32_t hashParameterId(const char* id);
+
+    // values[numParameters] into out (maxStateSize bytes), returns the size
+    size_t writeState(const float* values, uint8_t* out);
+
+    // fills in values[numParameters]; false, values untouched, if data is
+    // not a state blob (e.g. the XML state of older versions)
+    bool readState(const void* data, size_t size, float* values);
+
+    class PresetBank
+    {
+    public:
+        // data has to outlive the bank; false if it is not a bank
+        bool open(const void* data, size_t size);
+
+        int getNumPresets() const { return numPresets; }
+        const char* getName(int preset) const;
+        int findPreset(const char* name) const; // -1 if there is none
+
+        // values[numParameters], defaults for the parameters the bank lacks
+        void getValues(int preset, float* values) const;
+
+    private:
+        const uint8_t* rows = nullptr;
+        int numPresets = 0;
+        size_t rowSize = 0;
+        int columns[CompressorEngine::numParameters] = {}; // per parameter, -1 if missing
+    };
+
+    // adds a preset to bank (the whole file, empty for a new bank),
+    // replacing the one of the same name. A bank written by another
+    // version is rewritten with the current parameters
+    void addPreset(std::vector<uint8_t>& bank, const std::string& name, const float* values);
+}
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    LoadMonitor.h
+    Created: 17 Oct 2026 11:03:26am
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+/**
+ CPU load of processBlock against its real-time budget (numSamples/fs):
+ begin() and end() around a block measure its time and cycles, and the
+ load (time/budget) goes into a histogram of quarter octave bins from
+ 0.1% to 400%, next to overrun (load > 100%) and worst block counters.
+
+ The audio thread is the only writer; any thread can call getStats() at
+ any time without locking. Counters are read one at a time, so stats
+ taken while a block ends can be off by that block. reset() only asks
+ the audio thread to clear everything at its next end(), which keeps it
+ the only writer.
+
+ Disabled (the default) a block costs one relaxed atomic load. Cycles
+ are the time stamp counter on x86 (constant rate, not the core clock)
+ and the virtual counter on ARM64, 0 elsewhere.
+*/
+class LoadMonitor
+{
+public:
+    static constexpr int numBins = 48;
+    static constexpr int lowestOctave = -10; // bin 0 starts at 2^-10, and takes anything lower
+
+    struct Stats {
+        uint64_t blocks = 0;
+        uint64_t overruns = 0;          // blocks that took longer than their budget
+        double meanLoad = 0;            // all the time over all the budget
+        double peakLoad = 0;
+        double lastLoad = 0;
+        double cyclesPerSample = 0;     // mean
+        uint64_t bins[numBins] = {};    // blocks per load range, see getBinStart
+
+        // load that fraction (0..1) of the blocks stayed below, to the
+        // resolution of the bins
+        double getLoadPercentile(double fraction) const {
+            uint64_t count = 0;
+            for (int b = 0; b < numBins; b++) {
+                count += bins[b];
+                if (count > 0 && count >= fraction*blocks)
+                    return getBinStart(b + 1);
+            }
+            return peakLoad;
+        }
+    };
+
+    // lowest load that falls into bin
+    static double getBinStart(int bin) {
+        return std::ldexp(1.0 + (bin & 3)/4.0, bin/4 + lowestOctave);
+    }
+
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // any thread, carried out by the audio thread at the end of its next block
+    void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+    // audio thread, around everything processBlock does
+    void begin() {
+        recording = enabled.load(std::memory_order_relaxed);
+        if (recording) {
+            startCycles = readCycles();
+            startTime = Clock::now();
+        }
+    }
+
+    void end(int numSamples, double sampleRate) {
+        if (!recording)
+            return;
+        recording = false;
+        const double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+        const uint64_t cycles = readCycles() - startCycles;
+
+        if (resetRequested.load(std::memory_order_relaxed)) {
+            resetRequested.store(false, std::memory_order_relaxed);
+            clear();
+        }
+        if (numSamples <= 0 || sampleRate <= 0)
+            return;
+
+        const double budget = numSamples/sampleRate;
+        const float load = (float) (seconds/budget);
+        add(blocks, 1);
+        add(totalNs, (uint64_t) (seconds*1e9));
+        add(budgetNs, (uint64_t) (budget*1e9));
+        add(totalCycles, cycles);
+        add(totalSamples, (uint64_t) numSamples);
+        if (load > 1)
+            add(overruns, 1);
+        if (load > peakLoad.load(std::memory_order_relaxed))
+            peakLoad.store(load, std::memory_order_relaxed);
+        lastLoad.store(load, std::memory_order_relaxed);
+        add(bins[getBin(load)], 1);
+    }
+
+    // any thread
+    Stats getStats() const {
+        Stats stats;
+        stats.blocks = blocks.load(std::memory_order_relaxed);
+        stats.overruns = overruns.load(std::memory_order_relaxed);
+        const uint64_t budget = budgetNs.load(std::memory_order_relaxed);
+        const uint64_t samples = totalSamples.load(std::memory_order_relaxed);
+        stats.meanLoad = budget > 0 ? (double) totalNs.load(std::memory_order_relaxed)/budget : 0;
+        stats.peakLoad = peakLoad.load(std::memory_order_relaxed);
+        stats.lastLoad = lastLoad.load(std::memory_order_relaxed);
+        stats.cyclesPerSample = samples > 0 ? (double) totalCycles.load(std::memory_order_relaxed)/samples : 0;
+        for (int b = 0; b < numBins; b++)
+            stats.bins[b] = bins[b].load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static uint64_t readCycles() {
+       #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+        return __rdtsc();
+       #elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+       #else
+        return 0;
+       #endif
+    }
+
+    // quarter octaves straight from the float's exponent and top two
+    // mantissa bits (so linear within each octave)
+    static int getBin(float load) {
+        uint32_t bits;
+        std::memcpy(&bits, &load, 4);
+        const int octave = (int) ((bits >> 23) & 0xff) - 127 - lowestOctave;
+        const int bin = octave*4 + (int) ((bits >> 21) & 3);
+        return bin < 0 ? 0 : (bin >= numBins ? numBins - 1 : bin);
+    }
+
+    // only ever written by the audio thread, so no read-modify-write needed
+    static void add(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (auto* counter : { &blocks, &overruns, &totalNs, &budgetNs, &totalCycles, &totalSamples })
+            counter->store(0, std::memory_order_relaxed);
+        for (auto& bin : bins)
+            bin.store(0, std::memory_order_relaxed);
+        peakLoad.store(0, std::memory_order_relaxed);
+        lastLoad.store(0, std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> enabled { false };
+    std::atomic<bool> resetRequested { false };
+
+    // audio thread only
+    bool recording = false;
+    uint64_t startCycles = 0;
+    Clock::time_point startTime;
+
+    std::atomic<uint64_t> blocks { 0 };
+    std::atomic<uint64_t> overruns { 0 };
+    std::atomic<uint64_t> totalNs { 0 };
+    std::atomic<uint64_t> budgetNs { 0 };
+    std::atomic<uint64_t> totalCycles { 0 };
+    std::atomic<uint64_t> totalSamples { 0 };
+    std::atomic<float> peakLoad { 0 };
+    std::atomic<float> lastLoad { 0 };
+    std::atomic<uint64_t> bins[numBins] = {};
+};
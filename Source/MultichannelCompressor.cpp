@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    MultichannelCompressor.cpp
+    Created: 17 Oct 2026 1:36:08pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "MultichannelCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+
+void MultichannelCompressor::prepare(double sampleRate, int maxBlockSize, int newNumChannels, const int* newPairedWith) {
+    fs = sampleRate;
+    numChannels = std::min(std::max(newNumChannels, 0), maxChannels);
+    engine.prepare(sampleRate, maxBlockSize);
+
+    // a partner has to name the channel back
+    for (int ch = 0; ch < numChannels; ch++)
+        pairedWith[ch] = newPairedWith != nullptr ? newPairedWith[ch] : (ch ^ 1) < numChannels ? ch ^ 1 : -1;
+    for (int ch = 0; ch < numChannels; ch++) {
+        const int partner = pairedWith[ch];
+        if (partner < 0 || partner >= numChannels || partner == ch || pairedWith[partner] != ch)
+            pairedWith[ch] = -1;
+    }
+
+    // the batch is first laid out per channel, its most instances, so that
+    // going to any other linking later doesn't allocate
+    batch.prepareChannels(sampleRate, numChannels, 1);
+
+    const int spareSize = numChannels == 1 ? std::max(maxBlockSize, minScratch) : 0;
+    spareFloat.assign(spareSize, 0.0f);
+    spareDouble.assign(spareSize, 0.0);
+
+    activeLink = -1;
+    applyLink();
+}
+
+void MultichannelCompressor::reset() {
+    engine.reset();
+    batch.reset();
+}
+
+void MultichannelCompressor::applyLink() {
+    const int link = (int) std::lround(engine.getParameter(CompressorEngine::channelLink));
+    const bool onEngine = runsOnEngine(numChannels, link);
+    if (onEngine && !usingEngine)
+        engine.reset(); // nothing of what it had is still in the audio
+    usingEngine = onEngine;
+
+    // the batch takes each instance's channels one after the other, so a
+    // pair goes side by side where its first channel is
+    int instanceChannels[maxChannels];
+    int numInstances = 0;
+    int ordered = 0;
+    bool placed[maxChannels] = {};
+    for (int ch = 0; ch < numChannels; ch++) {
+        if (placed[ch])
+            continue;
+        batchOrder[ordered++] = ch;
+        const int partner = link == inPairs ? pairedWith[ch] : -1;
+        if (partner >= 0) {
+            batchOrder[ordered++] = partner;
+            placed[partner] = true;
+        }
+        instanceChannels[numInstances++] = partner >= 0 ? 2 : 1;
+    }
+    batchInOrder = true;
+    for (int ch = 0; ch < numChannels; ch++)
+        batchInOrder = batchInOrder && batchOrder[ch] == ch;
+
+    // every instance has the engine's settings, straight away
+    if (link == linked)
+        batch.prepareChannels(fs, numChannels, std::max(numChannels, 1));
+    else
+        batch.prepareInstances(fs, numInstances, instanceChannels);
+    for (int i = 0; i < batch.getNumInstances(); i++) {
+        for (int p = 0; CompressorBatch::isBatchParameter((CompressorEngine::Parameter) p); p++)
+            batch.setParameter(i, (CompressorEngine::Parameter) p, engine.getParameter((CompressorEngine::Parameter) p));
+    }
+    batch.reset();
+    activeLink = link;
+}
+
+void MultichannelCompressor::setParameter(CompressorEngine::Parameter param, float value) {
+    engine.setParameter(param, value);
+    if (CompressorBatch::isBatchParameter(param)) {
+        for (int i = 0; i < batch.getNumInstances(); i++)
+            batch.setParameter(i, param, value);
+    }
+}
+
+void MultichannelCompressor::setParameter(CompressorEngine::Parameter param, float value, int sampleOffset) {
+    // an engine that isn't running wouldn't get to the offset
+    if (!usingEngine) {
+        setParameter(param, value);
+        return;
+    }
+    engine.setParameter(param, value, sampleOffset);
+    if (CompressorBatch::isBatchParameter(param)) {
+        for (int i = 0; i < batch.getNumInstances(); i++)
+            batch.setParameter(i, param, value);
+    }
+}
+
+float MultichannelCompressor::getRmsEnvelopeDb() const {
+    if (usingEngine)
+        return engine.getRmsEnvelopeDb();
+    float level = -200;
+    for (int i = 0; i < batch.getNumInstances(); i++)
+        level = std::max(level, batch.getRmsEnvelopeDb(i));
+    return level;
+}
+
+float MultichannelCompressor::getGainOutLinear() const {
+    if (usingEngine)
+        return engine.getGainOutLinear();
+    float gain = 1;
+    for (int i = 0; i < batch.getNumInstances(); i++)
+        gain = std::min(gain, batch.getGainOutLinear(i));
+    return gain;
+}
+
+void MultichannelCompressor::process(float* const* channels, int numSamples) {
+    processSamples<float>(nullptr, 0, channels, numSamples);
+}
+
+void MultichannelCompressor::process(double* const* channels, int numSamples) {
+    processSamples<double>(nullptr, 0, channels, numSamples);
+}
+
+void MultichannelCompressor::process(const float* const* keyChannels, int numKeyChannels,
+                                     float* const* channels, int numSamples) {
+    processSamples(keyChannels, numKeyChannels, channels, numSamples);
+}
+
+void MultichannelCompressor::process(const double* const* keyChannels, int numKeyChannels,
+                                     double* const* channels, int numSamples) {
+    processSamples(keyChannels, numKeyChannels, channels, numSamples);
+}
+
+template <typename Sample>
+void MultichannelCompressor::processSamples(const Sample* const* keyChannels, int numKeyChannels,
+                                            Sample* const* channels, int numSamples) {
+    if (numChannels == 0)
+        return;
+    if (std::lround(engine.getParameter(CompressorEngine::channelLink)) != activeLink)
+        applyLink();
+    if (statsEnabled)
+        stats = CompressorEngine::BlockStats();
+
+    if (usingEngine && numChannels == 2) {
+        engine.setStatsEnabled(statsEnabled);
+        if (numKeyChannels > 0)
+            engine.process(keyChannels[0], keyChannels[numKeyChannels > 1 ? 1 : 0], channels[0], channels[1], numSamples);
+        else
+            engine.process(channels[0], channels[1], numSamples);
+        if (statsEnabled)
+            stats = engine.getLastBlockStats();
+        return;
+    }
+    if (usingEngine) {
+        engine.setStatsEnabled(statsEnabled);
+        processMono(keyChannels, numKeyChannels, channels[0], spareFor(channels[0]), numSamples);
+        return;
+    }
+
+    if (statsEnabled) {
+        float peak = 0;
+        float sumSquares = 0;
+        for (int ch = 0; ch < numChannels; ch++) {
+            for (int i = 0; i < numSamples; i++) {
+                const float x = (float) channels[ch][i];
+                peak = std::max(peak, std::abs(x));
+                sumSquares += x*x;
+            }
+        }
+        stats.inputPeak = peak;
+        stats.inputRms = numSamples > 0 ? std::sqrt(sumSquares/(numChannels*numSamples)) : 0;
+    }
+    if (batchInOrder) {
+        batch.process(keyChannels, numKeyChannels, channels, numSamples);
+    } else {
+        Sample* ordered[maxChannels];
+        for (int ch = 0; ch < numChannels; ch++)
+            ordered[ch] = channels[batchOrder[ch]];
+        batch.process(keyChannels, numKeyChannels, ordered, numSamples);
+    }
+
+    // over the block, the most reduction of any instance and the least
+    // reduction of the one that had the least headroom, as the engine's
+    // bands
+    if (statsEnabled) {
+        for (int i = 0; i < batch.getNumInstances(); i++) {
+            stats.minGainLinear = std::min(stats.minGainLinear, batch.getMinGainLinear(i));
+            stats.maxGainLinear = std::min(stats.maxGainLinear, batch.getMaxGainLinear(i));
+        }
+    }
+}
+
+template <typename Sample>
+void MultichannelCompressor::processMono(const Sample* const* keyChannels, int numKeyChannels,
+                                         Sample* mono, std::vector<Sample>& spare, int numSamples) {
+    // the engine's stereo path with a copy as the right channel, and the
+    // audio (or the key) as a mono key, which it only reads once
+    float sumSquares = 0;
+    for (int done = 0; done < numSamples;) {
+        const int n = std::min(numSamples - done, (int) spare.size());
+        Sample* left = mono + done;
+        Sample* right = spare.data();
+        std::copy(left, left + n, right);
+        const Sample* keyLeft = numKeyChannels > 0 ? keyChannels[0] + done : left;
+        const Sample* keyRight = numKeyChannels > 1 ? keyChannels[1] + done : keyLeft;
+        engine.process(keyLeft, keyRight, left, right, n);
+
+        if (statsEnabled) {
+            const CompressorEngine::BlockStats& part = engine.getLastBlockStats();
+            stats.inputPeak = std::max(stats.inputPeak, part.inputPeak);
+            sumSquares += part.inputRms*part.inputRms*n;
+            stats.minGainLinear = done == 0 ? part.minGainLinear : std::min(stats.minGainLinear, part.minGainLinear);
+            stats.maxGainLinear = done == 0 ? part.maxGainLinear : std::max(stats.maxGainLinear, part.maxGainLinear);
+        }
+        done += n;
+    }
+    if (statsEnabled && numSamples > 0)
+        stats.inputRms = std::sqrt(sumSquares/numSamples);
+}
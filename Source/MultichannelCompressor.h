@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    MultichannelCompressor.h
+    Created: 17 Oct 2026 1:36:08pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "CompressorBatch.h"
+#include "CompressorEngine.h"
+
+#include <vector>
+
+//==============================================================================
+/**
+ The compressor for any channel count, from mono up to a 64 channel bed
+ (5.1, 7.1.4, 3rd order ambisonics, ...), with the detector linking
+ picked by CompressorEngine::channelLink:
+    linked      one detector hears the mean square of all the channels,
+                and one gain goes to all of them
+    in pairs    each left/right pair of the layout shares one (L/R,
+                Ls/Rs, ... of a 5.1 bed), the other channels (C, LFE,
+                ambisonic components) have one each
+    per channel every channel on its own
+
+ Mono, and stereo linked, run on a CompressorEngine with everything it
+ has (lookahead, true peak, multiband, key filter, the sidechain). Any
+ other layout runs on a CompressorBatch, the detector groups side by
+ side in its vector lanes, so the channel loop is vectorised across the
+ channels instead of needing an engine per pair: single band only, no
+ latency, and a sidechain key is heard by every group. Double precision
+ audio stays double on both, the detectors hearing a float copy.
+
+ Only prepare() allocates, including for a linking change, which is
+ picked up by the next process() call (the detectors then start from
+ rest). Like CompressorEngine, set parameters and process from the same
+ thread.
+*/
+class MultichannelCompressor
+{
+public:
+    static constexpr int maxChannels = 64;
+
+    enum Link { linked, inPairs, perChannel };
+
+    MultichannelCompressor() = default;
+
+    // numChannels 1..maxChannels. pairedWith gives each channel's partner
+    // for in pairs (-1 for none), e.g. from the channel types of the bus
+    // layout; without it channels 1+2, 3+4, ... pair up in order
+    void prepare(double sampleRate, int maxBlockSize, int numChannels, const int* pairedWith = nullptr);
+    void reset();
+
+    int getNumChannels() const { return numChannels; }
+
+    // as CompressorEngine::setParameter. A change at a sample offset lands
+    // there on the engine, and at the start of the next block on a batch
+    void setParameter(CompressorEngine::Parameter param, float value);
+    void setParameter(CompressorEngine::Parameter param, float value, int sampleOffset);
+    float getParameter(CompressorEngine::Parameter param) const { return engine.getParameter(param); }
+
+    // processes the prepared number of channels in place
+    void process(float* const* channels, int numSamples);
+    void process(double* const* channels, int numSamples);
+
+    // same, but the detectors listen to numKeyChannels (1 or 2) key
+    // channels instead
+    void process(const float* const* keyChannels, int numKeyChannels, float* const* channels, int numSamples);
+    void process(const double* const* keyChannels, int numKeyChannels, double* const* channels, int numSamples);
+
+    // true while the channels go through the engine, false on the batch
+    bool isUsingEngine() const { return usingEngine; }
+
+    // whether numChannels with that link would go through the engine
+    static bool runsOnEngine(int numChannels, int link) {
+        return numChannels <= 1 || (numChannels == 2 && link == linked);
+    }
+
+    // the engine, for what only it has (ramp shape, fast paths)
+    CompressorEngine& getEngine() { return engine; }
+
+    int getLatencySamples() const { return usingEngine ? engine.getLatencySamples() : 0; }
+
+    // over all detectors: the loudest level and the most gain reduction
+    float getRmsEnvelopeDb() const;
+    float getGainOutLinear() const;
+
+    // as the engine's, over all channels
+    void setStatsEnabled(bool enabled) { statsEnabled = enabled; }
+    const CompressorEngine::BlockStats& getLastBlockStats() const { return stats; }
+
+private:
+    CompressorEngine engine;
+    CompressorBatch batch;
+
+    float fs = 44100;
+    int numChannels = 0;
+    int activeLink = -1;    // the batch's grouping, -1 until the first block
+    bool usingEngine = true;
+    void applyLink();
+
+    // in pairs partners, and the channels in the order the batch takes
+    // them, a pair side by side
+    int pairedWith[maxChannels];
+    int batchOrder[maxChannels];
+    bool batchInOrder = true;
+
+    // the mono engine's right channel, a copy of the left thrown away after
+    static constexpr int minScratch = 256;
+    std::vector<float> spareFloat;
+    std::vector<double> spareDouble;
+    std::vector<float>& spareFor(const float*) { return spareFloat; }
+    std::vector<double>& spareFor(const double*) { return spareDouble; }
+
+    bool statsEnabled = false;
+    CompressorEngine::BlockStats stats;
+
+    template <typename Sample>
+    void processSamples(const Sample* const* keyChannels, int numKeyChannels,
+                        Sample* const* channels, int numSamples);
+    template <typename Sample>
+    void processMono(const Sample* const* keyChannels, int numKeyChannels,
+                     Sample* mono, std::vector<Sample>& spare, int numSamples);
+};
@@ -31,6 +31,7 @@ ColemanJP05CompressorAudioProcessorEditor::ColemanJP05CompressorAudioProcessorEd
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     setSize (CONTAINER_WIDTH, CONTAINER_HEIGHT);
+    setOpaque(true); // the cached background covers everything
     
     // create knobs
     createKnob(thresholdSlider, 1, 1, " dB", THRESH_INTERVAL, THRESH_SKEW, threshold);
@@ -39,15 +40,78 @@ ColemanJP05CompressorAudioProcessorEditor::ColemanJP05CompressorAudioProcessorEd
     createKnob(attackSlider, 6, 11, " ms", ATTACK_INTERVAL, ATTACK_SKEW, attack);
     createKnob(releaseSlider, 11, 11, " ms", RELEASE_INTERVAL, RELEASE_SKEW, release);
     createKnob(postGainSlider, 16, 11, " dB", GAIN_INTERVAL, GAIN_SKEW, postGain);
+    createKnob(lookaheadSlider, 21, 11, " ms", LOOKAHEAD_INTERVAL, LOOKAHEAD_SKEW, lookahead);
+    
+    // detector oversampling, item id - 1 is the parameter value
+    truePeakBox.addItem("Off", 1);
+    truePeakBox.addItem("2x", 2);
+    truePeakBox.addItem("4x", 3);
+    truePeakBox.setBounds(21*UNIT_LENGTH_X, 1*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 0.8*UNIT_LENGTH_Y);
+    truePeakBox.addListener(this);
+    addAndMakeVisible(truePeakBox);
+    
+    // multiband
+    for (int band = 1; band <= 5; band++) {
+        numBandsBox.addItem(juce::String(band), band);
+        editBandBox.addItem("Band " + juce::String(band), band);
+    }
+    numBandsBox.setBounds(21*UNIT_LENGTH_X, 2.6*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 0.8*UNIT_LENGTH_Y);
+    numBandsBox.addListener(this);
+    addAndMakeVisible(numBandsBox);
+    editBandBox.setBounds(21*UNIT_LENGTH_X, 4.2*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 0.8*UNIT_LENGTH_Y);
+    editBandBox.setSelectedId(1, juce::dontSendNotification);
+    editBandBox.addListener(this);
+    addAndMakeVisible(editBandBox);
+    createKnob(crossoverSlider, 21, 6, " Hz", CROSSOVER_INTERVAL, CROSSOVER_SKEW, crossover1);
+    selectEditedBand(0);
+    
+    // key filter, item id - 1 is the parameter value
+    keyFilterBox.addItem("Off", 1);
+    keyFilterBox.addItem("High Pass", 2);
+    keyFilterBox.addItem("Low Pass", 3);
+    keyFilterBox.addItem("Band Pass", 4);
+    keyFilterBox.setBounds(26*UNIT_LENGTH_X, 1*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 0.8*UNIT_LENGTH_Y);
+    keyFilterBox.addListener(this);
+    addAndMakeVisible(keyFilterBox);
+    createKnob(keyLowCutSlider, 26, 6, " Hz", KEY_CUT_INTERVAL, KEY_CUT_SKEW, keyLowCut);
+    createKnob(keyHighCutSlider, 26, 11, " Hz", KEY_CUT_INTERVAL, KEY_CUT_SKEW, keyHighCut);
+    
+    // channel link, item id - 1 is the parameter value
+    channelLinkBox.addItem("Linked", 1);
+    channelLinkBox.addItem("Pairs", 2);
+    channelLinkBox.addItem("Per Channel", 3);
+    channelLinkBox.setBounds(31*UNIT_LENGTH_X, 1*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 0.8*UNIT_LENGTH_Y);
+    channelLinkBox.addListener(this);
+    addAndMakeVisible(channelLinkBox);
+    
+    // eco mode, item id is the parameter value
+    ecoBox.addItem("Off", 1);
+    ecoBox.addItem("4", 4);
+    ecoBox.addItem("8", 8);
+    ecoBox.addItem("16", 16);
+    ecoBox.addItem("32", 32);
+    ecoBox.setBounds(31*UNIT_LENGTH_X, 2.6*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 0.8*UNIT_LENGTH_Y);
+    ecoBox.addListener(this);
+    addAndMakeVisible(ecoBox);
+    
+    // load monitor, starts from zero every time it is switched on
+    loadButton.setBounds(26*UNIT_LENGTH_X, 2.6*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 0.8*UNIT_LENGTH_Y);
+    loadButton.setToggleState(audioProcessor.getLoadMonitor().isEnabled(), juce::dontSendNotification);
+    loadButton.onClick = [this] {
+        auto& monitor = audioProcessor.getLoadMonitor();
+        if (loadButton.getToggleState())
+            monitor.reset();
+        monitor.setEnabled(loadButton.getToggleState());
+        updateLoadLabel();
+    };
+    addAndMakeVisible(loadButton);
+    loadLabel.setBounds(26*UNIT_LENGTH_X, 3.4*UNIT_LENGTH_Y, 4*UNIT_LENGTH_X, 1.6*UNIT_LENGTH_Y);
+    loadLabel.setFont(juce::Font(12.0f));
+    loadLabel.setJustificationType(juce::Justification::topLeft);
+    addAndMakeVisible(loadLabel);
+    updateLoadLabel();
     
     no_fill.setOpacity(0);
- 
-    // create outline for input/output graph
-    graphOutline.setRectangle(graphOutlineCoords);
-    graphOutline.setFill(no_fill);
-    graphOutline.setStrokeFill(white);
-    graphOutline.setStrokeThickness(2);
-    addAndMakeVisible(graphOutline);
     
     // add response lines to view and set color
     belowThresholdLine.setFill(white);
@@ -61,7 +125,8 @@ ColemanJP05CompressorAudioProcessorEditor::ColemanJP05CompressorAudioProcessorEd
 
     // create compression beter box outline
     // outline is created after meter so meter
-    // is displayed under the outline
+    // is displayed under the outline (which is
+    // why it is not part of the cached background)
     meterOutline.setRectangle(meterOutlineCoords);
     meterOutline.setFill(no_fill);
     meterOutline.setStrokeFill(white);
@@ -76,6 +141,7 @@ ColemanJP05CompressorAudioProcessorEditor::ColemanJP05CompressorAudioProcessorEd
     addAndMakeVisible(audioSampleCircle);
     
     // start GUI refreshing
+    audioProcessor.setTelemetryEnabled(true);
     startTimerHz(timerFreq);
     
     // determine coefficient for audio sample circle smoother
@@ -84,6 +150,7 @@ ColemanJP05CompressorAudioProcessorEditor::ColemanJP05CompressorAudioProcessorEd
 
 ColemanJP05CompressorAudioProcessorEditor::~ColemanJP05CompressorAudioProcessorEditor()
 {
+    audioProcessor.setTelemetryEnabled(false);
 }
 
 void ColemanJP05CompressorAudioProcessorEditor::sliderValueChanged(juce::Slider *slider) {
@@ -99,6 +166,45 @@ void ColemanJP05CompressorAudioProcessorEditor::sliderValueChanged(juce::Slider
     }
 }
 
+void ColemanJP05CompressorAudioProcessorEditor::comboBoxChanged(juce::ComboBox* comboBox) {
+    auto& params = processor.getParameters();
+    
+    if (comboBox == &truePeakBox) {
+        juce::AudioParameterFloat* audioParam = (juce::AudioParameterFloat*)params.getUnchecked(truePeak);
+        *audioParam = truePeakBox.getSelectedId() - 1;
+    } else if (comboBox == &numBandsBox) {
+        juce::AudioParameterFloat* audioParam = (juce::AudioParameterFloat*)params.getUnchecked(numBands);
+        *audioParam = numBandsBox.getSelectedId();
+    } else if (comboBox == &keyFilterBox) {
+        juce::AudioParameterFloat* audioParam = (juce::AudioParameterFloat*)params.getUnchecked(keyFilter);
+        *audioParam = keyFilterBox.getSelectedId() - 1;
+    } else if (comboBox == &channelLinkBox) {
+        juce::AudioParameterFloat* audioParam = (juce::AudioParameterFloat*)params.getUnchecked(channelLink);
+        *audioParam = channelLinkBox.getSelectedId() - 1;
+    } else if (comboBox == &ecoBox) {
+        juce::AudioParameterFloat* audioParam = (juce::AudioParameterFloat*)params.getUnchecked(ecoInterval);
+        *audioParam = ecoBox.getSelectedId();
+    } else if (comboBox == &editBandBox) {
+        selectEditedBand(editBandBox.getSelectedId() - 1);
+    }
+}
+
+void ColemanJP05CompressorAudioProcessorEditor::selectEditedBand(int band) {
+    // point the dynamics knobs at the band's parameters, band 1 uses the
+    // original ones and has no lower crossover
+    const parameterMap bandOne[] = {threshold, ratio, attack, release};
+    juce::Slider* const bandSliders[] = {&thresholdSlider, &ratioSlider, &attackSlider, &releaseSlider};
+    for (auto& slider_param : sliderParamMap) {
+        for (int i = 0; i < 4; i++) {
+            if (slider_param.slider == bandSliders[i])
+                slider_param.param = band == 0 ? bandOne[i] : (parameterMap) (band2Threshold + 4*(band - 1) + i);
+        }
+        if (slider_param.slider == &crossoverSlider)
+            slider_param.param = (parameterMap) (crossover1 + std::max(band - 1, 0));
+    }
+    crossoverSlider.setEnabled(band > 0);
+}
+
 void ColemanJP05CompressorAudioProcessorEditor::timerCallback() {
     auto& params = processor.getParameters();
 
@@ -108,6 +214,35 @@ void ColemanJP05CompressorAudioProcessorEditor::timerCallback() {
         slider_param.slider->setValue(param->get(), juce::dontSendNotification);
     }
     
+    juce::AudioParameterFloat* truePeakParam = (juce::AudioParameterFloat*)params.getUnchecked(truePeak);
+    truePeakBox.setSelectedId((int) std::lround(truePeakParam->get()) + 1, juce::dontSendNotification);
+    juce::AudioParameterFloat* numBandsParam = (juce::AudioParameterFloat*)params.getUnchecked(numBands);
+    const int bands = (int) std::lround(numBandsParam->get());
+    numBandsBox.setSelectedId(bands, juce::dontSendNotification);
+    juce::AudioParameterFloat* keyFilterParam = (juce::AudioParameterFloat*)params.getUnchecked(keyFilter);
+    const int keyFilterType = (int) std::lround(keyFilterParam->get());
+    keyFilterBox.setSelectedId(keyFilterType + 1, juce::dontSendNotification);
+    juce::AudioParameterFloat* channelLinkParam = (juce::AudioParameterFloat*)params.getUnchecked(channelLink);
+    channelLinkBox.setSelectedId((int) std::lround(channelLinkParam->get()) + 1, juce::dontSendNotification);
+    juce::AudioParameterFloat* ecoParam = (juce::AudioParameterFloat*)params.getUnchecked(ecoInterval);
+    ecoBox.setSelectedId((int) std::lround(ecoParam->get()), juce::dontSendNotification);
+
+    // the batch (surround, or stereo not linked) is a single band with
+    // none of the engine's extras, so their controls would do nothing
+    const bool onEngine = audioProcessor.isUsingEngine();
+    if (!onEngine && editBandBox.getSelectedId() != 1) {
+        editBandBox.setSelectedId(1, juce::dontSendNotification);
+        selectEditedBand(0);
+    }
+    lookaheadSlider.setEnabled(onEngine);
+    truePeakBox.setEnabled(onEngine);
+    numBandsBox.setEnabled(onEngine);
+    editBandBox.setEnabled(onEngine);
+    keyFilterBox.setEnabled(onEngine);
+    keyLowCutSlider.setEnabled(onEngine && (keyFilterType == 1 || keyFilterType == 3));
+    keyHighCutSlider.setEnabled(onEngine && (keyFilterType == 2 || keyFilterType == 3));
+    ecoBox.setEnabled(onEngine && bands == 1); // the multiband detectors are per sample
+    
     updateGUI();
 }
 
@@ -219,11 +354,34 @@ void ColemanJP05CompressorAudioProcessorEditor::updateGUI() {
     float thresholdValue = ((juce::AudioParameterFloat*)params.getUnchecked(threshold))->get();
     float ratioValue = ((juce::AudioParameterFloat*)params.getUnchecked(ratio))->get();
     
-    // update the input/output graph
-    updateGraph(postGainValue, thresholdValue, ratioValue);
+    // update the input/output graph, only when its parameters changed
+    if (!graphDrawn || postGainValue != graphPostGain || thresholdValue != graphThreshold
+        || ratioValue != graphRatio) {
+        updateGraph(postGainValue, thresholdValue, ratioValue);
+        graphPostGain = postGainValue;
+        graphThreshold = thresholdValue;
+        graphRatio = ratioValue;
+        graphDrawn = true;
+    }
+    
+    // a few times a second is plenty for text
+    if (--loadLabelCountdown <= 0) {
+        updateLoadLabel();
+        loadLabelCountdown = (int) (timerFreq/4);
+    }
+    
+    // drain the blocks processed since the last tick, the meter
+    // shows the most gain reduction among them
+    ColemanJP05CompressorAudioProcessor::BlockTelemetry telemetry;
+    bool first = true;
+    while (audioProcessor.popTelemetry(telemetry)) {
+        rmsEnvelopeDb = telemetry.rmsEnvelopeDb;
+        gainOutLinear = first ? telemetry.minGainLinear : std::min(gainOutLinear, telemetry.minGainLinear);
+        first = false;
+    }
     
     // plot audio sample on input/output graph
-    sample_x += graphSampleB0*(audioProcessor.rmsEnvelopeDb - sample_x);
+    sample_x += graphSampleB0*(rmsEnvelopeDb - sample_x);
     float sample_y;
     if (sample_x < thresholdValue)
         sample_y = sample_x + postGainValue;
@@ -234,24 +392,65 @@ void ColemanJP05CompressorAudioProcessorEditor::updateGUI() {
         audioSampleCircle.setVisible(false);
     } else {
         point sample_center = getGUICoords(sample_x, sample_y);
-        juce::Path samplePath;
-        float radius = 0.15*UNIT_LENGTH_X;
-        samplePath.addEllipse(sample_center.x - radius, sample_center.y - radius, radius*2, radius*2);
-        audioSampleCircle.setPath(samplePath);
+        // moving the circle repaints its old and new area, skip sub-pixel moves
+        if (!audioSampleCircle.isVisible() || std::abs(sample_center.x - drawnSampleX) >= 0.25
+            || std::abs(sample_center.y - drawnSampleY) >= 0.25) {
+            juce::Path samplePath;
+            float radius = 0.15*UNIT_LENGTH_X;
+            samplePath.addEllipse(sample_center.x - radius, sample_center.y - radius, radius*2, radius*2);
+            audioSampleCircle.setPath(samplePath);
+            drawnSampleX = sample_center.x;
+            drawnSampleY = sample_center.y;
+        }
         audioSampleCircle.setVisible(true);
     }
         
-    // compression meter
-    float compLevelDB = 20*log10(audioProcessor.gainOutLinear);
+    // compression meter, only resized when it changes by at least half a pixel
+    float compLevelDB = 20*log10(gainOutLinear);
     if (compLevelDB < -40) compLevelDB = -40;
     if (compLevelDB > 0) compLevelDB = 0;
-    float rectHeight = -compLevelDB/40*8;
-    meterValue.setRectangle(juce::Rectangle<float>(17*UNIT_LENGTH_X, 1*UNIT_LENGTH_Y, 1*UNIT_LENGTH_X, rectHeight*UNIT_LENGTH_Y));
+    float rectHeight = -compLevelDB/40*8*UNIT_LENGTH_Y;
+    if (std::abs(rectHeight - drawnMeterHeight) >= 0.5) {
+        meterValue.setRectangle(juce::Rectangle<float>(17*UNIT_LENGTH_X, 1*UNIT_LENGTH_Y, 1*UNIT_LENGTH_X, rectHeight));
+        drawnMeterHeight = rectHeight;
+    }
+}
+
+void ColemanJP05CompressorAudioProcessorEditor::updateLoadLabel() {
+    auto& monitor = audioProcessor.getLoadMonitor();
+    if (!monitor.isEnabled()) {
+        loadLabel.setText("", juce::dontSendNotification);
+        return;
+    }
+    // share of the block's real-time budget, and blocks that went over it
+    const LoadMonitor::Stats stats = monitor.getStats();
+    loadLabel.setText(juce::String::formatted("avg %.1f%%  p99 %.1f%%\nmax %.1f%%  late %llu/%llu",
+                                              100*stats.meanLoad, 100*stats.getLoadPercentile(0.99),
+                                              100*stats.peakLoad, (unsigned long long) stats.overruns,
+                                              (unsigned long long) stats.blocks),
+                      juce::dontSendNotification);
 }
 
 //==============================================================================
 void ColemanJP05CompressorAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    // the graphs, meter and circle are child components, so everything
+    // drawn here is static and comes from the cached image
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (background.isNull() || scale != backgroundScale)
+        renderBackground(scale);
+    
+    g.drawImage(background, getLocalBounds().toFloat());
+}
+
+void ColemanJP05CompressorAudioProcessorEditor::renderBackground(float scale) {
+    background = juce::Image(juce::Image::RGB, juce::roundToInt(getWidth()*scale),
+                             juce::roundToInt(getHeight()*scale), false);
+    backgroundScale = scale;
+    
+    juce::Graphics g(background);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    
     // background color
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
@@ -294,8 +493,8 @@ void ColemanJP05CompressorAudioProcessorEditor::paint (juce::Graphics& g)
     // Label Knobs
     struct namesToPlaces {
         std::string name;
-        int x;
-        int y;
+        float x;
+        float y;
     };
     
     std::vector<namesToPlaces> mapping {
@@ -304,7 +503,17 @@ void ColemanJP05CompressorAudioProcessorEditor::paint (juce::Graphics& g)
         {"Pre Gain", 1, 11},
         {"Attack", 6, 11},
         {"Release", 11, 11},
-        {"Post Gain", 16, 11}
+        {"Post Gain", 16, 11},
+        {"Lookahead", 21, 11},
+        {"True Peak", 21, 1},
+        {"Bands", 21, 2.6},
+        {"Edit Band", 21, 4.2},
+        {"Crossover", 21, 6},
+        {"Key Filter", 26, 1},
+        {"Key Low Cut", 26, 6},
+        {"Key High Cut", 26, 11},
+        {"Channel Link", 31, 1},
+        {"Eco", 31, 2.6}
     };
     
     g.setColour(juce::Colours::white);
@@ -313,10 +522,14 @@ void ColemanJP05CompressorAudioProcessorEditor::paint (juce::Graphics& g)
         g.drawText(knob.name, knob.x*UNIT_LENGTH_X, (knob.y - 0.8)*UNIT_LENGTH_Y,
                    4*UNIT_LENGTH_X, 1*UNIT_LENGTH_Y, juce::Justification::centred);
     }
+    
+    // outline for input/output graph, 2px stroke centred on the edge
+    g.drawRect(graphOutlineCoords.expanded(1), 2);
 }
 
 void ColemanJP05CompressorAudioProcessorEditor::resized()
 {
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
+    background = juce::Image(); // redrawn at the new size
 }
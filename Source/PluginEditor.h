@@ -15,7 +15,7 @@
 /**
 */
 class ColemanJP05CompressorAudioProcessorEditor  : public juce::AudioProcessorEditor,
-public juce::Slider::Listener, public juce::Timer
+public juce::Slider::Listener, public juce::ComboBox::Listener, public juce::Timer
 {
 public:
     ColemanJP05CompressorAudioProcessorEditor (ColemanJP05CompressorAudioProcessor&);
@@ -26,6 +26,7 @@ public:
     void resized() override;
 
     void sliderValueChanged(juce::Slider* slider) override;
+    void comboBoxChanged(juce::ComboBox* comboBox) override;
     void timerCallback() override;
 
 private:
@@ -43,6 +44,32 @@ private:
     
     juce::Slider preGainSlider;
     juce::Slider postGainSlider;
+    juce::Slider lookaheadSlider;
+    
+    juce::ComboBox truePeakBox; // off, 2x, 4x
+    
+    // multiband: band count, and the band the threshold, ratio, attack,
+    // release and crossover knobs edit
+    juce::ComboBox numBandsBox;
+    juce::ComboBox editBandBox;
+    juce::Slider crossoverSlider; // lower edge of the edited band
+    
+    // detector (key) filter
+    juce::ComboBox keyFilterBox; // off, high pass, low pass, band pass
+    juce::Slider keyLowCutSlider;
+    juce::Slider keyHighCutSlider;
+    
+    // detector linking across channels: linked, in pairs, per channel
+    juce::ComboBox channelLinkBox;
+    
+    // eco mode: off or samples per gain computer update
+    juce::ComboBox ecoBox;
+
+    // processBlock's CPU load, measured while the button is on
+    juce::ToggleButton loadButton { "CPU Load" };
+    juce::Label loadLabel;
+    int loadLabelCountdown = 0; // timer ticks until the next update
+    void updateLoadLabel();
 
     // mappings
     enum parameterMap {
@@ -51,7 +78,20 @@ private:
         attack,
         release,
         preGain,
-        postGain
+        postGain,
+        lookahead,
+        truePeak,
+        numBands,
+        crossover1, crossover2, crossover3, crossover4,
+        band2Threshold, band2Ratio, band2Attack, band2Release,
+        band3Threshold, band3Ratio, band3Attack, band3Release,
+        band4Threshold, band4Ratio, band4Attack, band4Release,
+        band5Threshold, band5Ratio, band5Attack, band5Release,
+        keyFilter,
+        keyLowCut,
+        keyHighCut,
+        channelLink,
+        ecoInterval
     };
     struct SliderToParam {
         juce::Slider* slider;
@@ -63,12 +103,15 @@ private:
         {&attackSlider, attack},
         {&releaseSlider, release},
         {&preGainSlider, preGain},
-        {&postGainSlider, postGain}
+        {&postGainSlider, postGain},
+        {&lookaheadSlider, lookahead},
+        {&crossoverSlider, crossover1},
+        {&keyLowCutSlider, keyLowCut},
+        {&keyHighCutSlider, keyHighCut}
     };
     
     // GUI Response elements
     juce::DrawableRectangle meterOutline;
-    juce::DrawableRectangle graphOutline;
     juce::DrawableRectangle meterValue;
     juce::DrawablePath belowThresholdLine;
     juce::DrawablePath aboveThresholdLine;
@@ -90,6 +133,8 @@ private:
     
     void updateGUI();
     void updateGraph(float,float,float);
+    void renderBackground(float scale);
+    void selectEditedBand(int band);
     void createKnob(juce::Slider& slider, float x, float y, std::string suffix,
                     float interval, float skew, parameterMap paramNum);
     
@@ -98,4 +143,21 @@ private:
     float graphSampleTau = 35.0/1000.0; // sec
     float timerFreq = 120; // Hz
     float sample_x = -40; // dB
+    
+    // latest values drained from the processor's telemetry queue
+    float rmsEnvelopeDb = -200;
+    float gainOutLinear = 1;
+    
+    // grid, labels and graph outline, drawn once per size/display scale
+    juce::Image background;
+    float backgroundScale = 0;
+    
+    // what is currently on screen, so unchanged elements are not touched
+    bool graphDrawn = false;
+    float graphPostGain = 0;
+    float graphThreshold = 0;
+    float graphRatio = 0;
+    float drawnSampleX = 0;
+    float drawnSampleY = 0;
+    float drawnMeterHeight = -1;
 };
@@ -16,6 +16,7 @@ ColemanJP05CompressorAudioProcessor::ColemanJP05CompressorAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -53,7 +54,84 @@ ColemanJP05CompressorAudioProcessor::ColemanJP05CompressorAudioProcessor()
                                                                GAIN_MIN,
                                                                GAIN_MAX,
                                                                GAIN_DEFAULT));
+    addParameter(lookaheadParam = new juce::AudioParameterFloat("lookahead",
+                                                                "Lookahead (ms)",
+                                                                LOOKAHEAD_MIN,
+                                                                LOOKAHEAD_MAX,
+                                                                LOOKAHEAD_DEFAULT));
+    addParameter(truePeakParam = new juce::AudioParameterFloat("truePeak",
+                                                               "True Peak Oversampling",
+                                                               TRUE_PEAK_MIN,
+                                                               TRUE_PEAK_MAX,
+                                                               TRUE_PEAK_DEFAULT));
+    
+    // multiband, band 1 uses the parameters above
+    addParameter(new juce::AudioParameterFloat("numBands",
+                                               "Bands",
+                                               BANDS_MIN,
+                                               BANDS_MAX,
+                                               BANDS_DEFAULT));
+    const float crossoverDefaults[] = { CROSSOVER1_DEFAULT, CROSSOVER2_DEFAULT,
+                                        CROSSOVER3_DEFAULT, CROSSOVER4_DEFAULT };
+    for (int k = 0; k < 4; k++)
+        addParameter(new juce::AudioParameterFloat("crossover" + juce::String(k + 1),
+                                                   "Crossover " + juce::String(k + 1) + " (Hz)",
+                                                   CROSSOVER_MIN,
+                                                   CROSSOVER_MAX,
+                                                   crossoverDefaults[k]));
+    for (int band = 2; band <= 5; band++) {
+        const juce::String id = "band" + juce::String(band);
+        const juce::String name = "Band " + juce::String(band) + " ";
+        addParameter(new juce::AudioParameterFloat(id + "Threshold", name + "Threshold (dB)",
+                                                   THRESH_MIN, THRESH_MAX, THRESH_DEFAULT));
+        addParameter(new juce::AudioParameterFloat(id + "Ratio", name + "Ratio",
+                                                   RATIO_MIN, RATIO_MAX, RATIO_DEFAULT));
+        addParameter(new juce::AudioParameterFloat(id + "Attack", name + "Attack (ms)",
+                                                   ATTACK_MIN, ATTACK_MAX, ATTACK_DEFAULT));
+        addParameter(new juce::AudioParameterFloat(id + "Release", name + "Release (ms)",
+                                                   RELEASE_MIN, RELEASE_MAX, RELEASE_DEFAULT));
+    }
+    
+    // detector (key) filter
+    addParameter(new juce::AudioParameterFloat("keyFilter",
+                                               "Key Filter",
+                                               KEY_FILTER_MIN,
+                                               KEY_FILTER_MAX,
+                                               KEY_FILTER_DEFAULT));
+    addParameter(new juce::AudioParameterFloat("keyLowCut",
+                                               "Key Low Cut (Hz)",
+                                               KEY_CUT_MIN,
+                                               KEY_CUT_MAX,
+                                               KEY_LOW_CUT_DEFAULT));
+    addParameter(new juce::AudioParameterFloat("keyHighCut",
+                                               "Key High Cut (Hz)",
+                                               KEY_CUT_MIN,
+                                               KEY_CUT_MAX,
+                                               KEY_HIGH_CUT_DEFAULT));
+    
+    // detector linking across the channels of a surround or ambisonic bed
+    addParameter(new juce::AudioParameterFloat("channelLink",
+                                               "Channel Link",
+                                               LINK_MIN,
+                                               LINK_MAX,
+                                               LINK_DEFAULT));
+    
+    // eco mode, samples per gain computer update
+    addParameter(new juce::AudioParameterFloat("ecoInterval",
+                                               "Eco (samples)",
+                                               ECO_MIN,
+                                               ECO_MAX,
+                                               ECO_DEFAULT));
+    jassert(getParameters().size() == CompressorEngine::numParameters);
+    for (int i = 0; i < CompressorEngine::numParameters; i++)
+        jassert(((juce::AudioProcessorParameterWithID*) getParameters()[i])->paramID
+                == CompressorEngine::getParameterId((CompressorEngine::Parameter) i));
+
+    // only push parameters to the engine after something changed
+    for (auto* param : getParameters())
+        param->addListener(this);
 
+    loadPresetBank();
 }
 
 ColemanJP05CompressorAudioProcessor::~ColemanJP05CompressorAudioProcessor()
@@ -95,26 +173,39 @@ bool ColemanJP05CompressorAudioProcessor::isMidiEffect() const
 
 double ColemanJP05CompressorAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // input still in the delay line (lookahead and detector
+    // oversampling) when the input stops
+    if (getSampleRate() > 0)
+        return getLatencySamples()/getSampleRate();
+    return lookaheadParam->get()/1000.0;
 }
 
 int ColemanJP05CompressorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // so this should be at least 1, even if you're not really implementing programs.
+    return juce::jmax(1, presetBank.getNumPresets());
 }
 
 int ColemanJP05CompressorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void ColemanJP05CompressorAudioProcessor::setCurrentProgram (int index)
 {
+    if (index < 0 || index >= presetBank.getNumPresets())
+        return;
+    float values[CompressorEngine::numParameters];
+    presetBank.getValues(index, values);
+    setParameterValues(values);
+    currentProgram = index;
 }
 
 const juce::String ColemanJP05CompressorAudioProcessor::getProgramName (int index)
 {
+    if (index >= 0 && index < presetBank.getNumPresets())
+        return presetBank.getName(index);
     return {};
 }
 
@@ -123,13 +214,48 @@ void ColemanJP05CompressorAudioProcessor::changeProgramName (int index, const ju
 }
 
 //==============================================================================
+namespace
+{
+    // Channel Link's Pairs: each channel's partner in the bus layout
+    // (L/R, Ls/Rs, ...), -1 for the ones without (C, LFE, ambisonics, ...)
+    void getChannelPairs (const juce::AudioChannelSet& layout, int* pairedWith)
+    {
+        using Set = juce::AudioChannelSet;
+        static const Set::ChannelType pairs[][2] = {
+            { Set::left, Set::right },
+            { Set::leftCentre, Set::rightCentre },
+            { Set::leftSurround, Set::rightSurround },
+            { Set::leftSurroundSide, Set::rightSurroundSide },
+            { Set::leftSurroundRear, Set::rightSurroundRear },
+            { Set::wideLeft, Set::wideRight },
+            { Set::topFrontLeft, Set::topFrontRight },
+            { Set::topRearLeft, Set::topRearRight }
+        };
+        const int numChannels = std::min(layout.size(), MultichannelCompressor::maxChannels);
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            const Set::ChannelType type = layout.getTypeOfChannel(ch);
+            pairedWith[ch] = -1;
+            for (const auto& pair : pairs)
+            {
+                if (type == pair[0] || type == pair[1])
+                    pairedWith[ch] = layout.getChannelIndexForType(type == pair[0] ? pair[1] : pair[0]);
+            }
+        }
+    }
+}
+
 void ColemanJP05CompressorAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    fs = sampleRate;
-    
-    envB0 = 1 - exp(-1/(envTau*fs));
+    updateEngineParameters();
+    int pairedWith[MultichannelCompressor::maxChannels];
+    getChannelPairs(getChannelLayoutOfBus(true, 0), pairedWith);
+    compressor.prepare(sampleRate, samplesPerBlock, getMainBusNumInputChannels(), pairedWith);
+    engineLatency = compressor.getLatencySamples();
+    setLatencySamples(engineLatency);
+    samplePosition = 0;
 }
 
 void ColemanJP05CompressorAudioProcessor::releaseResources()
@@ -145,19 +271,25 @@ bool ColemanJP05CompressorAudioProcessor::isBusesLayoutSupported (const BusesLay
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (
-        //layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono() &&
-     layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // any layout from mono up to MultichannelCompressor::maxChannels:
+    // stereo, 5.1, 7.1.4, ambisonic beds, ...
+    const int numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels < 1 || numChannels > MultichannelCompressor::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // the sidechain can be off, mono or stereo
+    if (layouts.inputBuses.size() > 1) {
+        const auto& sidechain = layouts.getChannelSet(true, 1);
+        if (!sidechain.isDisabled()
+            && sidechain != juce::AudioChannelSet::mono()
+            && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -165,22 +297,58 @@ bool ColemanJP05CompressorAudioProcessor::isBusesLayoutSupported (const BusesLay
 }
 #endif
 
-void ColemanJP05CompressorAudioProcessor::calcAlgorithmParams() {
-    
-    envB0 = 1 - exp(-1/(envTau*fs));
-    
-    attackCoeff = 1.0 - exp(-1.0/(attackParam->get()*fs/1000.0));
-    releaseCoeff = 1.0 - exp(-1.0/(releaseParam->get()*fs/1000.0));
-    
-    thresholdDb = thresholdParam->get();
-    ratio = ratioParam->get();
-    
-    preGainLinear = pow(10,preGainParam->get()/20.0);
-    postGainLinear = pow(10,postGainParam->get()/20.0);
+void ColemanJP05CompressorAudioProcessor::updateEngineParameters() {
+    // the parameters were added in CompressorEngine::Parameter order
+    auto& params = getParameters();
+    for (int i = 0; i < CompressorEngine::numParameters; i++) {
+        juce::AudioParameterFloat* param = (juce::AudioParameterFloat*) params.getUnchecked(i);
+        compressor.setParameter((CompressorEngine::Parameter) i, param->get());
+    }
+}
+
+bool ColemanJP05CompressorAudioProcessor::isUsingEngine() const {
+    auto* linkParam = (juce::AudioParameterFloat*) getParameters().getUnchecked(CompressorEngine::channelLink);
+    return MultichannelCompressor::runsOnEngine(getMainBusNumInputChannels(), (int) std::lround(linkParam->get()));
+}
+
+void ColemanJP05CompressorAudioProcessor::getParameterValues (float* values) const {
+    auto& params = getParameters();
+    for (int i = 0; i < CompressorEngine::numParameters; i++)
+        values[i] = ((juce::AudioParameterFloat*) params.getUnchecked(i))->get();
+}
+
+void ColemanJP05CompressorAudioProcessor::setParameterValues (const float* values) {
+    auto& params = getParameters();
+    for (int i = 0; i < CompressorEngine::numParameters; i++)
+        *((juce::AudioParameterFloat*) params.getUnchecked(i)) = values[i];
+}
+
+void ColemanJP05CompressorAudioProcessor::parameterValueChanged (int parameterIndex, float newValue) {
+    // can be called from any thread
+    parametersChanged = true;
+}
+
+void ColemanJP05CompressorAudioProcessor::parameterGestureChanged (int parameterIndex, bool gestureIsStarting) {
+}
+
+void ColemanJP05CompressorAudioProcessor::handleAsyncUpdate() {
+    setLatencySamples(engineLatency);
 }
 
 void ColemanJP05CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    processSamples (buffer);
+}
+
+void ColemanJP05CompressorAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer);
+}
+
+template <typename Sample>
+void ColemanJP05CompressorAudioProcessor::processSamples (juce::AudioBuffer<Sample>& buffer)
+{
+    loadMonitor.begin();
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -194,51 +362,38 @@ void ColemanJP05CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    calcAlgorithmParams();
+    if (parametersChanged.exchange(false))
+        updateEngineParameters();
 
-    auto* channelDataLeft = buffer.getWritePointer(0);
-    auto* channelDataRight = buffer.getWritePointer(1);
+    const int numSamples = buffer.getNumSamples();
+    const bool publish = telemetryEnabled.load(std::memory_order_relaxed);
+    compressor.setStatsEnabled(publish);
+    // the main bus comes first in the buffer, and the detector listens to
+    // the sidechain bus when the host feeds it, reading it straight out of
+    // the host's buffer
+    Sample* const* channels = buffer.getArrayOfWritePointers();
+    auto sidechain = getBusBuffer(buffer, true, 1);
+    if (sidechain.getNumChannels() > 0)
+        compressor.process(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), channels, numSamples);
+    else
+        compressor.process(channels, numSamples);
     
-    float leftSquared, rightSquared, rmsEnvelopeLin,
-        preDynamicsGainDb, preDynamicsGainLinear, gainCoeff,
-        leftIn, rightIn, finalGainLinear;
-        
-    for (int samp = 0; samp < buffer.getNumSamples(); samp++) {
-        // pre gain
-        leftIn = channelDataLeft[samp]*preGainLinear;
-        rightIn = channelDataRight[samp]*preGainLinear;
-        
-        // RMS level detector
-        leftSquared = leftIn*leftIn;
-        rightSquared = rightIn*rightIn;
-        rmsEnvelopeLin = 0.5*(leftSquared + rightSquared);
-        envOut += envB0*(rmsEnvelopeLin - envOut); // leaky integrator
-        rmsEnvelopeLin = sqrt(envOut);
-        rmsEnvelopeDb = 20*log10(rmsEnvelopeLin);
-        
-        // gain calculation
-        if (rmsEnvelopeDb <= thresholdDb) {
-            preDynamicsGainDb = 0;
-        } else {
-            preDynamicsGainDb = (1.0/ratio - 1)*(rmsEnvelopeDb - thresholdDb);
-        }
-        preDynamicsGainLinear = pow(10,preDynamicsGainDb/20.0);
-        
-        // gain dynamics
-        if (preDynamicsGainLinear < gainOutLinear) {
-            gainCoeff = attackCoeff;
-        } else {
-            gainCoeff = releaseCoeff;
-        }
-        gainOutLinear += gainCoeff*(preDynamicsGainLinear - gainOutLinear); // leaky integrator
-        
-        // post gain
-        finalGainLinear = gainOutLinear*postGainLinear;
-        
-        // apply gain to outputs
-        channelDataLeft[samp] = finalGainLinear*leftIn;
-        channelDataRight[samp] = finalGainLinear*rightIn;
+    // the engine picks up a lookahead change in process(), the host hears
+    // about it from the message thread
+    if (compressor.getLatencySamples() != engineLatency.load(std::memory_order_relaxed)) {
+        engineLatency = compressor.getLatencySamples();
+        triggerAsyncUpdate();
+    }
+
+    // values read by the GUI
+    if (publish) {
+        auto& stats = compressor.getLastBlockStats();
+        telemetryQueue.push({stats.inputPeak, stats.inputRms, compressor.getRmsEnvelopeDb(),
+                             stats.minGainLinear, stats.maxGainLinear, numSamples,
+                             samplePosition, juce::Time::getHighResolutionTicks()});
     }
+    samplePosition += numSamples;
+    loadMonitor.end(numSamples, getSampleRate());
 }
 
 //==============================================================================
@@ -255,32 +410,67 @@ juce::AudioProcessorEditor* ColemanJP05CompressorAudioProcessor::createEditor()
 //==============================================================================
 void ColemanJP05CompressorAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    juce::XmlElement xml ("Parameters");
-    for (int i = 0; i < getParameters().size(); ++i)
-    {
-        juce::AudioParameterFloat* param = (juce::AudioParameterFloat*)getParameters().getUnchecked(i);
-        juce::XmlElement* paramElement = new juce::XmlElement ("parameter" + juce::String(std::to_string(i)));
-        paramElement->setAttribute ("value", param->get());
-        xml.addChildElement (paramElement);
-    }
-    copyXmlToBinary (xml, destData);
+    float values[CompressorEngine::numParameters];
+    getParameterValues(values);
+    uint8_t state[CompressorState::maxStateSize];
+    destData.replaceWith(state, CompressorState::writeState(values, state));
 }
 
-void ColemanJP05CompressorAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+namespace
 {
-    std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
-    if (xmlState->hasTagName ("Parameters")) // read Parameters tag
+    // state saved before the binary format: a <Parameters> element with a
+    // parameterN child per parameter, N its position
+    bool readXmlState (const void* data, int sizeInBytes, float* values)
     {
-        juce::AudioParameterFloat* param;
-        for (auto* element : xmlState->getChildIterator()) // loop through the saved parameter values and update them
+        std::unique_ptr<juce::XmlElement> xml (juce::AudioProcessor::getXmlFromBinary (data, sizeInBytes));
+        if (xml == nullptr || !xml->hasTagName ("Parameters"))
+            return false;
+
+        for (int i = 0; i < CompressorEngine::numParameters; i++)
+            values[i] = CompressorEngine::getParameterDefault((CompressorEngine::Parameter) i);
+        for (auto* element : xml->getChildIterator())
         {
-            int paramNum = std::stoi(element->getTagName().substring(9).toStdString()); // chops off beginnging "parameter"
-            param = (juce::AudioParameterFloat*) getParameters().getUnchecked(paramNum);
-            *param = element->getDoubleAttribute("value"); // set parameter value
+            const juce::String tag = element->getTagName();
+            const juce::String index = tag.substring(9); // after "parameter"
+            if (!tag.startsWith("parameter") || index.isEmpty() || index.length() > 3
+                || !index.containsOnly("0123456789") || !element->hasAttribute("value"))
+                continue; // not ours, skip rather than guess
+            const int param = index.getIntValue();
+            if (param < CompressorEngine::numParameters)
+                values[param] = (float) element->getDoubleAttribute("value");
         }
+        return true;
     }
 }
 
+void ColemanJP05CompressorAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // binary state, or the XML of older versions; anything else keeps the
+    // current settings
+    float values[CompressorEngine::numParameters];
+    if (sizeInBytes <= 0
+        || (!CompressorState::readState(data, (size_t) sizeInBytes, values) && !readXmlState(data, sizeInBytes, values)))
+        return;
+    setParameterValues(values);
+}
+
+juce::File ColemanJP05CompressorAudioProcessor::getPresetBankFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile(JucePlugin_Name).getChildFile("Presets.m45bank");
+}
+
+void ColemanJP05CompressorAudioProcessor::loadPresetBank()
+{
+    const juce::File file = getPresetBankFile();
+    if (!file.existsAsFile())
+        return;
+    presetBankMapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    if (presetBankMapping->getData() == nullptr
+        || !presetBank.open(presetBankMapping->getData(), presetBankMapping->getSize()))
+        presetBankMapping.reset(); // a failed open leaves the bank empty
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -10,11 +10,18 @@
 
 #include <JuceHeader.h>
 #include "defines.h"
+#include "CompressorEngine.h"
+#include "MultichannelCompressor.h"
+#include "CompressorState.h"
+#include "LoadMonitor.h"
+#include "SpscQueue.h"
 
 //==============================================================================
 /**
 */
-class ColemanJP05CompressorAudioProcessor  : public juce::AudioProcessor
+class ColemanJP05CompressorAudioProcessor  : public juce::AudioProcessor,
+                                             private juce::AudioProcessorParameter::Listener,
+                                             private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -30,6 +37,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -54,8 +63,36 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
-    float rmsEnvelopeDb;
-    float gainOutLinear = 1;
+    // summary of one processed block, sent to the editor
+    struct BlockTelemetry {
+        float inputPeak;        // linear, max abs sample
+        float inputRms;         // linear
+        float rmsEnvelopeDb;    // detector level at the end of the block
+        float minGainLinear;    // most gain reduction in the block
+        float maxGainLinear;    // least gain reduction in the block
+        int numSamples;
+        juce::int64 samplePosition; // samples processed since prepareToPlay, at block start
+        juce::int64 ticks;          // juce::Time::getHighResolutionTicks() when published
+    };
+    
+    // the editor turns publishing on while it is open
+    void setTelemetryEnabled(bool enabled) { telemetryEnabled = enabled; }
+    
+    // message thread only, false once there is nothing left to read
+    bool popTelemetry(BlockTelemetry& telemetry) { return telemetryQueue.pop(telemetry); }
+
+    // time each processBlock against its real-time budget; off until
+    // enabled here or from the editor, stats can be read from any thread
+    LoadMonitor& getLoadMonitor() { return loadMonitor; }
+
+    // whether the current layout and channel link run on the engine, or on
+    // the batch without its lookahead, true peak, bands, key filter and
+    // eco. Message thread, for the editor
+    bool isUsingEngine() const;
+
+    // the preset bank the programs come from (CompressorState.h), made
+    // with BatchRender --save-preset
+    static juce::File getPresetBankFile();
 
 private:
     //==============================================================================
@@ -67,18 +104,43 @@ private:
     juce::AudioParameterFloat* releaseParam; // ms
     juce::AudioParameterFloat* preGainParam; // dB
     juce::AudioParameterFloat* postGainParam; // dB
+    juce::AudioParameterFloat* lookaheadParam; // ms
+    juce::AudioParameterFloat* truePeakParam; // 0 = off, 1 = 2x, 2 = 4x
+    
+    MultichannelCompressor compressor; // DSP state, coefficients and the block loop
     
-    float fs;               // sampling rate
-    float envOut = 0.0;    // output & delay memory for RMS env follower
-    float envB0;           // filter coeff for RMS env follower
-    float envTau = 0.01;   // integration time in sec for RMS env follower: TO CHANGE?
+    // set by any parameter change, the engine is only updated when it is
+    std::atomic<bool> parametersChanged { true };
+    
+    void updateEngineParameters();
+
+    // all parameters in CompressorEngine::Parameter order and units
+    void getParameterValues (float* values) const;
+    void setParameterValues (const float* values);
+
+    // the programs, mapped for as long as the plugin is loaded so that
+    // switching programs only reads a row of the file
+    std::unique_ptr<juce::MemoryMappedFile> presetBankMapping;
+    CompressorState::PresetBank presetBank;
+    int currentProgram = 0;
+    void loadPresetBank();
+
+    // shared by both processBlock overloads
+    template <typename Sample>
+    void processSamples (juce::AudioBuffer<Sample>& buffer);
+    
+    // audio thread -> editor, blocks are dropped if the editor falls behind
+    std::atomic<bool> telemetryEnabled { false };
+    SpscQueue<BlockTelemetry, 256> telemetryQueue;
+    juce::int64 samplePosition = 0;
+
+    LoadMonitor loadMonitor;
     
-    float attackCoeff;
-    float releaseCoeff;
-    float thresholdDb;
-    float ratio;
-    float preGainLinear;
-    float postGainLinear;
+    // the latency the engine has picked up in process(), reported to the
+    // host from the message thread
+    std::atomic<int> engineLatency { 0 };
+    void handleAsyncUpdate() override;
     
-    void calcAlgorithmParams();
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
 };
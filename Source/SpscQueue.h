@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    SpscQueue.h
+    Created: 17 Oct 2026 1:14:52pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+//==============================================================================
+/**
+ Wait-free single producer/single consumer ring buffer. push() may only be
+ called from one thread (the audio thread) and pop() from one other thread
+ (the message thread). Neither call blocks or allocates; push() drops the
+ item when the queue is full.
+
+ The producer and consumer indices sit on separate cache lines, and each
+ side keeps a cached copy of the other side's index so it only touches
+ the shared line when the queue looks full/empty.
+*/
+template <typename T, int Capacity>
+class SpscQueue
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    // producer only, returns false if the queue was full
+    bool push(const T& item) {
+        const uint32_t write = writeIndex.load(std::memory_order_relaxed);
+        if (write - cachedReadIndex == Capacity) {
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            if (write - cachedReadIndex == Capacity)
+                return false;
+        }
+        items[write & (Capacity - 1)] = item;
+        writeIndex.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only, returns false if the queue was empty
+    bool pop(T& item) {
+        const uint32_t read = readIndex.load(std::memory_order_relaxed);
+        if (read == cachedWriteIndex) {
+            cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+            if (read == cachedWriteIndex)
+                return false;
+        }
+        item = items[read & (Capacity - 1)];
+        readIndex.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(64) std::atomic<uint32_t> writeIndex { 0 };
+    uint32_t cachedReadIndex = 0;   // producer's view of readIndex
+
+    alignas(64) std::atomic<uint32_t> readIndex { 0 };
+    uint32_t cachedWriteIndex = 0;  // consumer's view of writeIndex
+
+    alignas(64) T items[Capacity];
+};
@@ -42,9 +42,51 @@
 #define GAIN_INTERVAL       0.1
 #define GAIN_SKEW           NO_SKEW
 
+#define LOOKAHEAD_MIN       0.0 // ms
+#define LOOKAHEAD_DEFAULT   0.0
+#define LOOKAHEAD_MAX       20.0
+#define LOOKAHEAD_INTERVAL  0.1
+#define LOOKAHEAD_SKEW      NO_SKEW
+
+#define TRUE_PEAK_MIN       0.0 // 0 = off, 1 = 2x, 2 = 4x oversampled detector
+#define TRUE_PEAK_DEFAULT   0.0
+#define TRUE_PEAK_MAX       2.0
+
+#define BANDS_MIN           1.0 // 1 = single band
+#define BANDS_DEFAULT       1.0
+#define BANDS_MAX           5.0
+
+#define CROSSOVER_MIN       20.0 // Hz
+#define CROSSOVER_MAX       20000.0
+#define CROSSOVER_INTERVAL  1
+#define CROSSOVER_SKEW      0.25
+#define CROSSOVER1_DEFAULT  120.0
+#define CROSSOVER2_DEFAULT  500.0
+#define CROSSOVER3_DEFAULT  2000.0
+#define CROSSOVER4_DEFAULT  6000.0
+
+#define KEY_FILTER_MIN      0.0 // 0 = off, 1 = high pass, 2 = low pass, 3 = band pass
+#define KEY_FILTER_DEFAULT  0.0
+#define KEY_FILTER_MAX      3.0
+
+#define KEY_CUT_MIN         20.0 // Hz, key filter corners
+#define KEY_CUT_MAX         20000.0
+#define KEY_CUT_INTERVAL    1
+#define KEY_CUT_SKEW        0.25
+#define KEY_LOW_CUT_DEFAULT 100.0
+#define KEY_HIGH_CUT_DEFAULT 8000.0
+
+#define LINK_MIN            0.0 // 0 = linked, 1 = in pairs, 2 = per channel
+#define LINK_DEFAULT        0.0
+#define LINK_MAX            2.0
+
+#define ECO_MIN             1.0 // samples per gain computer update, 1 = every sample
+#define ECO_DEFAULT         1.0
+#define ECO_MAX             32.0
+
 // GUI
 #define UNIT_LENGTH_X       30
 #define UNIT_LENGTH_Y       30
 
-#define CONTAINER_WIDTH     UNIT_LENGTH_X*21
+#define CONTAINER_WIDTH     UNIT_LENGTH_X*36
 #define CONTAINER_HEIGHT    UNIT_LENGTH_Y*16
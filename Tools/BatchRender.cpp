@@ -0,0 +1,638 @@
+/*
+  ==============================================================================
+
+    BatchRender.cpp
+    Created: 16 Oct 2026 5:31:44pm
+    Author:  Coleman Jenkins
+
+    Renders WAV files through CompressorEngine in parallel, e.g.
+        BatchRender -j 8 --threshold -30 --ratio 4 -o out --list stems.txt
+
+    Input, sidechain and output are memory-mapped (MappedWavReader/Writer)
+    and streamed through the engine a block at a time, converting straight
+    between the file's samples and one block of planar floats per thread,
+    so files of any length (RF64 past 4 GB) render in constant memory and
+    without copies.
+
+    With --split N each file is cut into N chunks that render in parallel
+    instead, for a single long file. Every chunk but the first starts
+    --preroll ms early on a fresh engine to warm up its detector and gain
+    state. Once all chunks are done each boundary is checked in order: if
+    the state the chunk warmed up to is not bit for bit the state the
+    previous chunk ended in, the chunk's first --preroll ms are rendered
+    again from the latter, overwriting that part of the output. Where that catches up with the chunk's own
+    render the output equals the sequential render; where it does not
+    (integrators that settle on history dependent values, e.g. a gain
+    creeping towards 1 in silence) the gain mismatch left is printed,
+    typically far below 0.001 dB. --exact renders those chunks again to
+    the end instead, for a bit exact result at the cost of parallelism.
+
+    --automation reads timed parameter changes, one per line:
+        # seconds  parameter id  value
+        2.5        threshold     -24
+        2.5        postGain      3
+    Each is handed to the engine at its sample offset, in the block the
+    change before it to the same parameter falls in (its own block for the
+    first), so the engine glides from one to the next the same way
+    whatever --block is.
+
+  ==============================================================================
+*/
+
+#include "../Source/CompressorEngine.h"
+#include "../Source/CompressorState.h"
+#include "WavFile.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // a --automation line
+    struct AutomationPoint {
+        double seconds;
+        CompressorEngine::Parameter param;
+        float value;
+    };
+
+    struct Settings {
+        float parameters[CompressorEngine::numParameters];
+        std::vector<AutomationPoint> automation; // in time order
+        CompressorEngine::RampShape gainRampShape = CompressorEngine::RampShape::linear;
+        int blockSize = 512;      // host buffer size to emulate
+        int jobs = WorkStealingPool::getDefaultNumThreads();
+        std::string outputDir;    // empty: next to the input
+        std::string suffix = "_compressed";
+        bool writeFloat = false;
+        const MappedWavReader* sidechain = nullptr; // detector input for every file, or null
+        int split = 1;            // chunks per file rendered in parallel
+        double prerollMs = 10000; // warm-up before each chunk but the first
+        bool exactSplit = false;  // render chunks again until they match the sequential render
+    };
+
+    struct Result {
+        bool ok = false;
+        std::string error;
+        int64_t numFrames = 0;
+        double sampleRate = 0;
+        double openMs = 0;      // mapping the input, creating the output
+        double renderMs = 0;    // reading, processing and writing, as they are streamed
+        double closeMs = 0;
+        int reRendered = 0;         // --split chunks whose pre-roll had not converged
+        int notConverged = 0;       // of those, the ones still apart after the window
+        float maxMismatchDb = 0;    // largest gain or detector difference left
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::string getOutputPath(const std::string& input, const Settings& settings) {
+        const size_t slash = input.find_last_of("/\\");
+        std::string dir = slash == std::string::npos ? "" : input.substr(0, slash + 1);
+        std::string name = slash == std::string::npos ? input : input.substr(slash + 1);
+
+        const size_t dot = name.find_last_of('.');
+        if (dot != std::string::npos)
+            name = name.substr(0, dot);
+
+        if (!settings.outputDir.empty())
+            dir = settings.outputDir + "/";
+        return dir + name + settings.suffix + ".wav";
+    }
+
+    void setupEngine(CompressorEngine& engine, const Settings& settings, double sampleRate) {
+        for (int i = 0; i < CompressorEngine::numParameters; i++)
+            engine.setParameter((CompressorEngine::Parameter) i, settings.parameters[i]);
+        engine.setGainRampShape(settings.gainRampShape);
+        engine.prepare(sampleRate, settings.blockSize);
+    }
+
+    // "seconds id value" lines, sorted by time (stable, so changes at the
+    // same time keep the file's order). Lookahead and true peak change the
+    // latency, which a render can't follow, so they are refused
+    bool readAutomation(const std::string& path, std::vector<AutomationPoint>& points, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        int lineNumber = 0;
+        for (std::string line; std::getline(file, line);) {
+            lineNumber++;
+            const size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#')
+                continue;
+
+            char id[64];
+            AutomationPoint point;
+            if (std::sscanf(line.c_str(), "%lf %63s %f", &point.seconds, id, &point.value) != 3 || point.seconds < 0) {
+                error = path + ":" + std::to_string(lineNumber) + ": expected seconds, parameter id and value";
+                return false;
+            }
+            int param = 0;
+            while (param < CompressorEngine::numParameters
+                   && std::strcmp(id, CompressorEngine::getParameterId((CompressorEngine::Parameter) param)) != 0)
+                param++;
+            if (param == CompressorEngine::numParameters) {
+                error = path + ":" + std::to_string(lineNumber) + ": unknown parameter " + id;
+                return false;
+            }
+            point.param = (CompressorEngine::Parameter) param;
+            if (point.param == CompressorEngine::lookahead || point.param == CompressorEngine::truePeak) {
+                error = path + ":" + std::to_string(lineNumber) + ": " + id + " changes the latency and can't be automated";
+                return false;
+            }
+            points.push_back(point);
+        }
+        std::stable_sort(points.begin(), points.end(),
+                         [](const AutomationPoint& a, const AutomationPoint& b) { return a.seconds < b.seconds; });
+        return true;
+    }
+
+    // a render reads the input (mono as dual mono) and the sidechain
+    // straight from their mappings, zeros past their ends, and runs
+    // latency frames past the input's end so the lookahead can flush. The
+    // output is written latency frames earlier, so it lines up with the
+    // input
+    struct Stream {
+        const MappedWavReader* input = nullptr;
+        const MappedWavReader* sidechain = nullptr; // or null
+        MappedWavWriter* output = nullptr;
+        int64_t numFrames = 0;  // input frames + latency
+        int latency = 0;
+
+        // --automation at this sample rate, in time order, and again in
+        // the order they are handed to the engine: at handFrame, the frame
+        // of the change before to the same parameter
+        struct Change {
+            int64_t frame;
+            int64_t handFrame;
+            CompressorEngine::Parameter param;
+            float value;
+        };
+        std::vector<Change> automation;
+        std::vector<Change> handOrder;
+
+        void setAutomation(const std::vector<AutomationPoint>& points, double sampleRate) {
+            int64_t lastFrame[CompressorEngine::numParameters];
+            std::fill(lastFrame, lastFrame + CompressorEngine::numParameters, -1);
+            for (const AutomationPoint& point : points) {
+                const int64_t frame = std::llround(point.seconds*sampleRate);
+                const int64_t handFrame = lastFrame[point.param] >= 0 ? lastFrame[point.param] : frame;
+                automation.push_back({ frame, handFrame, point.param, point.value });
+                lastFrame[point.param] = frame;
+            }
+            handOrder = automation;
+            std::stable_sort(handOrder.begin(), handOrder.end(),
+                             [](const Change& a, const Change& b) { return a.handFrame < b.handFrame; });
+        }
+
+        // the first change at or after frame
+        size_t findChange(int64_t frame) const {
+            return std::lower_bound(automation.begin(), automation.end(), frame,
+                                    [](const Change& c, int64_t f) { return c.frame < f; }) - automation.begin();
+        }
+
+        // the first change handed at or after frame
+        size_t findHand(int64_t frame) const {
+            return std::lower_bound(handOrder.begin(), handOrder.end(), frame,
+                                    [](const Change& c, int64_t f) { return c.handFrame < f; }) - handOrder.begin();
+        }
+    };
+
+    // one block for one thread, allocated once per render
+    struct Buffers {
+        explicit Buffers(int blockSize) : left(blockSize), right(blockSize), keyLeft(blockSize), keyRight(blockSize) {}
+        std::vector<float> left, right, keyLeft, keyRight;
+    };
+
+    // first and last channel of a mono or stereo file
+    void readStereo(const MappedWavReader& file, int64_t start, int n, float* left, float* right) {
+        float* channels[] = { left, right };
+        file.read(start, n, channels);
+        if (file.getFormat().numChannels == 1)
+            std::copy(left, left + n, right);
+    }
+
+    // frames [begin, end) of the stream through the engine, block by block
+    // as a host would, with the automation handed in each block, writing
+    // the output if write is set
+    void renderRange(CompressorEngine& engine, const Stream& stream, int64_t begin, int64_t end,
+                     bool write, int blockSize, Buffers& buffers) {
+        float* l = buffers.left.data();
+        float* r = buffers.right.data();
+        size_t change = stream.findHand(begin);
+        for (int64_t start = begin; start < end; start += blockSize) {
+            const int n = (int) std::min<int64_t>(blockSize, end - start);
+            for (; change < stream.handOrder.size() && stream.handOrder[change].handFrame < start + n; change++) {
+                const Stream::Change& c = stream.handOrder[change];
+                engine.setParameter(c.param, c.value, (int) (c.frame - start));
+            }
+            readStereo(*stream.input, start, n, l, r);
+            if (stream.sidechain != nullptr) {
+                readStereo(*stream.sidechain, start, n, buffers.keyLeft.data(), buffers.keyRight.data());
+                engine.process(buffers.keyLeft.data(), buffers.keyRight.data(), l, r, n);
+            } else {
+                engine.process(l, r, n);
+            }
+            if (write) {
+                const float* channels[] = { l, r };
+                stream.output->write(start - stream.latency, n, channels);
+            }
+        }
+    }
+
+    // same result as rendering the stream in one go, cut into
+    // settings.split chunks rendered on the pool (see the top of the file)
+    void renderSplit(const CompressorEngine& prepared, const Stream& stream, const Settings& settings,
+                     double sampleRate, WorkStealingPool& pool, Result& result) {
+        // chunk edges and the pre-roll on the block grid, so every chunk
+        // sees the same blocks the sequential render would
+        const int blockSize = settings.blockSize;
+        const int64_t numBlocks = (stream.numFrames + blockSize - 1)/blockSize;
+        const int64_t chunkFrames = (numBlocks + settings.split - 1)/settings.split*blockSize;
+        const int64_t prerollFrames = (int64_t) std::ceil(settings.prerollMs*sampleRate/1000.0/blockSize)*blockSize;
+
+        struct Chunk {
+            int64_t begin = 0;
+            int64_t end = 0;
+            int64_t windowEnd = 0;          // the part rendered again when the pre-roll fell short
+            CompressorEngine startEngine;   // after the pre-roll
+            CompressorEngine windowEngine;  // at windowEnd
+            CompressorEngine endEngine;     // after the chunk
+        };
+
+        std::vector<Chunk> chunks;
+        for (int64_t begin = 0; begin < stream.numFrames; begin += chunkFrames) {
+            chunks.emplace_back();
+            Chunk& chunk = chunks.back();
+            chunk.begin = begin;
+            chunk.end = std::min(begin + chunkFrames, stream.numFrames);
+            chunk.windowEnd = settings.exactSplit ? chunk.end : std::min(begin + prerollFrames, chunk.end);
+        }
+
+        for (Chunk& chunk : chunks) {
+            pool.submit([&] {
+                Buffers buffers(blockSize);
+                CompressorEngine engine = prepared;
+
+                // the automation before the pre-roll, settled as if it
+                // had long been played
+                const int64_t prerollBegin = std::max<int64_t>(0, chunk.begin - prerollFrames);
+                const size_t settled = stream.findChange(prerollBegin);
+                if (settled > 0) {
+                    for (size_t i = 0; i < settled; i++)
+                        engine.setParameter(stream.automation[i].param, stream.automation[i].value);
+                    engine.prepare(sampleRate, blockSize);
+
+                    // and the changes the render would have handed already
+                    for (size_t i = 0; i < stream.findHand(prerollBegin); i++) {
+                        const Stream::Change& c = stream.handOrder[i];
+                        if (c.frame >= prerollBegin)
+                            engine.setParameter(c.param, c.value, (int) (c.frame - prerollBegin));
+                    }
+                }
+                renderRange(engine, stream, prerollBegin, chunk.begin, false, blockSize, buffers);
+                chunk.startEngine = engine;
+                renderRange(engine, stream, chunk.begin, chunk.windowEnd, true, blockSize, buffers);
+                chunk.windowEngine = engine;
+                renderRange(engine, stream, chunk.windowEnd, chunk.end, true, blockSize, buffers);
+                chunk.endEngine = engine;
+            });
+        }
+        pool.wait();
+
+        // hand the state over chunk by chunk, the first one started from
+        // the beginning. Where the pre-roll had not converged the window is
+        // rendered again from the state handed over; if that catches up with
+        // the chunk's own render the rest of the chunk is exact as well,
+        // otherwise the gain mismatch left at windowEnd is the error
+        Buffers buffers(blockSize);
+        for (size_t k = 1; k < chunks.size(); k++) {
+            Chunk& chunk = chunks[k];
+            if (chunk.startEngine.isInSameState(chunks[k - 1].endEngine))
+                continue;
+
+            CompressorEngine engine = chunks[k - 1].endEngine;
+            renderRange(engine, stream, chunk.begin, chunk.windowEnd, true, blockSize, buffers);
+            result.reRendered++;
+
+            if (settings.exactSplit) {
+                chunk.endEngine = engine;
+            } else if (!engine.isInSameState(chunk.windowEngine)) {
+                const float gainDb = 20*std::log10(std::max(engine.getGainOutLinear(), 1.0e-10f)/
+                                                   std::max(chunk.windowEngine.getGainOutLinear(), 1.0e-10f));
+                const float detectorDb = std::max(engine.getRmsEnvelopeDb(), -200.0f) -
+                                         std::max(chunk.windowEngine.getRmsEnvelopeDb(), -200.0f);
+                result.maxMismatchDb = std::max({ result.maxMismatchDb, std::abs(gainDb), std::abs(detectorDb) });
+                result.notConverged++;
+            }
+        }
+    }
+
+    Result renderFile(const std::string& inputPath, const Settings& settings, WorkStealingPool* chunkPool) {
+        Result result;
+
+        auto start = Clock::now();
+        MappedWavReader input;
+        if (!input.open(inputPath, result.error))
+            return result;
+        const WavFormat& format = input.getFormat();
+        result.numFrames = input.getNumFrames();
+        result.sampleRate = format.sampleRate;
+
+        if (format.numChannels > 2) {
+            result.error = inputPath + ": only mono and stereo files are supported";
+            return result;
+        }
+        if (settings.sidechain != nullptr && settings.sidechain->getFormat().sampleRate != format.sampleRate) {
+            result.error = inputPath + ": sample rate differs from the sidechain";
+            return result;
+        }
+        const std::string outputPath = getOutputPath(inputPath, settings);
+        if (outputPath == inputPath) {
+            result.error = inputPath + ": the output would overwrite the input";
+            return result;
+        }
+
+        WavFormat outputFormat = format;
+        if (settings.writeFloat) {
+            outputFormat.isFloat = true;
+            outputFormat.bitsPerSample = 32;
+        }
+        MappedWavWriter output;
+        if (!output.create(outputPath, outputFormat, input.getNumFrames(), result.error))
+            return result;
+        result.openMs = millisecondsSince(start);
+
+        start = Clock::now();
+        CompressorEngine engine;
+        setupEngine(engine, settings, format.sampleRate);
+        Stream stream;
+        stream.input = &input;
+        stream.sidechain = settings.sidechain;
+        stream.output = &output;
+        stream.latency = engine.getLatencySamples();
+        stream.numFrames = input.getNumFrames() + stream.latency;
+        stream.setAutomation(settings.automation, format.sampleRate);
+        if (chunkPool != nullptr) {
+            renderSplit(engine, stream, settings, format.sampleRate, *chunkPool, result);
+        } else {
+            Buffers buffers(settings.blockSize);
+            renderRange(engine, stream, 0, stream.numFrames, true, settings.blockSize, buffers);
+        }
+        result.renderMs = millisecondsSince(start);
+
+        start = Clock::now();
+        if (!output.close(result.error))
+            return result;
+        result.closeMs = millisecondsSince(start);
+
+        result.ok = true;
+        return result;
+    }
+
+    void printUsage() {
+        std::printf("usage: BatchRender [options] file.wav...\n"
+                    "  -j, --jobs N          worker threads (default: %d)\n"
+                    "  -l, --list FILE       read input paths from FILE, one per line\n"
+                    "  -o, --output DIR      output directory (default: next to each input)\n"
+                    "  --suffix TEXT         appended to output names (default: _compressed)\n"
+                    "  --block N             block size passed to the engine (default: 512)\n"
+                    "  --float               write 32 bit float instead of the input format\n"
+                    "  --sidechain FILE      the detector listens to FILE (mono or stereo) instead\n"
+                    "  --split N             render each file as N chunks in parallel (default: 1)\n"
+                    "  --preroll MS          warm-up before each --split chunk (default: 10000)\n"
+                    "  --exact               with --split, always match the sequential render bit for bit\n"
+                    "  --automation FILE     timed changes, \"seconds parameterId value\" per line\n"
+                    "  --gain-ramp lin|exp   pre and post gain glides linear in gain or in dB (default: lin)\n"
+                    "  --threshold DB  --ratio R  --attack MS  --release MS\n"
+                    "  --pre-gain DB   --post-gain DB  --lookahead MS\n"
+                    "  --true-peak 0|1|2     detector oversampling off, 2x, 4x\n"
+                    "  --bands 1..5          multiband, --threshold..--release set band 1\n"
+                    "  --crossover1..4 HZ    band edges\n"
+                    "  --band2-threshold DB  --band2-ratio R  --band2-attack MS  --band2-release MS\n"
+                    "                        and the same for band3..band5\n"
+                    "  --key-filter 0..3     detector filter off, high, low, band pass\n"
+                    "  --key-low-cut HZ  --key-high-cut HZ\n"
+                    "  --channel-link 0..2   the plugin's detector linking (linked, pairs, per channel),\n"
+                    "                        for presets: files here always render linked\n"
+                    "  --eco N               run the gain computer every N samples (1..32, 1 = off)\n"
+                    "  --preset-bank FILE    preset bank for the two options below (the plugin's programs)\n"
+                    "  --preset NAME         start from a preset, the options above override it\n"
+                    "  --save-preset NAME    store the settings in the bank (rendering is optional)\n",
+                    WorkStealingPool::getDefaultNumThreads());
+    }
+
+    const char* const parameterFlags[CompressorEngine::numParameters] = {
+        "--threshold", "--ratio", "--attack", "--release", "--pre-gain", "--post-gain",
+        "--lookahead", "--true-peak", "--bands",
+        "--crossover1", "--crossover2", "--crossover3", "--crossover4",
+        "--band2-threshold", "--band2-ratio", "--band2-attack", "--band2-release",
+        "--band3-threshold", "--band3-ratio", "--band3-attack", "--band3-release",
+        "--band4-threshold", "--band4-ratio", "--band4-attack", "--band4-release",
+        "--band5-threshold", "--band5-ratio", "--band5-attack", "--band5-release",
+        "--key-filter", "--key-low-cut", "--key-high-cut", "--channel-link", "--eco"
+    };
+}
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    for (int i = 0; i < CompressorEngine::numParameters; i++)
+        settings.parameters[i] = CompressorEngine::getParameterDefault((CompressorEngine::Parameter) i);
+
+    std::vector<std::string> inputs;
+    std::string sidechainPath;
+    std::string presetBankPath, presetName, savePresetName;
+    bool parameterGiven[CompressorEngine::numParameters] = {};
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if ((arg == "-j" || arg == "--jobs") && hasValue) {
+            settings.jobs = std::max(1, std::atoi(argv[++i]));
+        } else if ((arg == "-l" || arg == "--list") && hasValue) {
+            std::ifstream list(argv[++i]);
+            if (!list) {
+                std::fprintf(stderr, "cannot open %s\n", argv[i]);
+                return 1;
+            }
+            for (std::string line; std::getline(list, line);)
+                if (!line.empty() && line[0] != '#')
+                    inputs.push_back(line);
+        } else if ((arg == "-o" || arg == "--output") && hasValue) {
+            settings.outputDir = argv[++i];
+        } else if (arg == "--suffix" && hasValue) {
+            settings.suffix = argv[++i];
+        } else if (arg == "--block" && hasValue) {
+            settings.blockSize = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--sidechain" && hasValue) {
+            sidechainPath = argv[++i];
+        } else if (arg == "--split" && hasValue) {
+            settings.split = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--preroll" && hasValue) {
+            settings.prerollMs = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--exact") {
+            settings.exactSplit = true;
+        } else if (arg == "--automation" && hasValue) {
+            std::string error;
+            if (!readAutomation(argv[++i], settings.automation, error)) {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+        } else if (arg == "--gain-ramp" && hasValue) {
+            const std::string shape = argv[++i];
+            if (shape != "lin" && shape != "exp") {
+                std::fprintf(stderr, "--gain-ramp is lin or exp\n");
+                return 1;
+            }
+            settings.gainRampShape = shape == "exp" ? CompressorEngine::RampShape::exponential
+                                                    : CompressorEngine::RampShape::linear;
+        } else if (arg == "--float") {
+            settings.writeFloat = true;
+        } else if (arg == "--preset-bank" && hasValue) {
+            presetBankPath = argv[++i];
+        } else if (arg == "--preset" && hasValue) {
+            presetName = argv[++i];
+        } else if (arg == "--save-preset" && hasValue) {
+            savePresetName = argv[++i];
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            const char* const* flag = std::find(parameterFlags, parameterFlags + CompressorEngine::numParameters, arg);
+            if (flag == parameterFlags + CompressorEngine::numParameters || !hasValue) {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                printUsage();
+                return 1;
+            }
+            settings.parameters[flag - parameterFlags] = (float) std::atof(argv[++i]);
+            parameterGiven[flag - parameterFlags] = true;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (!presetName.empty() || !savePresetName.empty()) {
+        if (presetBankPath.empty()) {
+            std::fprintf(stderr, "--preset and --save-preset need --preset-bank\n");
+            return 1;
+        }
+        std::ifstream bankFile(presetBankPath, std::ios::binary);
+        std::vector<uint8_t> bank((std::istreambuf_iterator<char>(bankFile)), std::istreambuf_iterator<char>());
+
+        if (!presetName.empty()) {
+            CompressorState::PresetBank presets;
+            const int preset = presets.open(bank.data(), bank.size()) ? presets.findPreset(presetName.c_str()) : -1;
+            if (preset < 0) {
+                std::fprintf(stderr, "no preset %s in %s\n", presetName.c_str(), presetBankPath.c_str());
+                return 1;
+            }
+            float values[CompressorEngine::numParameters];
+            presets.getValues(preset, values);
+            for (int i = 0; i < CompressorEngine::numParameters; i++) {
+                if (!parameterGiven[i])
+                    settings.parameters[i] = values[i];
+            }
+        }
+
+        if (!savePresetName.empty()) {
+            CompressorState::addPreset(bank, savePresetName, settings.parameters);
+            std::ofstream out(presetBankPath, std::ios::binary);
+            if (!out.write((const char*) bank.data(), (std::streamsize) bank.size())) {
+                std::fprintf(stderr, "cannot write %s\n", presetBankPath.c_str());
+                return 1;
+            }
+            std::printf("saved preset %s to %s\n", savePresetName.c_str(), presetBankPath.c_str());
+            if (inputs.empty())
+                return 0;
+        }
+    }
+
+    if (inputs.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    MappedWavReader sidechain;
+    if (!sidechainPath.empty()) {
+        std::string error;
+        if (!sidechain.open(sidechainPath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        if (sidechain.getFormat().numChannels > 2) {
+            std::fprintf(stderr, "%s: only mono and stereo sidechains are supported\n", sidechainPath.c_str());
+            return 1;
+        }
+        settings.sidechain = &sidechain;
+    }
+
+    std::vector<Result> results(inputs.size());
+    std::mutex printLock;
+    auto printResult = [&](size_t i) {
+        const Result& r = results[i];
+        std::lock_guard<std::mutex> guard(printLock);
+        if (r.ok) {
+            const double seconds = r.numFrames/r.sampleRate;
+            std::printf("%-40s %10lld frames  open %6.1f ms  render %8.1f ms (%6.0fx realtime)  close %6.1f ms\n",
+                        inputs[i].c_str(), (long long) r.numFrames, r.openMs, r.renderMs,
+                        seconds*1000.0/std::max(r.renderMs, 1e-3), r.closeMs);
+            if (r.notConverged > 0)
+                std::printf("%-40s %d of %d chunk starts not converged, gain within %.2g dB of a sequential render\n",
+                            "", r.notConverged, settings.split - 1, r.maxMismatchDb);
+            else if (r.reRendered > 0)
+                std::printf("%-40s %d chunk starts rendered again, output equals a sequential render\n",
+                            "", r.reRendered);
+        } else {
+            std::printf("%-40s FAILED: %s\n", inputs[i].c_str(), r.error.c_str());
+        }
+    };
+
+    const auto start = Clock::now();
+    if (settings.split > 1) {
+        // one file at a time, its chunks spread over the pool
+        WorkStealingPool pool(settings.jobs);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            results[i] = renderFile(inputs[i], settings, &pool);
+            printResult(i);
+        }
+    } else {
+        WorkStealingPool pool(std::min<int>(settings.jobs, (int) inputs.size()));
+        for (size_t i = 0; i < inputs.size(); i++) {
+            pool.submit([&, i] {
+                results[i] = renderFile(inputs[i], settings, nullptr);
+                printResult(i);
+            });
+        }
+        pool.wait();
+    }
+
+    int failed = 0;
+    double audioSeconds = 0;
+    for (const Result& r : results) {
+        if (r.ok)
+            audioSeconds += r.numFrames/r.sampleRate;
+        else
+            failed++;
+    }
+
+    const double wallMs = millisecondsSince(start);
+    std::printf("%d files, %d failed, %.1f s of audio in %.1f ms with %d jobs (%.0fx realtime)\n",
+                (int) inputs.size(), failed, audioSeconds, wallMs, settings.jobs,
+                audioSeconds*1000.0/std::max(wallMs, 1e-3));
+    return failed == 0 ? 0 : 1;
+}
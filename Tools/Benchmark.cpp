@@ -0,0 +1,556 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+    Created: 17 Oct 2026 10:02:15am
+    Author:  Coleman Jenkins
+
+    Times CompressorEngine::process (the body of processBlock) over block
+    sizes, sample rates, parameter regimes and float/double samples, with
+    test_files/ and digital silence as input, and optionally with the
+    silent/quiet block fast paths off to compare. --batch N times N
+    compressors as N engines against one CompressorBatch instead, and
+    --eco the eco mode's control rate intervals against the per-sample
+    engine, with how far each one's output is from it.
+    Results go to stdout and optionally to a JSON file, and can be compared
+    against a previously saved JSON baseline.
+
+  ==============================================================================
+*/
+
+#include "../Source/CompressorBatch.h"
+#include "../Source/CompressorEngine.h"
+#include "WavFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Regime {
+        const char* name;
+        // threshold, ratio, attack, release, pre, post, lookahead, true peak,
+        // bands. Crossovers and the band 2..5 settings stay at their defaults
+        float parameters[CompressorEngine::crossover1];
+    };
+
+    const Regime regimes[] = {
+        { "below-threshold", {   0.0f,  4.0f, 20.0f,  200.0f, -20.0f, 0.0f, 0.0f, 0.0f, 1.0f } },
+        { "heavy",           { -40.0f, 30.0f,  5.0f,   50.0f,  10.0f, 0.0f, 0.0f, 0.0f, 1.0f } },
+        { "zero-attack",     { -30.0f,  8.0f,  0.0f,  100.0f,   0.0f, 0.0f, 0.0f, 0.0f, 1.0f } },
+        { "lookahead",       { -30.0f,  8.0f,  1.0f,  100.0f,   0.0f, 0.0f, 5.0f, 0.0f, 1.0f } },
+        { "true-peak-2x",    { -30.0f,  8.0f,  1.0f,  100.0f,   0.0f, 0.0f, 0.0f, 1.0f, 1.0f } },
+        { "true-peak-4x",    { -30.0f,  8.0f,  1.0f,  100.0f,   0.0f, 0.0f, 0.0f, 2.0f, 1.0f } },
+        { "multiband-4",     { -30.0f,  8.0f,  1.0f,  100.0f,   0.0f, 0.0f, 0.0f, 0.0f, 4.0f } },
+        { "multiband-5",     { -30.0f,  8.0f,  1.0f,  100.0f,   0.0f, 0.0f, 0.0f, 0.0f, 5.0f } }
+    };
+
+    const int blockSizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const double sampleRates[] = { 44100, 48000, 88200, 96000, 176400, 192000 };
+
+    struct Input {
+        std::string name;
+        std::vector<float> left, right;
+    };
+
+    struct Result {
+        std::string input;
+        std::string regime;
+        std::string precision; // float or double
+        bool fastPath = true;
+        double pathShare[CompressorKernel::numPaths] = {}; // fraction of the samples per path
+        double sampleRate;
+        int blockSize;
+        double nsPerSample;
+        double samplesPerSec;
+    };
+
+    std::string getKey(const Result& r) {
+        std::ostringstream key;
+        key << r.input << "/" << r.regime << "/" << r.sampleRate << "/" << r.blockSize << "/" << r.precision;
+        if (!r.fastPath)
+            key << "/full-loop";
+        return key.str();
+    }
+
+    // best of several runs over the same audio, in ns per stereo frame
+    template <typename Sample>
+    double timeCase(const Input& input, const Regime& regime, double sampleRate, int blockSize,
+                    int numSamples, int repeats, bool fastPath, double* pathShare) {
+        std::vector<Sample> left(numSamples), right(numSamples);
+        double best = 1e30;
+
+        for (int run = 0; run < repeats; run++) {
+            std::copy(input.left.begin(), input.left.begin() + numSamples, left.begin());
+            std::copy(input.right.begin(), input.right.begin() + numSamples, right.begin());
+
+            CompressorEngine engine;
+            for (int i = 0; i < CompressorEngine::crossover1; i++)
+                engine.setParameter((CompressorEngine::Parameter) i, regime.parameters[i]);
+            engine.prepare(sampleRate, blockSize);
+            engine.setFastPathEnabled(fastPath);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int pos = 0; pos < numSamples; pos += blockSize)
+                engine.process(left.data() + pos, right.data() + pos, std::min(blockSize, numSamples - pos));
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            best = std::min(best, ns/numSamples);
+            for (int p = 0; p < CompressorKernel::numPaths; p++)
+                pathShare[p] = (double) engine.getPathSamples((CompressorKernel::Path) p)/numSamples;
+        }
+        return best;
+    }
+
+    // --batch: numInstances compressors, each on the input from another
+    // start and with its own threshold, run as that many CompressorEngines
+    // and as one CompressorBatch. Best of the runs in ns per stereo sample
+    // and compressor
+    void timeBatch(const Input& input, const Regime& regime, double sampleRate, int blockSize,
+                   int numSamples, int numInstances, int repeats, double& engineNs, double& batchNs) {
+        const int length = (int) input.left.size();
+        std::vector<std::vector<float>> source(2*numInstances), channels(2*numInstances);
+        for (int k = 0; k < numInstances; k++) {
+            const int offset = (int) ((long long) k*7919*13 % length);
+            for (int ch = 0; ch < 2; ch++) {
+                const std::vector<float>& from = ch == 0 ? input.left : input.right;
+                source[2*k + ch].resize(numSamples);
+                for (int i = 0; i < numSamples; i++)
+                    source[2*k + ch][i] = from[(offset + i) % length];
+            }
+        }
+        auto thresholdOf = [&regime](int k) { return regime.parameters[CompressorEngine::threshold] - 2.0f*(k % 8); };
+        std::vector<float*> pointers(2*numInstances);
+        engineNs = batchNs = 1e30;
+
+        for (int run = 0; run < repeats; run++) {
+            channels = source;
+            std::vector<CompressorEngine> engines(numInstances);
+            for (int k = 0; k < numInstances; k++) {
+                for (int i = 0; i < CompressorEngine::crossover1; i++)
+                    engines[k].setParameter((CompressorEngine::Parameter) i, regime.parameters[i]);
+                engines[k].setParameter(CompressorEngine::threshold, thresholdOf(k));
+                engines[k].prepare(sampleRate, blockSize);
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (int pos = 0; pos < numSamples; pos += blockSize) {
+                const int n = std::min(blockSize, numSamples - pos);
+                for (int k = 0; k < numInstances; k++)
+                    engines[k].process(channels[2*k].data() + pos, channels[2*k + 1].data() + pos, n);
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            engineNs = std::min(engineNs, ns/numSamples/numInstances);
+
+            channels = source;
+            CompressorBatch batch;
+            batch.prepare(sampleRate, numInstances);
+            for (int k = 0; k < numInstances; k++) {
+                for (int i = 0; i <= CompressorEngine::postGain; i++)
+                    batch.setParameter(k, (CompressorEngine::Parameter) i, regime.parameters[i]);
+                batch.setParameter(k, CompressorEngine::threshold, thresholdOf(k));
+            }
+            batch.prepare(sampleRate, numInstances); // settings in place from the start, as for the engines
+            start = std::chrono::steady_clock::now();
+            for (int pos = 0; pos < numSamples; pos += blockSize) {
+                for (int ch = 0; ch < 2*numInstances; ch++)
+                    pointers[ch] = channels[ch].data() + pos;
+                batch.process(pointers.data(), std::min(blockSize, numSamples - pos));
+            }
+            ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            batchNs = std::min(batchNs, ns/numSamples/numInstances);
+        }
+    }
+
+    // --eco: the engine at a control rate interval (1 = per sample), best
+    // of the runs in ns per stereo sample, and the output of the last run
+    double timeEco(const Input& input, const Regime& regime, double sampleRate, int blockSize, int numSamples,
+                   int repeats, int interval, std::vector<float>& left, std::vector<float>& right) {
+        left.resize(numSamples);
+        right.resize(numSamples);
+        double best = 1e30;
+
+        for (int run = 0; run < repeats; run++) {
+            std::copy(input.left.begin(), input.left.begin() + numSamples, left.begin());
+            std::copy(input.right.begin(), input.right.begin() + numSamples, right.begin());
+
+            CompressorEngine engine;
+            for (int i = 0; i < CompressorEngine::crossover1; i++)
+                engine.setParameter((CompressorEngine::Parameter) i, regime.parameters[i]);
+            engine.setParameter(CompressorEngine::ecoInterval, (float) interval);
+            engine.prepare(sampleRate, blockSize);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int pos = 0; pos < numSamples; pos += blockSize)
+                engine.process(left.data() + pos, right.data() + pos, std::min(blockSize, numSamples - pos));
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, ns/numSamples);
+        }
+        return best;
+    }
+
+    // reads back the one-result-per-line JSON this tool writes
+    bool readBaseline(const std::string& path, std::vector<Result>& results) {
+        std::ifstream file(path);
+        if (!file)
+            return false;
+
+        auto field = [](const std::string& line, const std::string& name) {
+            const size_t pos = line.find("\"" + name + "\":");
+            if (pos == std::string::npos)
+                return std::string();
+            size_t start = line.find_first_not_of(" \"", pos + name.size() + 3);
+            size_t end = line.find_first_of(",\"}", start);
+            return line.substr(start, end - start);
+        };
+
+        for (std::string line; std::getline(file, line);) {
+            if (line.find("\"nsPerSample\"") == std::string::npos)
+                continue;
+            Result r;
+            r.input = field(line, "input");
+            r.regime = field(line, "regime");
+            r.precision = field(line, "precision");
+            if (r.precision.empty())
+                r.precision = "float"; // written before double precision was timed
+            r.fastPath = field(line, "fastPath") != "false";
+            r.sampleRate = std::atof(field(line, "sampleRate").c_str());
+            r.blockSize = std::atoi(field(line, "blockSize").c_str());
+            r.nsPerSample = std::atof(field(line, "nsPerSample").c_str());
+            r.samplesPerSec = std::atof(field(line, "samplesPerSec").c_str());
+            results.push_back(r);
+        }
+        return true;
+    }
+
+    void writeJson(const std::string& path, const std::vector<Result>& results) {
+        std::ofstream file(path);
+        file << "{\n  \"isa\": \"" << CompressorKernel::getIsaName(CompressorKernel::activeIsa()) << "\",\n";
+        file << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            file << "    { \"input\": \"" << r.input << "\", \"regime\": \"" << r.regime
+                 << "\", \"precision\": \"" << r.precision << "\", \"fastPath\": " << (r.fastPath ? "true" : "false")
+                 << ", \"sampleRate\": " << r.sampleRate << ", \"blockSize\": " << r.blockSize
+                 << ", \"nsPerSample\": " << r.nsPerSample << ", \"samplesPerSec\": " << r.samplesPerSec
+                 << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        file << "  ]\n}\n";
+    }
+
+    void printUsage() {
+        std::printf("usage: Benchmark [options]\n"
+                    "  --files DIR          folder with the test WAVs (default: test_files)\n"
+                    "  --seconds S          audio per case (default: 2)\n"
+                    "  --repeats N          runs per case, the fastest counts (default: 3)\n"
+                    "  --isa NAME           scalar, sse2, avx2, avx512 or neon (default: best)\n"
+                    "  --precision P        float, double or both (default: float)\n"
+                    "  --fast-path M        on, off (every block through the full loop) or both\n"
+                    "                       (default: on)\n"
+                    "  --json FILE          write results as JSON\n"
+                    "  --baseline FILE      compare against a JSON file written by --json\n"
+                    "  --tolerance PCT      slowdown that counts as a regression (default: 10)\n"
+                    "  --quick              only block sizes 16, 512, 4096 at 48 kHz\n"
+                    "  --batch N            time N single band compressors as N engines and as\n"
+                    "                       one CompressorBatch (music, 48 kHz), nothing else\n"
+                    "  --eco                time eco mode (4, 8, 16, 32 samples per gain update)\n"
+                    "                       against the per-sample engine and print its error\n"
+                    "                       (vocal and music, 48 kHz), nothing else\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string filesDir = "test_files";
+    std::string jsonPath, baselinePath;
+    double seconds = 2;
+    int repeats = 3;
+    double tolerance = 10;
+    bool quick = false;
+    int batchInstances = 0;
+    bool eco = false;
+    std::vector<std::string> precisions = { "float" };
+    std::vector<bool> fastPathModes = { true };
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--files" && hasValue) {
+            filesDir = argv[++i];
+        } else if (arg == "--seconds" && hasValue) {
+            seconds = std::atof(argv[++i]);
+        } else if (arg == "--repeats" && hasValue) {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--isa" && hasValue) {
+            const std::string name = argv[++i];
+            const CompressorKernel::Isa isas[] = { CompressorKernel::Isa::scalar, CompressorKernel::Isa::sse2,
+                CompressorKernel::Isa::avx2, CompressorKernel::Isa::avx512, CompressorKernel::Isa::neon };
+            const char* names[] = { "scalar", "sse2", "avx2", "avx512", "neon" };
+            for (int k = 0; k < 5; k++)
+                if (name == names[k])
+                    CompressorKernel::setIsa(isas[k]);
+        } else if (arg == "--precision" && hasValue) {
+            const std::string name = argv[++i];
+            if (name == "both")
+                precisions = { "float", "double" };
+            else if (name == "float" || name == "double")
+                precisions = { name };
+            else {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--fast-path" && hasValue) {
+            const std::string mode = argv[++i];
+            if (mode == "both")
+                fastPathModes = { true, false };
+            else if (mode == "on" || mode == "off")
+                fastPathModes = { mode == "on" };
+            else {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            tolerance = std::atof(argv[++i]);
+        } else if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--batch" && hasValue) {
+            batchInstances = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--eco") {
+            eco = true;
+        } else {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::vector<Input> inputs;
+    for (const char* name : { "vocal_no_compression", "music_no_compression" }) {
+        WavFile wav;
+        std::string error;
+        if (!readWavFile(filesDir + "/" + name + ".wav", wav, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        Input input;
+        input.name = name;
+        input.left = wav.channels[0];
+        input.right = wav.numChannels > 1 ? wav.channels[1] : wav.channels[0];
+        inputs.push_back(std::move(input));
+    }
+    // digital silence, where the fast paths skip nearly everything
+    Input silence;
+    silence.name = "silence";
+    silence.left.assign(inputs[0].left.size(), 0.0f);
+    silence.right = silence.left;
+    inputs.push_back(std::move(silence));
+
+    std::printf("kernel: %s\n", CompressorKernel::getIsaName(CompressorKernel::activeIsa()));
+
+    if (batchInstances > 0) {
+        const Input& music = inputs[1];
+        const double fs = 48000;
+        const int numSamples = (int) std::min<double>(seconds*fs, music.left.size());
+        std::printf("%d compressors, music, 48 kHz, ns per stereo sample and compressor:\n", batchInstances);
+        std::printf("%-16s %6s %10s %10s %8s\n", "regime", "block", "engines", "batch", "speedup");
+        for (const Regime& regime : regimes) {
+            // the settings a batch has
+            if (regime.parameters[CompressorEngine::lookahead] != 0 || regime.parameters[CompressorEngine::truePeak] != 0
+                || regime.parameters[CompressorEngine::numBands] != 1)
+                continue;
+            for (int blockSize : { 64, 512 }) {
+                double engineNs, batchNs;
+                timeBatch(music, regime, fs, blockSize, numSamples, batchInstances, repeats, engineNs, batchNs);
+                std::printf("%-16s %6d %10.2f %10.2f %7.2fx\n", regime.name, blockSize, engineNs, batchNs,
+                            engineNs/batchNs);
+            }
+        }
+        return 0;
+    }
+    if (eco) {
+        // the error is the eco render minus the per-sample one, as
+        // GoldenCheck measures it: largest and RMS over both channels
+        const double fs = 48000;
+        std::printf("48 kHz, ns per stereo sample, error against the per-sample render:\n");
+        std::printf("%-22s %-16s %6s %4s %10s %8s %10s %10s\n", "input", "regime", "block", "eco", "ns/sample",
+                    "speedup", "max dBFS", "rms dBFS");
+        for (int k = 0; k < 2; k++) {
+            const Input& input = inputs[k];
+            const int numSamples = (int) std::min<double>(seconds*fs, input.left.size());
+            for (const Regime& regime : regimes) {
+                // multiband always runs per sample
+                if (regime.parameters[CompressorEngine::numBands] != 1)
+                    continue;
+                for (int blockSize : { 64, 512 }) {
+                    std::vector<float> referenceLeft, referenceRight, left, right;
+                    const double referenceNs = timeEco(input, regime, fs, blockSize, numSamples, repeats, 1,
+                                                       referenceLeft, referenceRight);
+                    std::printf("%-22s %-16s %6d %4s %10.2f\n", input.name.c_str(), regime.name, blockSize, "off",
+                                referenceNs);
+                    for (int interval : { 4, 8, 16, 32 }) {
+                        const double ns = timeEco(input, regime, fs, blockSize, numSamples, repeats, interval,
+                                                  left, right);
+                        double maxError = 0;
+                        double sumSquares = 0;
+                        for (int i = 0; i < numSamples; i++) {
+                            const double errors[] = { left[i] - referenceLeft[i], right[i] - referenceRight[i] };
+                            for (double e : errors) {
+                                maxError = std::max(maxError, std::abs(e));
+                                sumSquares += e*e;
+                            }
+                        }
+                        std::printf("%-22s %-16s %6d %4d %10.2f %7.2fx %10.1f %10.1f\n", input.name.c_str(),
+                                    regime.name, blockSize, interval, ns, referenceNs/ns,
+                                    20*std::log10(std::max(maxError, 1.0e-10)),
+                                    10*std::log10(std::max(sumSquares/(2*numSamples), 1.0e-20)));
+                    }
+                }
+            }
+        }
+        return 0;
+    }
+    std::printf("%-22s %-16s %-6s %-5s %8s %6s %10s %12s %7s %7s\n", "input", "regime", "type", "fast", "fs", "block",
+                "ns/sample", "samples/s", "quiet%", "silent%");
+
+    std::vector<Result> results;
+    for (const Input& input : inputs) {
+        for (const Regime& regime : regimes) {
+            for (double fs : sampleRates) {
+                if (quick && fs != 48000)
+                    continue;
+                for (int blockSize : blockSizes) {
+                    if (quick && blockSize != 16 && blockSize != 512 && blockSize != 4096)
+                        continue;
+                    const int numSamples = (int) std::min<double>(seconds*fs, input.left.size());
+                    for (const std::string& precision : precisions) {
+                        for (bool fastPath : fastPathModes) {
+                            Result r;
+                            r.input = input.name;
+                            r.regime = regime.name;
+                            r.precision = precision;
+                            r.fastPath = fastPath;
+                            r.sampleRate = fs;
+                            r.blockSize = blockSize;
+                            r.nsPerSample = precision == "double"
+                                ? timeCase<double>(input, regime, fs, blockSize, numSamples, repeats, fastPath, r.pathShare)
+                                : timeCase<float>(input, regime, fs, blockSize, numSamples, repeats, fastPath, r.pathShare);
+                            r.samplesPerSec = 1e9/r.nsPerSample;
+                            results.push_back(r);
+                            std::printf("%-22s %-16s %-6s %-5s %8.0f %6d %10.2f %12.4g %7.1f %7.1f\n", r.input.c_str(),
+                                        r.regime.c_str(), r.precision.c_str(), fastPath ? "on" : "off", r.sampleRate,
+                                        r.blockSize, r.nsPerSample, r.samplesPerSec,
+                                        100*r.pathShare[(int) CompressorKernel::Path::quiet],
+                                        100*r.pathShare[(int) CompressorKernel::Path::silent]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // the same case with something else changed, if it was timed
+    auto findOther = [&results](const Result& r, const std::string& precision, bool fastPath) -> const Result* {
+        for (const Result& other : results) {
+            if (other.input == r.input && other.regime == r.regime && other.sampleRate == r.sampleRate
+                && other.blockSize == r.blockSize && other.precision == precision && other.fastPath == fastPath)
+                return &other;
+        }
+        return nullptr;
+    };
+
+    // cost of double precision, per regime and overall
+    if (precisions.size() == 2) {
+        std::printf("\ndouble vs float:\n");
+        double totalLogRatio = 0;
+        int totalCases = 0;
+        for (const Regime& regime : regimes) {
+            double logRatio = 0;
+            int cases = 0;
+            for (const Result& r : results) {
+                const Result* other = findOther(r, "double", r.fastPath);
+                if (r.regime != regime.name || r.precision != "float" || other == nullptr)
+                    continue;
+                logRatio += std::log(other->nsPerSample/r.nsPerSample);
+                cases++;
+            }
+            std::printf("  %-16s %+.1f%%\n", regime.name, 100.0*(std::exp(logRatio/cases) - 1.0));
+            totalLogRatio += logRatio;
+            totalCases += cases;
+        }
+        std::printf("  geometric mean   %+.1f%%\n", 100.0*(std::exp(totalLogRatio/totalCases) - 1.0));
+    }
+
+    // what the fast paths save, per input and regime: where the samples
+    // went, and the time with them against every block in the full loop
+    if (fastPathModes.size() == 2) {
+        std::printf("\nfast paths vs full loop (geometric mean ns/sample):\n");
+        std::printf("  %-22s %-16s %7s %7s %7s %10s %10s %8s\n", "input", "regime", "full%", "quiet%", "silent%",
+                    "full loop", "fast paths", "change");
+        for (const Input& input : inputs) {
+            for (const Regime& regime : regimes) {
+                double logFast = 0, logFull = 0;
+                double share[CompressorKernel::numPaths] = {};
+                int cases = 0;
+                for (const Result& r : results) {
+                    const Result* full = findOther(r, r.precision, false);
+                    if (r.input != input.name || r.regime != regime.name || !r.fastPath || full == nullptr)
+                        continue;
+                    logFast += std::log(r.nsPerSample);
+                    logFull += std::log(full->nsPerSample);
+                    for (int p = 0; p < CompressorKernel::numPaths; p++)
+                        share[p] += r.pathShare[p];
+                    cases++;
+                }
+                if (cases == 0)
+                    continue;
+                const double fast = std::exp(logFast/cases);
+                const double full = std::exp(logFull/cases);
+                std::printf("  %-22s %-16s %7.1f %7.1f %7.1f %10.2f %10.2f %+7.1f%%\n", input.name.c_str(), regime.name,
+                            100*share[0]/cases, 100*share[1]/cases, 100*share[2]/cases, full, fast,
+                            100.0*(fast/full - 1.0));
+            }
+        }
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, results);
+
+    if (baselinePath.empty())
+        return 0;
+
+    std::vector<Result> baseline;
+    if (!readBaseline(baselinePath, baseline)) {
+        std::fprintf(stderr, "cannot read %s\n", baselinePath.c_str());
+        return 1;
+    }
+
+    std::printf("\ncompared to %s (regression = more than %.0f%% slower):\n", baselinePath.c_str(), tolerance);
+    int regressions = 0, compared = 0;
+    double logRatioSum = 0;
+    for (const Result& r : results) {
+        auto old = std::find_if(baseline.begin(), baseline.end(),
+                                [&](const Result& b) { return getKey(b) == getKey(r); });
+        if (old == baseline.end())
+            continue;
+        const double change = 100.0*(r.nsPerSample/old->nsPerSample - 1.0);
+        logRatioSum += std::log(r.nsPerSample/old->nsPerSample);
+        compared++;
+        if (change > tolerance) {
+            regressions++;
+            std::printf("  REGRESSION %-40s %8.2f -> %8.2f ns/sample (%+.1f%%)\n",
+                        getKey(r).c_str(), old->nsPerSample, r.nsPerSample, change);
+        }
+    }
+    const double geomean = compared > 0 ? 100.0*(std::exp(logRatioSum/compared) - 1.0) : 0;
+    std::printf("  %d cases compared, %d regressions, geometric mean change %+.1f%%\n",
+                compared, regressions, geomean);
+    return regressions == 0 ? 0 : 2;
+}
@@ -0,0 +1,510 @@
+/*
+  ==============================================================================
+
+    GoldenCheck.cpp
+    Created: 17 Oct 2026 5:40:12pm
+    Author:  Coleman Jenkins
+
+    Renders test_files/ through CompressorEngine with the parameter sets
+    in test_files/golden_cases.txt and either records the outputs as
+    reference WAVs (--record DIR) or compares against references recorded
+    earlier (--compare DIR), sample by sample. Each case reports its
+    largest and RMS error in dB full scale and fails past the tolerances,
+    so a change to the processing (SIMD, approximations, reordered maths)
+    shows exactly how far the audio moved.
+
+    The renders are too big to commit, so test_files/golden_manifest.txt
+    stands in for them: per case, ISA and precision, a hash of the render,
+    its peak and RMS level and, against the scalar float render, its
+    largest and RMS error. --write-manifest FILE renders every ISA the
+    machine has in float and double to write it, --check-manifest FILE
+    passes a case whose hash matches (exact) or, when it doesn't (another
+    compiler, maths library or ISA), whose peak and RMS are within the
+    tolerances of the scalar render's in the same precision, which any
+    render within them of that render is.
+
+    A case is one line: a name, the input file and any number of
+    key=value settings, where a key is a parameter id (as in
+    CompressorEngine.cpp) or one of
+        block=N           host block size (default 512)
+        sidechain=FILE    the detector listens to FILE
+        gainRamp=exp      exponential pre/post gain glides
+        maxError=DB       tolerances for this case instead of the
+        rmsError=DB       --max-error and --rms-error ones
+
+  ==============================================================================
+*/
+
+#include "../Source/CompressorEngine.h"
+#include "WavFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Case {
+        std::string name;
+        std::string input;
+        std::string sidechain;  // empty: none
+        float parameters[CompressorEngine::numParameters];
+        int blockSize = 512;
+        bool exponentialGainRamp = false;
+        double maxErrorDb = 0;  // 0: the command line's
+        double rmsErrorDb = 0;
+    };
+
+    struct Comparison {
+        double maxError = 0;    // linear, largest difference of any sample
+        int64_t maxErrorFrame = 0;
+        double rmsError = 0;    // linear, over all samples
+    };
+
+    // --isa names
+    struct IsaOption {
+        const char* name;
+        CompressorKernel::Isa isa;
+    };
+    const IsaOption isaOptions[] = {
+        { "scalar", CompressorKernel::Isa::scalar },
+        { "sse2", CompressorKernel::Isa::sse2 },
+        { "avx2", CompressorKernel::Isa::avx2 },
+        { "avx512", CompressorKernel::Isa::avx512 },
+        { "neon", CompressorKernel::Isa::neon }
+    };
+
+    const char* getIsaOptionName(CompressorKernel::Isa isa) {
+        for (const IsaOption& option : isaOptions)
+            if (option.isa == isa)
+                return option.name;
+        return "unknown";
+    }
+
+    // a golden_manifest.txt line
+    struct ManifestEntry {
+        std::string name, isa, precision;
+        uint64_t hash = 0;
+        double peak = 0;        // linear
+        double rms = 0;
+        double maxErrorDb = 0;  // against the scalar float render
+        double rmsErrorDb = 0;
+    };
+
+    // FNV-1a over the samples' bits, left then right
+    uint64_t hashRender(const WavFile& output) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const std::vector<float>& channel : output.channels) {
+            const unsigned char* bytes = (const unsigned char*) channel.data();
+            for (size_t i = 0; i < channel.size()*sizeof(float); i++)
+                hash = (hash ^ bytes[i])*0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    void getLevels(const WavFile& output, double& peak, double& rms) {
+        double sumSquares = 0;
+        peak = 0;
+        for (const std::vector<float>& channel : output.channels) {
+            for (float x : channel) {
+                peak = std::max(peak, (double) std::abs(x));
+                sumSquares += (double) x*x;
+            }
+        }
+        const size_t numSamples = output.channels.size()*output.channels[0].size();
+        rms = numSamples > 0 ? std::sqrt(sumSquares/numSamples) : 0;
+    }
+
+    bool readManifest(const std::string& path, std::vector<ManifestEntry>& entries, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        int lineNumber = 0;
+        for (std::string line; std::getline(file, line);) {
+            lineNumber++;
+            std::istringstream words(line);
+            ManifestEntry e;
+            std::string hash, maxError, rmsError;
+            if (!(words >> e.name) || e.name[0] == '#')
+                continue;
+            if (!(words >> e.isa >> e.precision >> hash >> e.peak >> e.rms >> maxError >> rmsError)) {
+                error = path + ":" + std::to_string(lineNumber) + ": expected case, isa, precision, hash, peak, rms, max and rms error";
+                return false;
+            }
+            e.hash = std::strtoull(hash.c_str(), nullptr, 16);
+            e.maxErrorDb = std::strtod(maxError.c_str(), nullptr);
+            e.rmsErrorDb = std::strtod(rmsError.c_str(), nullptr);
+            entries.push_back(e);
+        }
+        return true;
+    }
+
+    const ManifestEntry* findEntry(const std::vector<ManifestEntry>& entries, const std::string& name,
+                                   const std::string& isa, const std::string& precision) {
+        for (const ManifestEntry& e : entries)
+            if (e.name == name && e.isa == isa && e.precision == precision)
+                return &e;
+        return nullptr;
+    }
+
+    // -inf for no error at all
+    double toDb(double linear) {
+        return 20*std::log10(linear);
+    }
+
+    bool readCases(const std::string& path, std::vector<Case>& cases, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        int lineNumber = 0;
+        for (std::string line; std::getline(file, line);) {
+            lineNumber++;
+            std::istringstream words(line);
+            Case c;
+            if (!(words >> c.name) || c.name[0] == '#')
+                continue;
+            const std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+            if (!(words >> c.input)) {
+                error = where + "no input file";
+                return false;
+            }
+            for (int i = 0; i < CompressorEngine::numParameters; i++)
+                c.parameters[i] = CompressorEngine::getParameterDefault((CompressorEngine::Parameter) i);
+
+            for (std::string word; words >> word;) {
+                const size_t equals = word.find('=');
+                if (equals == std::string::npos) {
+                    error = where + "expected key=value, got " + word;
+                    return false;
+                }
+                const std::string key = word.substr(0, equals);
+                const std::string value = word.substr(equals + 1);
+                if (key == "block") {
+                    c.blockSize = std::max(1, std::atoi(value.c_str()));
+                } else if (key == "sidechain") {
+                    c.sidechain = value;
+                } else if (key == "gainRamp") {
+                    c.exponentialGainRamp = value == "exp";
+                } else if (key == "maxError") {
+                    c.maxErrorDb = std::atof(value.c_str());
+                } else if (key == "rmsError") {
+                    c.rmsErrorDb = std::atof(value.c_str());
+                } else {
+                    int param = 0;
+                    while (param < CompressorEngine::numParameters
+                           && key != CompressorEngine::getParameterId((CompressorEngine::Parameter) param))
+                        param++;
+                    if (param == CompressorEngine::numParameters) {
+                        error = where + "unknown setting " + key;
+                        return false;
+                    }
+                    c.parameters[param] = (float) std::atof(value.c_str());
+                }
+            }
+            cases.push_back(c);
+        }
+        return true;
+    }
+
+    // the whole input through the engine a block at a time, as a host
+    // (and BatchRender) would: mono as dual mono, then latency frames of
+    // silence to flush the lookahead, and the output moved back by the
+    // latency so it lines up with the input
+    template <typename Sample>
+    void render(const Case& c, const WavFile& input, const WavFile* sidechain, WavFile& output) {
+        CompressorEngine engine;
+        for (int i = 0; i < CompressorEngine::numParameters; i++)
+            engine.setParameter((CompressorEngine::Parameter) i, c.parameters[i]);
+        engine.setGainRampShape(c.exponentialGainRamp ? CompressorEngine::RampShape::exponential
+                                                      : CompressorEngine::RampShape::linear);
+        engine.prepare(input.sampleRate, c.blockSize);
+        const int latency = engine.getLatencySamples();
+        const int numFrames = input.getNumFrames();
+
+        // padded copies in the render precision
+        auto load = [numFrames, latency](const WavFile& wav, std::vector<Sample>& left, std::vector<Sample>& right) {
+            left.assign(numFrames + latency, 0);
+            right.assign(numFrames + latency, 0);
+            const int n = std::min(numFrames, wav.getNumFrames());
+            std::copy(wav.channels[0].begin(), wav.channels[0].begin() + n, left.begin());
+            std::copy(wav.channels.back().begin(), wav.channels.back().begin() + n, right.begin());
+        };
+        std::vector<Sample> left, right, keyLeft, keyRight;
+        load(input, left, right);
+        if (sidechain != nullptr)
+            load(*sidechain, keyLeft, keyRight);
+
+        for (int start = 0; start < numFrames + latency; start += c.blockSize) {
+            const int n = std::min(c.blockSize, numFrames + latency - start);
+            if (sidechain != nullptr)
+                engine.process(keyLeft.data() + start, keyRight.data() + start, left.data() + start, right.data() + start, n);
+            else
+                engine.process(left.data() + start, right.data() + start, n);
+        }
+
+        output = WavFile();
+        output.numChannels = 2;
+        output.sampleRate = input.sampleRate;
+        output.bitsPerSample = 32;
+        output.isFloat = true;
+        output.channels.assign(2, std::vector<float>(numFrames));
+        std::copy(left.begin() + latency, left.end(), output.channels[0].begin());
+        std::copy(right.begin() + latency, right.end(), output.channels[1].begin());
+    }
+
+    Comparison compare(const WavFile& output, const WavFile& reference) {
+        Comparison result;
+        double sumSquares = 0;
+        const int numFrames = output.getNumFrames();
+        for (int ch = 0; ch < 2; ch++) {
+            for (int i = 0; i < numFrames; i++) {
+                const double error = std::abs((double) output.channels[ch][i] - reference.channels[ch][i]);
+                sumSquares += error*error;
+                if (error > result.maxError) {
+                    result.maxError = error;
+                    result.maxErrorFrame = i;
+                }
+            }
+        }
+        result.rmsError = numFrames > 0 ? std::sqrt(sumSquares/(2.0*numFrames)) : 0;
+        return result;
+    }
+
+    void printUsage() {
+        std::printf("usage: GoldenCheck --record DIR | --compare DIR | --write-manifest FILE\n"
+                    "                   | --check-manifest FILE [options]\n"
+                    "  --record DIR       write each case's output to DIR/<case>.wav\n"
+                    "  --compare DIR      compare each case's output with DIR/<case>.wav\n"
+                    "  --write-manifest FILE   hash every ISA's float and double renders into FILE\n"
+                    "  --check-manifest FILE   check the renders against FILE's hashes and levels\n"
+                    "  --cases FILE       case list (default: test_files/golden_cases.txt)\n"
+                    "  --files DIR        where the inputs are (default: test_files)\n"
+                    "  --only NAME        just the cases whose name contains NAME\n"
+                    "  --max-error DB     largest sample error allowed, dBFS (default: -90)\n"
+                    "  --rms-error DB     RMS error allowed, dBFS (default: -110)\n"
+                    "  --isa NAME         scalar, sse2, avx2, avx512 or neon (default: best)\n"
+                    "  --precision P      render with float or double buffers (default: float)\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string recordDir, compareDir, writeManifestPath, checkManifestPath;
+    std::string casesPath = "test_files/golden_cases.txt";
+    std::string filesDir = "test_files";
+    std::string only;
+    double maxErrorDb = -90;   // passes float rounding differences, e.g. another ISA
+    double rmsErrorDb = -110;
+    bool doublePrecision = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--record" && hasValue) {
+            recordDir = argv[++i];
+        } else if (arg == "--compare" && hasValue) {
+            compareDir = argv[++i];
+        } else if (arg == "--write-manifest" && hasValue) {
+            writeManifestPath = argv[++i];
+        } else if (arg == "--check-manifest" && hasValue) {
+            checkManifestPath = argv[++i];
+        } else if (arg == "--cases" && hasValue) {
+            casesPath = argv[++i];
+        } else if (arg == "--files" && hasValue) {
+            filesDir = argv[++i];
+        } else if (arg == "--only" && hasValue) {
+            only = argv[++i];
+        } else if (arg == "--max-error" && hasValue) {
+            maxErrorDb = std::atof(argv[++i]);
+        } else if (arg == "--rms-error" && hasValue) {
+            rmsErrorDb = std::atof(argv[++i]);
+        } else if (arg == "--isa" && hasValue) {
+            const std::string name = argv[++i];
+            for (const IsaOption& option : isaOptions)
+                if (name == option.name)
+                    CompressorKernel::setIsa(option.isa);
+        } else if (arg == "--precision" && hasValue) {
+            const std::string name = argv[++i];
+            if (name != "float" && name != "double") {
+                printUsage();
+                return 1;
+            }
+            doublePrecision = name == "double";
+        } else {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+    const int numModes = !recordDir.empty() + !compareDir.empty() + !writeManifestPath.empty() + !checkManifestPath.empty();
+    if (numModes != 1) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Case> cases;
+    std::string error;
+    if (!readCases(casesPath, cases, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (!recordDir.empty()) {
+        std::error_code created;
+        std::filesystem::create_directories(recordDir, created);
+        if (created) {
+            std::fprintf(stderr, "cannot create %s: %s\n", recordDir.c_str(), created.message().c_str());
+            return 1;
+        }
+    }
+    std::vector<ManifestEntry> manifest;
+    if (!checkManifestPath.empty() && !readManifest(checkManifestPath, manifest, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::FILE* manifestFile = nullptr;
+    if (!writeManifestPath.empty()) {
+        manifestFile = std::fopen(writeManifestPath.c_str(), "w");
+        if (manifestFile == nullptr) {
+            std::fprintf(stderr, "cannot create %s\n", writeManifestPath.c_str());
+            return 1;
+        }
+        std::fprintf(manifestFile, "# GoldenCheck --write-manifest: each case rendered with every ISA, in\n"
+                                   "# float and double buffers. Peak and RMS are linear, the errors are\n"
+                                   "# dBFS against the scalar float render\n"
+                                   "# %-22s %-7s %-9s %-16s %-20s %-22s %9s %9s\n",
+                     "case", "isa", "precision", "hash", "peak", "rms", "max err", "rms err");
+    }
+    const CompressorKernel::Isa chosenIsa = CompressorKernel::activeIsa();
+    const char* precisionName = doublePrecision ? "double" : "float";
+
+    std::printf("kernel: %s, %s buffers\n", CompressorKernel::getIsaName(CompressorKernel::activeIsa()),
+                doublePrecision ? "double" : "float");
+    if (!compareDir.empty())
+        std::printf("%-24s %12s %10s %10s %12s %10s  %s\n", "case", "max error", "dBFS", "at (s)",
+                    "rms error", "dBFS", "result");
+    if (!checkManifestPath.empty())
+        std::printf("%-24s %12s %10s %12s %10s  %s\n", "case", "peak diff", "dBFS", "rms diff", "dBFS", "result");
+
+    int numCases = 0;
+    int failed = 0;
+    for (const Case& c : cases) {
+        if (c.name.find(only) == std::string::npos)
+            continue;
+        numCases++;
+
+        WavFile input, sidechain, output;
+        if (!readWavFile(filesDir + "/" + c.input, input, error)
+            || (!c.sidechain.empty() && !readWavFile(filesDir + "/" + c.sidechain, sidechain, error))) {
+            std::printf("%-24s FAILED: %s\n", c.name.c_str(), error.c_str());
+            failed++;
+            continue;
+        }
+        const WavFile* key = c.sidechain.empty() ? nullptr : &sidechain;
+        const double allowedMax = c.maxErrorDb != 0 ? c.maxErrorDb : maxErrorDb;
+        const double allowedRms = c.rmsErrorDb != 0 ? c.rmsErrorDb : rmsErrorDb;
+
+        if (manifestFile != nullptr) {
+            // the scalar float render first, the others measured against it
+            WavFile reference;
+            for (const IsaOption& option : isaOptions) {
+                CompressorKernel::setIsa(option.isa);
+                if (CompressorKernel::activeIsa() != option.isa)
+                    continue;
+                for (int precision = 0; precision < 2; precision++) {
+                    if (precision == 0)
+                        render<float>(c, input, key, output);
+                    else
+                        render<double>(c, input, key, output);
+                    if (option.isa == CompressorKernel::Isa::scalar && precision == 0)
+                        reference = output;
+                    const Comparison result = compare(output, reference);
+                    double peak, rms;
+                    getLevels(output, peak, rms);
+                    std::fprintf(manifestFile, "%-24s %-7s %-9s %016llx %-20.17g %-22.17g %9.1f %9.1f\n",
+                                 c.name.c_str(), option.name, precision == 0 ? "float" : "double",
+                                 (unsigned long long) hashRender(output), peak, rms,
+                                 toDb(result.maxError), toDb(result.rmsError));
+                }
+            }
+            CompressorKernel::setIsa(chosenIsa);
+            std::printf("%-24s written\n", c.name.c_str());
+            continue;
+        }
+
+        if (doublePrecision)
+            render<double>(c, input, key, output);
+        else
+            render<float>(c, input, key, output);
+
+        if (!checkManifestPath.empty()) {
+            // exact on a hash match, otherwise the levels of a render
+            // within the tolerances are within them too
+            const ManifestEntry* same = findEntry(manifest, c.name, getIsaOptionName(chosenIsa), precisionName);
+            const ManifestEntry* reference = findEntry(manifest, c.name, "scalar", precisionName);
+            if (reference == nullptr) {
+                std::printf("%-24s FAILED: not in %s\n", c.name.c_str(), checkManifestPath.c_str());
+                failed++;
+                continue;
+            }
+            double peak, rms;
+            getLevels(output, peak, rms);
+            const bool exact = same != nullptr && same->hash == hashRender(output);
+            const double peakDiff = std::abs(peak - reference->peak);
+            const double rmsDiff = std::abs(rms - reference->rms);
+            const bool pass = exact || (toDb(peakDiff) <= allowedMax && toDb(rmsDiff) <= allowedRms);
+            if (!pass)
+                failed++;
+            std::printf("%-24s %12.3g %10.1f %12.3g %10.1f  %s\n", c.name.c_str(),
+                        peakDiff, toDb(peakDiff), rmsDiff, toDb(rmsDiff),
+                        exact ? "exact" : pass ? "ok" : "FAILED");
+            continue;
+        }
+
+        const std::string referencePath = (recordDir.empty() ? compareDir : recordDir) + "/" + c.name + ".wav";
+        if (!recordDir.empty()) {
+            if (!writeWavFile(referencePath, output, error)) {
+                std::printf("%-24s FAILED: %s\n", c.name.c_str(), error.c_str());
+                failed++;
+            } else {
+                std::printf("%-24s recorded %s\n", c.name.c_str(), referencePath.c_str());
+            }
+            continue;
+        }
+
+        WavFile reference;
+        if (!readWavFile(referencePath, reference, error)) {
+            std::printf("%-24s FAILED: %s\n", c.name.c_str(), error.c_str());
+            failed++;
+            continue;
+        }
+        if (reference.numChannels != 2 || reference.getNumFrames() != output.getNumFrames()) {
+            std::printf("%-24s FAILED: the reference is %d frames of %d channels, the render %d of 2\n",
+                        c.name.c_str(), reference.getNumFrames(), reference.numChannels, output.getNumFrames());
+            failed++;
+            continue;
+        }
+
+        const Comparison result = compare(output, reference);
+        const bool pass = toDb(result.maxError) <= allowedMax && toDb(result.rmsError) <= allowedRms;
+        if (!pass)
+            failed++;
+        std::printf("%-24s %12.3g %10.1f %10.3f %12.3g %10.1f  %s\n", c.name.c_str(),
+                    result.maxError, toDb(result.maxError), result.maxErrorFrame/input.sampleRate,
+                    result.rmsError, toDb(result.rmsError),
+                    pass ? (result.maxError == 0 ? "exact" : "ok") : "FAILED");
+    }
+
+    if (manifestFile != nullptr)
+        std::fclose(manifestFile);
+    std::printf("%d cases, %d failed\n", numCases, failed);
+    return failed == 0 ? 0 : 1;
+}
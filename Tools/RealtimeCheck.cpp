@@ -0,0 +1,545 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+    Created: 17 Oct 2026 4:12:37pm
+    Author:  Coleman Jenkins
+
+    Checks that processBlock stays real-time safe (Linux only). The
+    harness replaces malloc and friends, pthread mutex locking and the
+    common blocking syscalls (file I/O, mmap, sleeping, yielding) for the
+    whole process; they pass straight through, except while the audio
+    thread is inside a block, where the first call prints what it was with
+    a stack trace and exits with 1.
+
+    The blocks run the JUCE free part of processSamples in PluginProcessor
+    (parameter hand-over, compressor, latency, telemetry queue, load
+    monitor) through prepareToPlay and thousands of processBlock calls per
+    case, over sample rates, host buffer sizes, float/double and channel
+    layouts from mono to 16 channels, with random
+    block lengths, input levels (silence and near silence included),
+    sidechain layouts and parameter changes between and within blocks.
+
+    Only calls made through the dynamic linker are seen: glibc's calls
+    to its own functions are not, so printf() is caught when its buffer
+    gets allocated or by the malloc it does, not by the write it ends in.
+
+  ==============================================================================
+*/
+
+#include "../Source/MultichannelCompressor.h"
+#include "../Source/LoadMonitor.h"
+#include "../Source/SpscQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+//==============================================================================
+// the watchdog
+
+namespace
+{
+    // set while this thread is inside a block
+    thread_local bool inAudioBlock = false;
+
+    // what the current block is, for the report
+    const char* caseName = "";
+    long blockIndex = 0;
+    unsigned long seed = 0;
+
+    void writeString(const char* text) {
+        syscall(SYS_write, 2, text, std::strlen(text));
+    }
+
+    // reports the first call in a block and exits. Nothing here allocates:
+    // the numbers are formatted by hand and backtrace() was warmed up
+    // before the first block
+    void violation(const char* what) {
+        if (!inAudioBlock)
+            return;
+        inAudioBlock = false;
+
+        char number[32];
+        auto format = [&number](unsigned long value) {
+            char* end = number + sizeof(number) - 1;
+            *end = 0;
+            do {
+                *--end = (char) ('0' + value%10);
+                value /= 10;
+            } while (value > 0);
+            return end;
+        };
+        writeString("\nRealtimeCheck: ");
+        writeString(what);
+        writeString(" in processBlock, block ");
+        writeString(format((unsigned long) blockIndex));
+        writeString(" of ");
+        writeString(caseName);
+        writeString(" (--seed ");
+        writeString(format(seed));
+        writeString(")\n");
+
+        void* frames[64];
+        const int numFrames = backtrace(frames, 64);
+        backtrace_symbols_fd(frames, numFrames, 2);
+        writeString("(addr2line -Cfe <this program> <+0x offset> names the frames without a symbol)\n");
+        _exit(1);
+    }
+
+    struct AudioBlockScope {
+        AudioBlockScope() { inAudioBlock = true; }
+        ~AudioBlockScope() { inAudioBlock = false; }
+    };
+}
+
+extern "C" {
+    // glibc's own entry points, which the replacements below pass on to
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* pointer);
+
+    void* malloc(size_t size) {
+        violation("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) {
+        violation("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) {
+        violation("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer) {
+        if (pointer != nullptr)
+            violation("free");
+        __libc_free(pointer);
+    }
+
+    void* memalign(size_t alignment, size_t size) {
+        violation("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) {
+        violation("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size) {
+        violation("posix_memalign");
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+        *pointer = __libc_memalign(alignment, size);
+        return *pointer != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    // looked up on first use, which main() makes before the first block
+    using MutexFunction = int (*)(pthread_mutex_t*);
+    MutexFunction nextMutexLock = nullptr;
+    MutexFunction nextMutexTrylock = nullptr;
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) {
+        violation("pthread_mutex_lock");
+        if (nextMutexLock == nullptr)
+            nextMutexLock = (MutexFunction) dlsym(RTLD_NEXT, "pthread_mutex_lock");
+        return nextMutexLock(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t* mutex) {
+        violation("pthread_mutex_trylock");
+        if (nextMutexTrylock == nullptr)
+            nextMutexTrylock = (MutexFunction) dlsym(RTLD_NEXT, "pthread_mutex_trylock");
+        return nextMutexTrylock(mutex);
+    }
+
+    // the syscalls are made directly, so they need no lookup
+    int open(const char* path, int flags, ...) {
+        violation("open");
+        va_list args;
+        va_start(args, flags);
+        const mode_t mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(args, mode_t) : 0;
+        va_end(args);
+        return (int) syscall(SYS_openat, AT_FDCWD, path, flags, mode);
+    }
+
+    int open64(const char* path, int flags, ...) {
+        violation("open64");
+        va_list args;
+        va_start(args, flags);
+        const mode_t mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(args, mode_t) : 0;
+        va_end(args);
+        return (int) syscall(SYS_openat, AT_FDCWD, path, flags, mode);
+    }
+
+    int openat(int dir, const char* path, int flags, ...) {
+        violation("openat");
+        va_list args;
+        va_start(args, flags);
+        const mode_t mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(args, mode_t) : 0;
+        va_end(args);
+        return (int) syscall(SYS_openat, dir, path, flags, mode);
+    }
+
+    int close(int fd) {
+        violation("close");
+        return (int) syscall(SYS_close, fd);
+    }
+
+    ssize_t read(int fd, void* buffer, size_t size) {
+        violation("read");
+        return syscall(SYS_read, fd, buffer, size);
+    }
+
+    ssize_t write(int fd, const void* buffer, size_t size) {
+        violation("write");
+        return syscall(SYS_write, fd, buffer, size);
+    }
+
+    void* mmap(void* address, size_t length, int protection, int flags, int fd, off_t offset) {
+        violation("mmap");
+        return (void*) syscall(SYS_mmap, address, length, protection, flags, fd, offset);
+    }
+
+    void* mmap64(void* address, size_t length, int protection, int flags, int fd, off_t offset) {
+        violation("mmap64");
+        return (void*) syscall(SYS_mmap, address, length, protection, flags, fd, offset);
+    }
+
+    int munmap(void* address, size_t length) {
+        violation("munmap");
+        return (int) syscall(SYS_munmap, address, length);
+    }
+
+    int clock_nanosleep(clockid_t clock, int flags, const struct timespec* request, struct timespec* remaining) {
+        violation("clock_nanosleep");
+        return syscall(SYS_clock_nanosleep, clock, flags, request, remaining) == 0 ? 0 : errno;
+    }
+
+    int nanosleep(const struct timespec* request, struct timespec* remaining) {
+        violation("nanosleep");
+        return (int) syscall(SYS_clock_nanosleep, CLOCK_REALTIME, 0, request, remaining);
+    }
+
+    int usleep(useconds_t microseconds) {
+        violation("usleep");
+        const struct timespec request = { (time_t) (microseconds/1000000), (long) (microseconds%1000000)*1000 };
+        return (int) syscall(SYS_clock_nanosleep, CLOCK_REALTIME, 0, &request, nullptr);
+    }
+
+    int sched_yield(void) {
+        violation("sched_yield");
+        return (int) syscall(SYS_sched_yield);
+    }
+}
+
+//==============================================================================
+// the processor
+
+namespace
+{
+    // PluginProcessor's BlockTelemetry
+    struct BlockTelemetry {
+        float inputPeak;
+        float inputRms;
+        float rmsEnvelopeDb;
+        float minGainLinear;
+        float maxGainLinear;
+        int numSamples;
+        int64_t samplePosition;
+        int64_t ticks;
+    };
+
+    // what PluginProcessor does around the engine, without JUCE: the
+    // parameters are atomic floats written by the host thread (as
+    // AudioParameterFloat's are) and handed over behind a changed flag
+    struct Processor {
+        MultichannelCompressor compressor;
+        std::atomic<float> parameters[CompressorEngine::numParameters];
+        std::atomic<bool> parametersChanged { false };
+        std::atomic<bool> telemetryEnabled { false };
+        SpscQueue<BlockTelemetry, 256> telemetryQueue;
+        LoadMonitor loadMonitor;
+        int latencySamples = 0;
+        int64_t samplePosition = 0;
+        double sampleRate = 44100;
+
+        Processor() {
+            for (int i = 0; i < CompressorEngine::numParameters; i++)
+                parameters[i] = CompressorEngine::getParameterDefault((CompressorEngine::Parameter) i);
+        }
+
+        void updateEngineParameters() {
+            for (int i = 0; i < CompressorEngine::numParameters; i++)
+                compressor.setParameter((CompressorEngine::Parameter) i, parameters[i].load(std::memory_order_relaxed));
+        }
+
+        // pairedWith as the bus layout gives it, or null
+        void prepareToPlay(double newSampleRate, int samplesPerBlock, int numChannels, const int* pairedWith) {
+            sampleRate = newSampleRate;
+            updateEngineParameters();
+            compressor.prepare(sampleRate, samplesPerBlock, numChannels, pairedWith);
+            latencySamples = compressor.getLatencySamples();
+            samplePosition = 0;
+        }
+
+        // numKeyChannels 0 (no sidechain bus), 1 or 2
+        template <typename Sample>
+        void processBlock(Sample* const* channels, const Sample* const* keyChannels,
+                          int numKeyChannels, int numSamples) {
+            loadMonitor.begin();
+            if (parametersChanged.exchange(false))
+                updateEngineParameters();
+
+            const bool publish = telemetryEnabled.load(std::memory_order_relaxed);
+            compressor.setStatsEnabled(publish);
+            if (numKeyChannels > 0)
+                compressor.process(keyChannels, numKeyChannels, channels, numSamples);
+            else
+                compressor.process(channels, numSamples);
+
+            if (compressor.getLatencySamples() != latencySamples)
+                latencySamples = compressor.getLatencySamples();
+
+            if (publish) {
+                auto& stats = compressor.getLastBlockStats();
+                telemetryQueue.push({stats.inputPeak, stats.inputRms, compressor.getRmsEnvelopeDb(),
+                                     stats.minGainLinear, stats.maxGainLinear, numSamples,
+                                     samplePosition, std::chrono::steady_clock::now().time_since_epoch().count()});
+            }
+            samplePosition += numSamples;
+            loadMonitor.end(numSamples, sampleRate);
+        }
+    };
+
+    // xorshift64*, the same numbers on every platform for a seed
+    struct Random {
+        uint64_t state;
+        explicit Random(uint64_t start) : state(start*2654435761u + 1) {}
+
+        uint64_t next() {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state*2685821657736338717ull;
+        }
+        double uniform() { return (next() >> 11)*(1.0/9007199254740992.0); }   // [0, 1)
+        int below(int n) { return (int) (uniform()*n); }
+        bool chance(double p) { return uniform() < p; }
+    };
+
+    // anywhere in the range, at its ends now and then
+    float randomValue(Random& random, CompressorEngine::Parameter param) {
+        const float min = CompressorEngine::getParameterMin(param);
+        const float max = CompressorEngine::getParameterMax(param);
+        if (random.chance(0.1))
+            return random.chance(0.5) ? min : max;
+        return min + (float) random.uniform()*(max - min);
+    }
+
+    // noise at a level that changes now and then, from digital silence
+    // to clipping, with the odd denormal block
+    template <typename Sample>
+    void fillInput(Random& random, Sample* const* channels, int numChannels, int numSamples, double& level) {
+        if (random.chance(0.05)) {
+            const int kind = random.below(4);
+            level = kind == 0 ? 0.0 : kind == 1 ? 1.0e-6 : kind == 2 ? 1.0e-40 : std::pow(10.0, -3.0*random.uniform());
+        }
+        for (int ch = 0; ch < numChannels; ch++)
+            for (int i = 0; i < numSamples; i++)
+                channels[ch][i] = (Sample) (level*(2*random.uniform() - 1));
+    }
+
+    struct Options {
+        long blocks = 2000;     // per case
+        unsigned long seed = 1;
+        std::string inject;     // a violation to commit on purpose
+    };
+
+    // one prepareToPlay and options.blocks processBlock calls
+    template <typename Sample>
+    void runCase(const Options& options, double sampleRate, int maxBlockSize, int numChannels, const char* name) {
+        caseName = name;
+        Random random(options.seed*1000003 + (uint64_t) sampleRate + (uint64_t) maxBlockSize*7 + sizeof(Sample)
+                      + (uint64_t) numChannels*131);
+        std::vector<std::vector<Sample>> buffers(numChannels + 2, std::vector<Sample>(maxBlockSize));
+        std::vector<Sample*> channels(numChannels + 2);
+        for (int ch = 0; ch < numChannels + 2; ch++)
+            channels[ch] = buffers[ch].data();
+        Sample* const* keyChannels = channels.data() + numChannels; // the sidechain bus after the main one
+        double level = 0.1;
+        double keyLevel = 0.1;
+        pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+        Processor processor;
+        for (int i = 0; i < CompressorEngine::numParameters; i++)
+            processor.parameters[i] = randomValue(random, (CompressorEngine::Parameter) i);
+        // half the time the pairs of a 5.1 style layout (L R C LFE Ls Rs
+        // ...), C and LFE alone, so the batch takes the channels reordered
+        int pairedWith[MultichannelCompressor::maxChannels];
+        for (int ch = 0; ch < numChannels; ch++) {
+            const int slot = ch % 6;
+            const int partner = slot == 2 || slot == 3 ? -1 : ch + (slot % 2 == 0 ? 1 : -1);
+            pairedWith[ch] = partner < numChannels ? partner : -1;
+        }
+        processor.prepareToPlay(sampleRate, maxBlockSize, numChannels, random.chance(0.5) ? pairedWith : nullptr);
+        processor.compressor.getEngine().setGainRampShape(random.chance(0.5) ? CompressorEngine::RampShape::linear
+                                                             : CompressorEngine::RampShape::exponential);
+
+        int numKeyChannels = 0;
+        for (blockIndex = 0; blockIndex < options.blocks; blockIndex++) {
+            // the host and message threads, between blocks
+            if (random.chance(0.2)) {
+                const int changes = 1 + random.below(4);
+                for (int c = 0; c < changes; c++) {
+                    const auto param = (CompressorEngine::Parameter) random.below(CompressorEngine::numParameters);
+                    processor.parameters[param] = randomValue(random, param);
+                }
+                processor.parametersChanged = true;
+            }
+            if (random.chance(0.01))
+                numKeyChannels = random.below(3);
+            if (random.chance(0.01))
+                processor.telemetryEnabled = !processor.telemetryEnabled;
+            if (random.chance(0.01))
+                processor.loadMonitor.setEnabled(!processor.loadMonitor.isEnabled());
+            if (random.chance(0.01))
+                processor.compressor.getEngine().setFastPathEnabled(random.chance(0.5));
+            BlockTelemetry telemetry;
+            while (processor.telemetryQueue.pop(telemetry)) {}
+            if (random.chance(0.01))
+                processor.loadMonitor.getStats();
+
+            // mostly full blocks, sometimes short or empty ones
+            const int numSamples = random.chance(0.7) ? maxBlockSize : random.below(maxBlockSize + 1);
+            fillInput(random, channels.data(), numChannels, numSamples, level);
+            fillInput(random, keyChannels, 2, numSamples, keyLevel);
+
+            // automation points inside the block, as the C API hands them over
+            const int timedChanges = random.chance(0.05) ? 1 + random.below(8) : 0;
+            CompressorEngine::Parameter timedParams[8];
+            float timedValues[8];
+            int timedOffsets[8];
+            for (int c = 0; c < timedChanges; c++) {
+                timedParams[c] = (CompressorEngine::Parameter) random.below(CompressorEngine::numParameters);
+                timedValues[c] = randomValue(random, timedParams[c]);
+                timedOffsets[c] = random.below(2*maxBlockSize);
+            }
+
+            AudioBlockScope scope;
+            for (int c = 0; c < timedChanges; c++)
+                processor.compressor.setParameter(timedParams[c], timedValues[c], timedOffsets[c]);
+            processor.processBlock(channels.data(), (const Sample* const*) keyChannels, numKeyChannels, numSamples);
+
+            if (blockIndex == options.blocks/2) {
+                if (options.inject == "malloc") {
+                    void* volatile p = std::malloc(16);
+                    std::free(p);
+                } else if (options.inject == "new") {
+                    delete new std::vector<float>(16);
+                } else if (options.inject == "lock") {
+                    pthread_mutex_lock(&mutex);
+                    pthread_mutex_unlock(&mutex);
+                } else if (options.inject == "write") {
+                    (void) !write(1, "", 0);
+                } else if (options.inject == "sleep") {
+                    usleep(1);
+                }
+            }
+        }
+    }
+
+    void printUsage() {
+        std::printf("usage: RealtimeCheck [options]\n"
+                    "  --blocks N        processBlock calls per case (default: 2000)\n"
+                    "  --seed N          random seed (default: 1)\n"
+                    "  --inject WHAT     commit a violation to check the check: malloc, new, lock,\n"
+                    "                    write or sleep (the exit code is then 1)\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "--blocks" && hasValue) {
+            options.blocks = std::max(1L, std::atol(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--inject" && hasValue) {
+            options.inject = argv[++i];
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            printUsage();
+            return 1;
+        }
+    }
+    seed = options.seed;
+
+    // backtrace() loads its unwinder (and allocates) the first time, and
+    // the mutex functions are looked up
+    void* frames[4];
+    backtrace(frames, 4);
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_lock(&mutex);
+    pthread_mutex_unlock(&mutex);
+    if (pthread_mutex_trylock(&mutex) == 0)
+        pthread_mutex_unlock(&mutex);
+
+    const double sampleRates[] = { 44100, 48000, 96000, 192000 };
+    const int blockSizes[] = { 1, 32, 512, 2048 };
+    const int channelCounts[] = { 2, 1, 6, 2, 12, 16 }; // mono .. 3rd order ambisonics, a case each in turn
+    int numCases = 0;
+    for (double sampleRate : sampleRates) {
+        for (int blockSize : blockSizes) {
+            for (int precision = 0; precision < 2; precision++) {
+                const int numChannels = channelCounts[numCases%6];
+                char name[64];
+                std::snprintf(name, sizeof(name), "%s %.0f Hz, block %d, %d ch", precision == 0 ? "float" : "double",
+                              sampleRate, blockSize, numChannels);
+                std::printf("%-40s", name);
+                std::fflush(stdout);
+                if (precision == 0)
+                    runCase<float>(options, sampleRate, blockSize, numChannels, name);
+                else
+                    runCase<double>(options, sampleRate, blockSize, numChannels, name);
+                std::printf(" %ld blocks ok\n", options.blocks);
+                numCases++;
+            }
+        }
+    }
+
+    if (!options.inject.empty()) {
+        std::printf("--inject %s was not caught\n", options.inject.c_str());
+        return 2;
+    }
+    std::printf("%d cases, no allocation, lock or blocking syscall in processBlock\n", numCases);
+    return 0;
+}
@@ -0,0 +1,467 @@
+/*
+  ==============================================================================
+
+    WavFile.cpp
+    Created: 16 Oct 2026 4:20:37pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "WavFile.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+ #define WAV_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+ #define WAV_NEON 1
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    const uint16_t formatPcm = 1;
+    const uint16_t formatFloat = 3;
+    const uint16_t formatExtensible = 0xfffe;
+    const uint32_t sizeUnknown = 0xffffffff; // RF64: the real size is in ds64
+
+    uint16_t readU16(const uint8_t* p) { return (uint16_t) (p[0] | (p[1] << 8)); }
+    uint32_t readU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24); }
+    uint64_t readU64(const uint8_t* p) { return readU32(p) | ((uint64_t) readU32(p + 4) << 32); }
+
+    void writeU16(std::vector<uint8_t>& out, uint16_t v) {
+        out.push_back(v & 0xff);
+        out.push_back(v >> 8);
+    }
+
+    void writeU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; i++)
+            out.push_back((v >> (8*i)) & 0xff);
+    }
+
+    void writeU64(std::vector<uint8_t>& out, uint64_t v) {
+        writeU32(out, (uint32_t) v);
+        writeU32(out, (uint32_t) (v >> 32));
+    }
+
+    float decodeSample(const uint8_t* p, int bitsPerSample, bool isFloat) {
+        if (isFloat) {
+            float f;
+            std::memcpy(&f, p, 4);
+            return f;
+        }
+        switch (bitsPerSample) {
+            case 16: return (int16_t) readU16(p) / 32768.0f;
+            case 24: return ((int32_t) ((p[0] << 8) | (p[1] << 16) | ((uint32_t) p[2] << 24)) >> 8) / 8388608.0f;
+            default: return (int32_t) readU32(p) / 2147483648.0f;
+        }
+    }
+
+    void encodeSample(uint8_t* p, float x, int bitsPerSample, bool isFloat) {
+        if (isFloat) {
+            std::memcpy(p, &x, 4);
+            return;
+        }
+        x = std::min(std::max(x, -1.0f), 1.0f);
+        if (bitsPerSample == 16) {
+            int16_t v = (int16_t) std::lrint(std::min(x*32768.0f, 32767.0f));
+            p[0] = v & 0xff;
+            p[1] = (v >> 8) & 0xff;
+        } else if (bitsPerSample == 24) {
+            int32_t v = (int32_t) std::lrint(std::min(x*8388608.0f, 8388607.0f));
+            p[0] = v & 0xff;
+            p[1] = (v >> 8) & 0xff;
+            p[2] = (v >> 16) & 0xff;
+        } else {
+            int32_t v = (int32_t) std::min(std::llrint(x*2147483648.0), 2147483647LL);
+            for (int i = 0; i < 4; i++)
+                p[i] = (v >> (8*i)) & 0xff;
+        }
+    }
+
+    // vector conversions for 16 bit and float, mono and stereo, which is
+    // nearly every file. They return how many frames they did, the scalar
+    // loops below finish the rest (and do 24/32 bit, which need byte
+    // shuffles SSE2 does not have). Bit for bit the same as the scalar
+    // code: the scales are powers of two and the float -> int conversion
+    // rounds to nearest even like lrint
+#if WAV_SSE2
+    int decodeVector(const uint8_t* src, int count, const WavFormat& f, float* const* dst, int offset) {
+        int i = 0;
+        if (f.isFloat && f.numChannels == 2) {
+            for (; i + 4 <= count; i += 4) {
+                __m128 a = _mm_loadu_ps((const float*) (src + 8*i));
+                __m128 b = _mm_loadu_ps((const float*) (src + 8*i + 16));
+                _mm_storeu_ps(dst[0] + offset + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_ps(dst[1] + offset + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+        } else if (f.isFloat && f.numChannels == 1) {
+            std::memcpy(dst[0] + offset, src, (size_t) count*4);
+            i = count;
+        } else if (f.bitsPerSample == 16 && f.numChannels == 2) {
+            const __m128 scale = _mm_set1_ps(1.0f/32768.0f);
+            for (; i + 4 <= count; i += 4) {
+                __m128i v = _mm_loadu_si128((const __m128i*) (src + 4*i)); // l r l r ... as 32 bit pairs
+                __m128 l = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16));
+                __m128 r = _mm_cvtepi32_ps(_mm_srai_epi32(v, 16));
+                _mm_storeu_ps(dst[0] + offset + i, _mm_mul_ps(l, scale));
+                _mm_storeu_ps(dst[1] + offset + i, _mm_mul_ps(r, scale));
+            }
+        } else if (f.bitsPerSample == 16 && f.numChannels == 1) {
+            const __m128 scale = _mm_set1_ps(1.0f/32768.0f);
+            for (; i + 8 <= count; i += 8) {
+                __m128i v = _mm_loadu_si128((const __m128i*) (src + 2*i));
+                __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+                __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+                _mm_storeu_ps(dst[0] + offset + i, _mm_mul_ps(lo, scale));
+                _mm_storeu_ps(dst[0] + offset + i + 4, _mm_mul_ps(hi, scale));
+            }
+        }
+        return i;
+    }
+
+    int encodeVector(const float* const* src, int offset, int count, const WavFormat& f, uint8_t* dst) {
+        int i = 0;
+        if (f.isFloat && f.numChannels == 2) {
+            for (; i + 4 <= count; i += 4) {
+                __m128 l = _mm_loadu_ps(src[0] + offset + i);
+                __m128 r = _mm_loadu_ps(src[1] + offset + i);
+                _mm_storeu_ps((float*) (dst + 8*i), _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps((float*) (dst + 8*i + 16), _mm_unpackhi_ps(l, r));
+            }
+        } else if (f.isFloat && f.numChannels == 1) {
+            std::memcpy(dst, src[0] + offset, (size_t) count*4);
+            i = count;
+        } else if (f.bitsPerSample == 16 && f.numChannels <= 2) {
+            const __m128 low = _mm_set1_ps(-1.0f);
+            const __m128 high = _mm_set1_ps(1.0f);
+            const __m128 scale = _mm_set1_ps(32768.0f);
+            const __m128 largest = _mm_set1_ps(32767.0f);
+            auto toInt = [&](const float* p) {
+                __m128 x = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p), low), high);
+                return _mm_cvtps_epi32(_mm_min_ps(_mm_mul_ps(x, scale), largest));
+            };
+            if (f.numChannels == 2) {
+                for (; i + 4 <= count; i += 4) {
+                    __m128i l = toInt(src[0] + offset + i);
+                    __m128i r = toInt(src[1] + offset + i);
+                    __m128i v = _mm_unpacklo_epi16(_mm_packs_epi32(l, l), _mm_packs_epi32(r, r));
+                    _mm_storeu_si128((__m128i*) (dst + 4*i), v);
+                }
+            } else {
+                for (; i + 8 <= count; i += 8) {
+                    __m128i v = _mm_packs_epi32(toInt(src[0] + offset + i), toInt(src[0] + offset + i + 4));
+                    _mm_storeu_si128((__m128i*) (dst + 2*i), v);
+                }
+            }
+        }
+        return i;
+    }
+#elif WAV_NEON
+    int decodeVector(const uint8_t* src, int count, const WavFormat& f, float* const* dst, int offset) {
+        int i = 0;
+        if (f.isFloat && f.numChannels == 2) {
+            for (; i + 4 <= count; i += 4) {
+                float32x4x2_t v = vld2q_f32((const float*) (src + 8*i));
+                vst1q_f32(dst[0] + offset + i, v.val[0]);
+                vst1q_f32(dst[1] + offset + i, v.val[1]);
+            }
+        } else if (f.isFloat && f.numChannels == 1) {
+            std::memcpy(dst[0] + offset, src, (size_t) count*4);
+            i = count;
+        } else if (f.bitsPerSample == 16 && f.numChannels == 2) {
+            for (; i + 4 <= count; i += 4) {
+                int16x4x2_t v = vld2_s16((const int16_t*) (src + 4*i));
+                vst1q_f32(dst[0] + offset + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v.val[0])), 1.0f/32768.0f));
+                vst1q_f32(dst[1] + offset + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v.val[1])), 1.0f/32768.0f));
+            }
+        } else if (f.bitsPerSample == 16 && f.numChannels == 1) {
+            for (; i + 4 <= count; i += 4) {
+                int16x4_t v = vld1_s16((const int16_t*) (src + 2*i));
+                vst1q_f32(dst[0] + offset + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v)), 1.0f/32768.0f));
+            }
+        }
+        return i;
+    }
+
+    int encodeVector(const float* const* src, int offset, int count, const WavFormat& f, uint8_t* dst) {
+        int i = 0;
+        if (f.isFloat && f.numChannels == 2) {
+            for (; i + 4 <= count; i += 4) {
+                float32x4x2_t v = { { vld1q_f32(src[0] + offset + i), vld1q_f32(src[1] + offset + i) } };
+                vst2q_f32((float*) (dst + 8*i), v);
+            }
+        } else if (f.isFloat && f.numChannels == 1) {
+            std::memcpy(dst, src[0] + offset, (size_t) count*4);
+            i = count;
+        } else if (f.bitsPerSample == 16 && f.numChannels <= 2) {
+            auto toInt = [](const float* p) {
+                float32x4_t x = vminq_f32(vmaxq_f32(vld1q_f32(p), vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+                return vmovn_s32(vcvtnq_s32_f32(vminq_f32(vmulq_n_f32(x, 32768.0f), vdupq_n_f32(32767.0f))));
+            };
+            if (f.numChannels == 2) {
+                for (; i + 4 <= count; i += 4) {
+                    int16x4x2_t v = { { toInt(src[0] + offset + i), toInt(src[1] + offset + i) } };
+                    vst2_s16((int16_t*) (dst + 4*i), v);
+                }
+            } else {
+                for (; i + 4 <= count; i += 4)
+                    vst1_s16((int16_t*) (dst + 2*i), toInt(src[0] + offset + i));
+            }
+        }
+        return i;
+    }
+#else
+    int decodeVector(const uint8_t*, int, const WavFormat&, float* const*, int) { return 0; }
+    int encodeVector(const float* const*, int, int, const WavFormat&, uint8_t*) { return 0; }
+#endif
+
+    // count frames at src into dst[ch] + offset
+    void decodeFrames(const uint8_t* src, int count, const WavFormat& f, int blockAlign, float* const* dst, int offset) {
+        const int bytesPerSample = f.bitsPerSample/8;
+        for (int i = decodeVector(src, count, f, dst, offset); i < count; i++) {
+            const uint8_t* p = src + (size_t) i*blockAlign;
+            for (int ch = 0; ch < f.numChannels; ch++)
+                dst[ch][offset + i] = decodeSample(p + ch*bytesPerSample, f.bitsPerSample, f.isFloat);
+        }
+    }
+
+    void encodeFrames(const float* const* src, int offset, int count, const WavFormat& f, int blockAlign, uint8_t* dst) {
+        const int bytesPerSample = f.bitsPerSample/8;
+        for (int i = encodeVector(src, offset, count, f, dst); i < count; i++) {
+            uint8_t* p = dst + (size_t) i*blockAlign;
+            for (int ch = 0; ch < f.numChannels; ch++)
+                encodeSample(p + ch*bytesPerSample, src[ch][offset + i], f.bitsPerSample, f.isFloat);
+        }
+    }
+
+    // finds fmt and data in a RIFF, RF64 or BW64 file
+    bool parseHeader(const uint8_t* file, size_t fileSize, const std::string& path, WavFormat& format,
+                     int& blockAlign, size_t& dataOffset, uint64_t& dataSize, std::string& error) {
+        const bool riff = fileSize >= 12 && std::memcmp(file, "RIFF", 4) == 0;
+        const bool rf64 = fileSize >= 12 && (std::memcmp(file, "RF64", 4) == 0 || std::memcmp(file, "BW64", 4) == 0);
+        if (!(riff || rf64) || std::memcmp(file + 8, "WAVE", 4) != 0) {
+            error = path + " is not a WAV file";
+            return false;
+        }
+
+        bool haveFormat = false;
+        uint16_t formatTag = 0;
+        uint64_t ds64DataSize = 0;
+        for (size_t pos = 12; pos + 8 <= fileSize;) {
+            const uint8_t* chunk = file + pos;
+            const uint32_t chunkSize = readU32(chunk + 4);
+            const uint8_t* body = chunk + 8;
+            const size_t available = fileSize - (pos + 8);
+
+            if (std::memcmp(chunk, "ds64", 4) == 0) {
+                if (chunkSize < 24 || available < 24) {
+                    error = path + ": bad ds64 chunk";
+                    return false;
+                }
+                ds64DataSize = readU64(body + 8);
+            } else if (std::memcmp(chunk, "fmt ", 4) == 0) {
+                if (chunkSize < 16 || available < 16) {
+                    error = path + ": bad fmt chunk";
+                    return false;
+                }
+                formatTag = readU16(body);
+                format.numChannels = readU16(body + 2);
+                format.sampleRate = readU32(body + 4);
+                blockAlign = readU16(body + 12);
+                format.bitsPerSample = readU16(body + 14);
+                if (formatTag == formatExtensible && chunkSize >= 26 && available >= 26)
+                    formatTag = readU16(body + 24); // first two bytes of the sub-format GUID
+                haveFormat = true;
+            } else if (std::memcmp(chunk, "data", 4) == 0) {
+                if (!haveFormat) {
+                    error = path + ": data chunk before fmt chunk";
+                    return false;
+                }
+                format.isFloat = formatTag == formatFloat;
+                const bool supported = format.numChannels > 0 && blockAlign == format.numChannels*format.bitsPerSample/8
+                    && ((formatTag == formatPcm && (format.bitsPerSample == 16 || format.bitsPerSample == 24 || format.bitsPerSample == 32))
+                        || (format.isFloat && format.bitsPerSample == 32));
+                if (!supported) {
+                    error = path + ": only 16/24/32 bit PCM and 32 bit float are supported";
+                    return false;
+                }
+                dataOffset = pos + 8;
+                dataSize = std::min<uint64_t>(rf64 && chunkSize == sizeUnknown ? ds64DataSize : chunkSize, available);
+                return true;
+            }
+            pos += 8 + (size_t) chunkSize + (chunkSize & 1);
+        }
+
+        error = path + ": no data chunk";
+        return false;
+    }
+}
+
+//==============================================================================
+MappedWavReader::~MappedWavReader() {
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+}
+
+bool MappedWavReader::open(const std::string& path, std::string& error) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0)
+            ::close(fd);
+        error = "cannot open " + path;
+        return false;
+    }
+    if (info.st_size < 12) {
+        ::close(fd);
+        error = path + " is not a WAV file";
+        return false;
+    }
+
+    mappingSize = (size_t) info.st_size;
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        error = "cannot map " + path;
+        return false;
+    }
+    posix_madvise(mapping, mappingSize, POSIX_MADV_SEQUENTIAL);
+
+    size_t dataOffset = 0;
+    uint64_t dataSize = 0;
+    if (!parseHeader((const uint8_t*) mapping, mappingSize, path, format, blockAlign, dataOffset, dataSize, error))
+        return false;
+    data = (const uint8_t*) mapping + dataOffset;
+    numFrames = (int64_t) (dataSize/blockAlign);
+    return true;
+}
+
+void MappedWavReader::read(int64_t start, int count, float* const* channels) const {
+    const int64_t first = std::min(std::max<int64_t>(start, 0), start + count);
+    const int64_t last = std::max(std::min(start + count, numFrames), first);
+    for (int ch = 0; ch < format.numChannels; ch++) {
+        std::fill(channels[ch], channels[ch] + (first - start), 0.0f);
+        std::fill(channels[ch] + (last - start), channels[ch] + count, 0.0f);
+    }
+    if (last > first)
+        decodeFrames(data + first*blockAlign, (int) (last - first), format, blockAlign, channels, (int) (first - start));
+}
+
+//==============================================================================
+MappedWavWriter::~MappedWavWriter() {
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+}
+
+bool MappedWavWriter::create(const std::string& path, const WavFormat& f, int64_t frames, std::string& error) {
+    format = f;
+    numFrames = frames;
+    blockAlign = format.numChannels*format.bitsPerSample/8;
+    const uint64_t dataSize = (uint64_t) numFrames*blockAlign;
+    const uint64_t pad = dataSize & 1;
+    const bool rf64 = 36 + dataSize + pad > sizeUnknown;
+
+    std::vector<uint8_t> header;
+    const char* id = rf64 ? "RF64" : "RIFF";
+    header.insert(header.end(), id, id + 4);
+    writeU32(header, rf64 ? sizeUnknown : (uint32_t) (36 + dataSize + pad));
+    header.insert(header.end(), { 'W', 'A', 'V', 'E' });
+    if (rf64) {
+        header.insert(header.end(), { 'd', 's', '6', '4' });
+        writeU32(header, 28);
+        writeU64(header, 72 + dataSize + pad); // RIFF size: everything after the first 8 bytes
+        writeU64(header, dataSize);
+        writeU64(header, (uint64_t) numFrames);
+        writeU32(header, 0); // no table
+    }
+    header.insert(header.end(), { 'f', 'm', 't', ' ' });
+    writeU32(header, 16);
+    writeU16(header, format.isFloat ? formatFloat : formatPcm);
+    writeU16(header, (uint16_t) format.numChannels);
+    writeU32(header, (uint32_t) format.sampleRate);
+    writeU32(header, (uint32_t) (format.sampleRate*blockAlign));
+    writeU16(header, (uint16_t) blockAlign);
+    writeU16(header, (uint16_t) format.bitsPerSample);
+    header.insert(header.end(), { 'd', 'a', 't', 'a' });
+    writeU32(header, rf64 ? sizeUnknown : (uint32_t) dataSize);
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    mappingSize = header.size() + dataSize + pad;
+    if (fd < 0 || ftruncate(fd, (off_t) mappingSize) != 0) {
+        if (fd >= 0)
+            ::close(fd);
+        error = "cannot write " + path;
+        return false;
+    }
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        error = "cannot map " + path;
+        return false;
+    }
+
+    std::memcpy(mapping, header.data(), header.size());
+    data = (uint8_t*) mapping + header.size();
+    return true;
+}
+
+void MappedWavWriter::write(int64_t start, int count, const float* const* channels) {
+    const int64_t first = std::min(std::max<int64_t>(start, 0), start + count);
+    const int64_t last = std::max(std::min(start + count, numFrames), first);
+    if (last > first)
+        encodeFrames(channels, (int) (first - start), (int) (last - first), format, blockAlign, data + first*blockAlign);
+}
+
+bool MappedWavWriter::close(std::string& error) {
+    if (mapping == nullptr)
+        return true;
+    const bool ok = munmap(mapping, mappingSize) == 0;
+    mapping = nullptr;
+    if (!ok)
+        error = "cannot finish writing the output";
+    return ok;
+}
+
+//==============================================================================
+bool readWavFile(const std::string& path, WavFile& wav, std::string& error) {
+    MappedWavReader reader;
+    if (!reader.open(path, error))
+        return false;
+    if (reader.getNumFrames() > INT_MAX) {
+        error = path + " is too long to load at once";
+        return false;
+    }
+
+    static_cast<WavFormat&>(wav) = reader.getFormat();
+    const int numFrames = (int) reader.getNumFrames();
+    wav.channels.assign(wav.numChannels, std::vector<float>(numFrames));
+    std::vector<float*> channels;
+    for (auto& channel : wav.channels)
+        channels.push_back(channel.data());
+    reader.read(0, numFrames, channels.data());
+    return true;
+}
+
+bool writeWavFile(const std::string& path, const WavFile& wav, std::string& error) {
+    MappedWavWriter writer;
+    if (!writer.create(path, wav, wav.getNumFrames(), error))
+        return false;
+    std::vector<const float*> channels;
+    for (const auto& channel : wav.channels)
+        channels.push_back(channel.data());
+    writer.write(0, wav.getNumFrames(), channels.data());
+    return writer.close(error);
+}
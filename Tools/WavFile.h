@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    WavFile.h
+    Created: 16 Oct 2026 4:20:37pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//==============================================================================
+/**
+ Minimal WAV reader/writer for the command line tools, so they do not need
+ JUCE's audio format classes. Handles PCM 16/24/32 bit and 32 bit float,
+ including WAVE_FORMAT_EXTENSIBLE headers, and RF64/BW64 files over 4 GB.
+ Samples are held planar.
+*/
+struct WavFormat
+{
+    int numChannels = 0;
+    double sampleRate = 0;
+    int bitsPerSample = 16;
+    bool isFloat = false;
+};
+
+struct WavFile : WavFormat
+{
+    std::vector<std::vector<float>> channels; // [channel][frame]
+
+    int getNumFrames() const { return channels.empty() ? 0 : (int) channels[0].size(); }
+};
+
+// both return false and fill in error on failure
+bool readWavFile(const std::string& path, WavFile& wav, std::string& error);
+bool writeWavFile(const std::string& path, const WavFile& wav, std::string& error);
+
+//==============================================================================
+/**
+ Memory-mapped access for files too big to hold as floats: read() converts
+ any range of frames from the mapped file straight into planar buffers, so
+ streaming a file costs no copies but the conversion (SSE2/NEON for 16 bit
+ and float, mono and stereo). The data is paged in by the OS as it is
+ read, and the mapping is hinted for sequential access.
+*/
+class MappedWavReader
+{
+public:
+    MappedWavReader() = default;
+    ~MappedWavReader();
+    MappedWavReader(const MappedWavReader&) = delete;
+    MappedWavReader& operator=(const MappedWavReader&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+
+    const WavFormat& getFormat() const { return format; }
+    int64_t getNumFrames() const { return numFrames; }
+
+    // frames [start, start + count) into channels[0..numChannels), zeros
+    // for frames past the end (or before 0). Safe to call from several
+    // threads at once
+    void read(int64_t start, int count, float* const* channels) const;
+
+private:
+    WavFormat format;
+    int64_t numFrames = 0;
+    int blockAlign = 0;
+    const uint8_t* data = nullptr;  // first frame
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+};
+
+/**
+ Writes a file of known length through a shared mapping. create() sizes
+ the file and writes the header (RF64 once the data passes 4 GB), write()
+ converts planar floats into any range of it; different threads may write
+ different ranges. Nothing is flushed until close().
+*/
+class MappedWavWriter
+{
+public:
+    MappedWavWriter() = default;
+    ~MappedWavWriter();
+    MappedWavWriter(const MappedWavWriter&) = delete;
+    MappedWavWriter& operator=(const MappedWavWriter&) = delete;
+
+    bool create(const std::string& path, const WavFormat& format, int64_t numFrames, std::string& error);
+
+    // frames [start, start + count) from channels[0..numChannels), clipped
+    // to the file's length
+    void write(int64_t start, int count, const float* const* channels);
+
+    bool close(std::string& error);
+
+private:
+    WavFormat format;
+    int64_t numFrames = 0;
+    int blockAlign = 0;
+    uint8_t* data = nullptr;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+};
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.cpp
+    Created: 16 Oct 2026 4:58:02pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    // which pool/worker the calling thread belongs to, if any
+    thread_local const WorkStealingPool* currentPool = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int numThreads) {
+    numThreads = std::max(1, numThreads);
+    for (int i = 0; i < numThreads; i++)
+        workers.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < numThreads; i++)
+        threads.emplace_back([this, i] { run(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(wakeLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+int WorkStealingPool::getDefaultNumThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    const int index = currentPool == this ? currentWorker
+                                          : (int) (nextWorker++ % workers.size());
+    pendingTasks++;
+    {
+        std::lock_guard<std::mutex> guard(workers[index]->lock);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // queuedTasks changes under wakeLock so a worker can't miss the wake up
+        std::lock_guard<std::mutex> guard(wakeLock);
+        queuedTasks++;
+    }
+    wakeUp.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> guard(wakeLock);
+    allDone.wait(guard, [this] { return pendingTasks == 0; });
+}
+
+bool WorkStealingPool::takeTask(int index, std::function<void()>& task) {
+    // own queue, newest first
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // steal the oldest task of another worker
+    const int numWorkers = (int) workers.size();
+    for (int i = 1; i < numWorkers; i++) {
+        Worker& victim = *workers[(index + i) % numWorkers];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int index) {
+    currentPool = this;
+    currentWorker = index;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(wakeLock);
+            wakeUp.wait(guard, [this] { return stopping || queuedTasks > 0; });
+            if (stopping && queuedTasks == 0)
+                return;
+        }
+
+        std::function<void()> task;
+        if (!takeTask(index, task))
+            continue; // somebody else got there first
+
+        queuedTasks--;
+        task();
+
+        if (--pendingTasks == 0) {
+            std::lock_guard<std::mutex> guard(wakeLock);
+            allDone.notify_all();
+        }
+    }
+}
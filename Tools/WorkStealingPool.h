@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.h
+    Created: 16 Oct 2026 4:58:02pm
+    Author:  Coleman Jenkins
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+/**
+ Thread pool where every worker owns a task queue. Workers take their own
+ newest task first and, when they run dry, steal the oldest task from
+ another worker. Tasks submitted from inside a task go to the submitting
+ worker's queue, other submissions are spread round robin.
+*/
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int numThreads);
+    ~WorkStealingPool();
+
+    void submit(std::function<void()> task);
+
+    // blocks until every submitted task has finished
+    void wait();
+
+    int getNumThreads() const { return (int) workers.size(); }
+
+    // 0 for std::thread::hardware_concurrency() == 0
+    static int getDefaultNumThreads();
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex wakeLock;
+    std::condition_variable wakeUp;
+    std::condition_variable allDone;
+    std::atomic<int> queuedTasks { 0 };  // submitted, not started yet
+    std::atomic<int> pendingTasks { 0 }; // submitted, not finished yet
+    std::atomic<unsigned> nextWorker { 0 };
+    bool stopping = false;
+
+    void run(int index);
+    bool takeTask(int index, std::function<void()>& task);
+};